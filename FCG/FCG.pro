@@ -1,7 +1,10 @@
-TEMPLATE = subdirs
-
-SUBDIRS += \
-    FCGClient \
-    FCGServer
-QT += core gui widgets
-CONFIG += c++17
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    FCGBench \
+    FCGClient \
+    FCGGateway \
+    FCGServer \
+    FCGSim
+QT += core gui widgets
+CONFIG += c++17
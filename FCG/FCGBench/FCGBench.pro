@@ -0,0 +1,49 @@
+QT += core network testlib
+QT -= gui
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+# You can make your code fail to compile if it uses deprecated APIs.
+# In order to do so, uncomment the following line.
+#DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
+
+INCLUDEPATH += ../FCGServer
+
+SOURCES += \
+    ../FCGClient/controller/gameclock.cpp \
+    ../FCGClient/controller/heartbeat.cpp \
+    ../FCGClient/model/gamemodel.cpp \
+    ../FCGClient/model/gamerules.cpp \
+    ../FCGClient/model/gamestate.cpp \
+    ../FCGClient/model/protocol.cpp \
+    ../FCGServer/expectimaxsearch.cpp \
+    ../FCGServer/handoff.cpp \
+    ../FCGServer/montecarlobot.cpp \
+    ../FCGServer/ratelimiter.cpp \
+    ../FCGServer/servercontroller.cpp \
+    alloccounter.cpp \
+    boardsamples.cpp \
+    main.cpp \
+    rulesbench.cpp \
+    searchbench.cpp \
+    serializationbench.cpp
+
+HEADERS += \
+    ../FCGClient/controller/gameclock.h \
+    ../FCGClient/controller/heartbeat.h \
+    ../FCGClient/model/gamemodel.h \
+    ../FCGClient/model/gamerules.h \
+    ../FCGClient/model/gamestate.h \
+    ../FCGClient/model/protocol.h \
+    ../FCGServer/expectimaxsearch.h \
+    ../FCGServer/handoff.h \
+    ../FCGServer/montecarlobot.h \
+    ../FCGServer/ratelimiter.h \
+    ../FCGServer/servercontroller.h \
+    alloccounter.h \
+    benchreport.h \
+    boardsamples.h \
+    rulesbench.h \
+    searchbench.h \
+    serializationbench.h
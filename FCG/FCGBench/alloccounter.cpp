@@ -0,0 +1,75 @@
+#include "alloccounter.h"
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <stdlib.h>
+
+static std::atomic<quint64> allocationCount{0};
+
+quint64 AllocCounter::count()
+{
+    return allocationCount.load(std::memory_order_relaxed);
+}
+
+#if defined(__GLIBC__)
+
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+
+void *malloc(size_t size) __THROW
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) __THROW
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size) __THROW
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(ptr, size);
+}
+}
+
+#else
+
+void *operator new(std::size_t size)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void *ptr = ::malloc(size ? size : 1))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size)
+{
+    return ::operator new(size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+    ::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    ::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept
+{
+    ::free(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t) noexcept
+{
+    ::free(ptr);
+}
+
+#endif
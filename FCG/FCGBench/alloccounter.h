@@ -0,0 +1,14 @@
+#ifndef ALLOCCOUNTER_H
+#define ALLOCCOUNTER_H
+
+#include <QtGlobal>
+
+// 统计进程内的堆分配次数，用于输出 allocs/op。
+// glibc 下拦截 malloc 系列（QList/QString 的缓冲区也走 malloc），其他平台只统计 operator new。
+class AllocCounter
+{
+public:
+    static quint64 count();
+};
+
+#endif // ALLOCCOUNTER_H
@@ -0,0 +1,33 @@
+#ifndef BENCHREPORT_H
+#define BENCHREPORT_H
+
+#include <QElapsedTimer>
+#include <QLoggingCategory>
+#include <QString>
+#include "alloccounter.h"
+
+Q_DECLARE_LOGGING_CATEGORY(lcBench)
+
+// QBENCHMARK 只给出每次迭代的墙钟时间，这里额外按固定次数跑一遍，
+// 输出 ns/op 和 allocs/op，方便不同优化之间横向对比。
+template <typename Op>
+void reportPerOp(const QString &name, int iterations, Op &&op)
+{
+    op(0); // 预热，避免首次分配计入统计
+
+    const quint64 allocBefore = AllocCounter::count();
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < iterations; ++i) {
+        op(i);
+    }
+    const qint64 elapsedNs = timer.nsecsElapsed();
+    const quint64 allocs = AllocCounter::count() - allocBefore;
+
+    qCInfo(lcBench).noquote() << QString("%1: %2 ns/op, %3 allocs/op")
+                                     .arg(name, -40)
+                                     .arg(double(elapsedNs) / iterations, 0, 'f', 1)
+                                     .arg(double(allocs) / iterations, 0, 'f', 2);
+}
+
+#endif // BENCHREPORT_H
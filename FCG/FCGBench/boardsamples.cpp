@@ -0,0 +1,182 @@
+#include "boardsamples.h"
+#include "servercontroller.h"
+
+BoardSamples::BoardSamples(ServerController &ctrl, quint32 seed)
+    : controller(ctrl), rng(seed)
+{
+    for (int clientId = 1; clientId <= 4; ++clientId) {
+        routes.insert(clientId, buildRoute(clientId));
+    }
+}
+
+QList<int> BoardSamples::buildRoute(int clientId)
+{
+    QList<int> route;
+    int pos = controller.getStartTile(clientId);
+    route.append(pos);
+    while (!controller.isFinalEnd(clientId, pos)) {
+        pos = controller.isExitRingPosition(clientId, pos)
+                  ? controller.getNextOnExitPath(clientId, pos)
+                  : controller.getNextPosition(clientId, pos);
+        route.append(pos);
+    }
+    return route;
+}
+
+int BoardSamples::exitIndex(int clientId) const
+{
+    const QList<int> &route = routes[clientId];
+    for (int i = 0; i < route.size(); ++i) {
+        if (controller.isExitRingPosition(clientId, route[i])) return i;
+    }
+    return route.size() - 1;
+}
+
+QMap<int, QList<int>> BoardSamples::randomBoard()
+{
+    QMap<int, QList<int>> tiles;
+    for (int i = 1; i <= 96; ++i) {
+        tiles.insert(i, QList<int>());
+    }
+
+    for (int clientId = 1; clientId <= 4; ++clientId) {
+        const QList<int> &route = routes[clientId];
+        for (int planeId = 1; planeId <= 4; ++planeId) {
+            const int globalPlaneId = (clientId - 1) * 4 + planeId;
+            const int airportTile = controller.getAirportTile(clientId, planeId);
+            const int roll = rng.bounded(100);
+            if (roll < 30) {
+                tiles[airportTile].append(globalPlaneId);            // 还在机场
+            } else if (roll < 40) {
+                tiles[airportTile].append(100 + globalPlaneId);      // 已到达终点
+            } else {
+                const int index = rng.bounded(route.size() - 1);     // 在路线上（不含终点格）
+                tiles[route[index]].append(globalPlaneId);
+            }
+        }
+    }
+    return tiles;
+}
+
+void BoardSamples::placePlane(QMap<int, QList<int>> &tiles, int globalPlaneId, int tileId)
+{
+    for (auto it = tiles.begin(); it != tiles.end(); ++it) {
+        it.value().removeAll(globalPlaneId);
+        it.value().removeAll(100 + globalPlaneId);
+    }
+    tiles[tileId].append(globalPlaneId);
+}
+
+MoveCase BoardSamples::caseAtRouteIndex(int clientId, int routeIndex, int dice)
+{
+    MoveCase c;
+    c.tiles = randomBoard();
+    c.clientId = clientId;
+    c.planeId = rng.bounded(4) + 1;
+    c.dice = dice;
+    placePlane(c.tiles, (clientId - 1) * 4 + c.planeId, routes[clientId].at(routeIndex));
+    return c;
+}
+
+QList<MoveCase> BoardSamples::takeOffCases(int count)
+{
+    QList<MoveCase> cases;
+    for (int i = 0; i < count; ++i) {
+        MoveCase c;
+        c.tiles = randomBoard();
+        c.clientId = rng.bounded(4) + 1;
+        c.planeId = rng.bounded(4) + 1;
+        c.dice = rng.bounded(2) + 5;
+        placePlane(c.tiles, (c.clientId - 1) * 4 + c.planeId, controller.getAirportTile(c.clientId, c.planeId));
+        cases.append(c);
+    }
+    return cases;
+}
+
+QList<MoveCase> BoardSamples::normalStepCases(int count)
+{
+    QList<MoveCase> cases;
+    for (int i = 0; i < count; ++i) {
+        const int clientId = rng.bounded(4) + 1;
+        const int dice = rng.bounded(6) + 1;
+        // 落点仍在外圈（不进入终点通道）
+        const int index = rng.bounded(exitIndex(clientId) - dice + 1);
+        cases.append(caseAtRouteIndex(clientId, index, dice));
+    }
+    return cases;
+}
+
+QList<MoveCase> BoardSamples::exitPathCases(int count)
+{
+    QList<MoveCase> cases;
+    for (int i = 0; i < count; ++i) {
+        const int clientId = rng.bounded(4) + 1;
+        const int dice = rng.bounded(6) + 1;
+        const int exitIdx = exitIndex(clientId);
+        const int endIdx = routes[clientId].size() - 1;
+        // 起点在转入通道之前，落点在通道内且不越过终点
+        const int lowest = qMax(0, exitIdx - dice + 1);
+        const int highest = qMin(exitIdx, endIdx - dice);
+        const int index = lowest + rng.bounded(highest - lowest + 1);
+        cases.append(caseAtRouteIndex(clientId, index, dice));
+    }
+    return cases;
+}
+
+QList<MoveCase> BoardSamples::bounceBackCases(int count)
+{
+    QList<MoveCase> cases;
+    for (int i = 0; i < count; ++i) {
+        const int clientId = rng.bounded(4) + 1;
+        const int endIdx = routes[clientId].size() - 1;
+        const int exitIdx = exitIndex(clientId);
+        // 已在终点通道内，骰子点数超过剩余步数，需要回退
+        const int index = exitIdx + 1 + rng.bounded(endIdx - exitIdx - 1);
+        const int remaining = endIdx - index;
+        const int dice = remaining + 1 + rng.bounded(6 - remaining);
+        cases.append(caseAtRouteIndex(clientId, index, dice));
+    }
+    return cases;
+}
+
+QList<MoveCase> BoardSamples::flyCases(int count)
+{
+    QList<MoveCase> cases;
+    for (int i = 0; i < count; ++i) {
+        const int clientId = rng.bounded(4) + 1;
+        const QList<int> &route = routes[clientId];
+        QList<int> candidates;
+        for (int index = 0; index < route.size(); ++index) {
+            if (controller.isTileColorMatchesClient(clientId, route[index])
+                && !controller.isExitRingPosition(clientId, route[index])) {
+                candidates.append(index);
+            }
+        }
+        cases.append(caseAtRouteIndex(clientId, candidates.at(rng.bounded(candidates.size())), 0));
+    }
+    return cases;
+}
+
+QList<MoveCase> BoardSamples::collisionCases(int count)
+{
+    QList<MoveCase> cases;
+    for (int i = 0; i < count; ++i) {
+        MoveCase c;
+        c.tiles = randomBoard();
+        c.clientId = rng.bounded(4) + 1;
+        c.planeId = rng.bounded(4) + 1;
+        const int tileId = 21 + rng.bounded(52);
+        placePlane(c.tiles, (c.clientId - 1) * 4 + c.planeId, tileId);
+
+        // 在同一格再放1~3架其他颜色的飞机
+        const int enemies = rng.bounded(3) + 1;
+        for (int e = 0; e < enemies; ++e) {
+            const int otherClient = (c.clientId + rng.bounded(3)) % 4 + 1;
+            const int otherPlane = (otherClient - 1) * 4 + rng.bounded(4) + 1;
+            placePlane(c.tiles, otherPlane, tileId);
+        }
+        c.tileId = tileId;
+        cases.append(c);
+    }
+    return cases;
+}
@@ -0,0 +1,47 @@
+#ifndef BOARDSAMPLES_H
+#define BOARDSAMPLES_H
+
+#include <QList>
+#include <QMap>
+#include <QRandomGenerator>
+
+class ServerController;
+
+// 一次走子操作的输入：棋盘状态 + 玩家/飞机/骰子
+struct MoveCase
+{
+    QMap<int, QList<int>> tiles;
+    int clientId = 1;
+    int planeId = 1;
+    int dice = 1;
+    int tileId = 0; // 仅碰撞用例使用：发生碰撞的格子
+};
+
+// 生成随机但符合规则的4人对局棋盘，用于基准测试。
+// 路线（起点 -> 外圈 -> 终点通道）直接由 ServerController 的规则函数推出，保证与服务器一致。
+class BoardSamples
+{
+public:
+    explicit BoardSamples(ServerController &controller, quint32 seed = 20240514);
+
+    QMap<int, QList<int>> randomBoard();
+
+    QList<MoveCase> takeOffCases(int count);
+    QList<MoveCase> normalStepCases(int count);
+    QList<MoveCase> exitPathCases(int count);
+    QList<MoveCase> bounceBackCases(int count);
+    QList<MoveCase> flyCases(int count);
+    QList<MoveCase> collisionCases(int count);
+
+private:
+    ServerController &controller;
+    QRandomGenerator rng;
+    QMap<int, QList<int>> routes; // clientId -> 从起点到终点的格子序列
+
+    QList<int> buildRoute(int clientId);
+    int exitIndex(int clientId) const;
+    void placePlane(QMap<int, QList<int>> &tiles, int globalPlaneId, int tileId);
+    MoveCase caseAtRouteIndex(int clientId, int routeIndex, int dice);
+};
+
+#endif // BOARDSAMPLES_H
@@ -0,0 +1,36 @@
+#include <QCoreApplication>
+#include <QLoggingCategory>
+#include <QTest>
+#include "rulesbench.h"
+#include "searchbench.h"
+#include "serializationbench.h"
+
+Q_LOGGING_CATEGORY(lcBench, "fcg.bench")
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    // 服务器代码里大量 qDebug/qCritical 日志，会淹没被测逻辑本身的耗时，这里统一关闭，
+    // 只保留基准结果输出。
+    QLoggingCategory::setFilterRules(QStringLiteral("*.debug=false\n"
+                                                    "*.info=false\n"
+                                                    "*.warning=false\n"
+                                                    "*.critical=false\n"
+                                                    "fcg.bench.info=true"));
+
+    int status = 0;
+    {
+        RulesBench rulesBench;
+        status |= QTest::qExec(&rulesBench, argc, argv);
+    }
+    {
+        SerializationBench serializationBench;
+        status |= QTest::qExec(&serializationBench, argc, argv);
+    }
+    {
+        SearchBench searchBench;
+        status |= QTest::qExec(&searchBench, argc, argv);
+    }
+    return status;
+}
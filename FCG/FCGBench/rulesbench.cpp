@@ -0,0 +1,148 @@
+#include "rulesbench.h"
+#include "benchreport.h"
+#include "servercontroller.h"
+#include <QTest>
+
+static const int SAMPLE_COUNT = 512;
+static const int REPORT_ITERATIONS = 20000;
+
+RulesBench::RulesBench(QObject *parent)
+    : QObject(parent), controller(nullptr), samples(nullptr)
+{
+}
+
+RulesBench::~RulesBench()
+{
+    delete samples;
+    delete controller;
+}
+
+void RulesBench::initTestCase()
+{
+    controller = new ServerController;
+    controller->setDesiredPlayers(4);
+    samples = new BoardSamples(*controller);
+}
+
+void RulesBench::benchMoves(const QString &name, const QList<MoveCase> &cases)
+{
+    int i = 0;
+    QBENCHMARK {
+        const MoveCase &c = cases.at(i++ % cases.size());
+        QMap<int, QList<int>> tiles = c.tiles;
+        controller->do_plan_OP(c.clientId, c.dice, c.planeId, tiles);
+    }
+
+    reportPerOp(name, REPORT_ITERATIONS, [&](int n) {
+        const MoveCase &c = cases.at(n % cases.size());
+        QMap<int, QList<int>> tiles = c.tiles;
+        controller->do_plan_OP(c.clientId, c.dice, c.planeId, tiles);
+    });
+}
+
+void RulesBench::doPlanOpTakeOff()
+{
+    benchMoves("do_plan_OP/take-off", samples->takeOffCases(SAMPLE_COUNT));
+}
+
+void RulesBench::doPlanOpNormalStep()
+{
+    benchMoves("do_plan_OP/normal-step", samples->normalStepCases(SAMPLE_COUNT));
+}
+
+void RulesBench::doPlanOpExitPath()
+{
+    benchMoves("do_plan_OP/exit-path", samples->exitPathCases(SAMPLE_COUNT));
+}
+
+void RulesBench::doPlanOpBounceBack()
+{
+    benchMoves("do_plan_OP/bounce-back", samples->bounceBackCases(SAMPLE_COUNT));
+}
+
+void RulesBench::doFly()
+{
+    const QList<MoveCase> cases = samples->flyCases(SAMPLE_COUNT);
+    const QString yes("YES");
+
+    int i = 0;
+    QBENCHMARK {
+        const MoveCase &c = cases.at(i++ % cases.size());
+        QMap<int, QList<int>> tiles = c.tiles;
+        controller->do_fly(c.planeId, c.clientId, yes, tiles);
+    }
+
+    reportPerOp("do_fly", REPORT_ITERATIONS, [&](int n) {
+        const MoveCase &c = cases.at(n % cases.size());
+        QMap<int, QList<int>> tiles = c.tiles;
+        controller->do_fly(c.planeId, c.clientId, yes, tiles);
+    });
+}
+
+void RulesBench::handleCollision()
+{
+    const QList<MoveCase> cases = samples->collisionCases(SAMPLE_COUNT);
+
+    int i = 0;
+    QBENCHMARK {
+        const MoveCase &c = cases.at(i++ % cases.size());
+        QMap<int, QList<int>> tiles = c.tiles;
+        controller->handleCollision((c.clientId - 1) * 4 + c.planeId, c.tileId, tiles);
+    }
+
+    reportPerOp("handleCollision", REPORT_ITERATIONS, [&](int n) {
+        const MoveCase &c = cases.at(n % cases.size());
+        QMap<int, QList<int>> tiles = c.tiles;
+        controller->handleCollision((c.clientId - 1) * 4 + c.planeId, c.tileId, tiles);
+    });
+}
+
+void RulesBench::findPlaneCurrentTile()
+{
+    QList<QMap<int, QList<int>>> boards;
+    for (int i = 0; i < SAMPLE_COUNT; ++i) {
+        boards.append(samples->randomBoard());
+    }
+
+    int i = 0;
+    QBENCHMARK {
+        QMap<int, QList<int>> &tiles = boards[i % boards.size()];
+        controller->findPlaneCurrentTile(i % 16 + 1, tiles);
+        ++i;
+    }
+
+    reportPerOp("findPlaneCurrentTile", REPORT_ITERATIONS, [&](int n) {
+        QMap<int, QList<int>> &tiles = boards[n % boards.size()];
+        controller->findPlaneCurrentTile(n % 16 + 1, tiles);
+    });
+}
+
+void RulesBench::checkIsWin()
+{
+    QList<GameState> states;
+    for (int i = 0; i < SAMPLE_COUNT; ++i) {
+        states.append(GameState(samples->randomBoard()));
+    }
+
+    int i = 0;
+    QBENCHMARK {
+        controller->check_is_win(states[i++ % states.size()]);
+    }
+
+    reportPerOp("check_is_win", REPORT_ITERATIONS, [&](int n) {
+        controller->check_is_win(states[n % states.size()]);
+    });
+}
+
+void RulesBench::initGame()
+{
+    GameModel model;
+
+    QBENCHMARK {
+        model.initGame(4);
+    }
+
+    reportPerOp("GameModel::initGame", REPORT_ITERATIONS, [&](int) {
+        model.initGame(4);
+    });
+}
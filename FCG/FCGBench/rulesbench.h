@@ -0,0 +1,38 @@
+#ifndef RULESBENCH_H
+#define RULESBENCH_H
+
+#include <QObject>
+#include <QList>
+#include "boardsamples.h"
+
+class ServerController;
+
+// 规则引擎基准：走子（起飞/普通/进入终点通道/终点回退）、飞跃、撞机、查找飞机、胜负判定、初始化棋盘
+class RulesBench : public QObject
+{
+    Q_OBJECT
+public:
+    explicit RulesBench(QObject *parent = nullptr);
+    ~RulesBench();
+
+private slots:
+    void initTestCase();
+
+    void doPlanOpTakeOff();
+    void doPlanOpNormalStep();
+    void doPlanOpExitPath();
+    void doPlanOpBounceBack();
+    void doFly();
+    void handleCollision();
+    void findPlaneCurrentTile();
+    void checkIsWin();
+    void initGame();
+
+private:
+    void benchMoves(const QString &name, const QList<MoveCase> &cases);
+
+    ServerController *controller;
+    BoardSamples *samples;
+};
+
+#endif // RULESBENCH_H
@@ -0,0 +1,106 @@
+#include "searchbench.h"
+#include "benchreport.h"
+#include "servercontroller.h"
+#include "expectimaxsearch.h"
+#include "montecarlobot.h"
+#include <QTest>
+#include <QThreadPool>
+#include <climits>
+
+static const int POSITION_COUNT = 32;
+static const int REPORT_ITERATIONS = 20000;
+
+SearchBench::SearchBench(QObject *parent)
+    : QObject(parent), controller(nullptr), samples(nullptr)
+{
+}
+
+SearchBench::~SearchBench()
+{
+    delete samples;
+    delete controller;
+}
+
+void SearchBench::initTestCase()
+{
+    controller = new ServerController;
+    controller->setDesiredPlayers(4);
+    samples = new BoardSamples(*controller);
+    for (int i = 0; i < POSITION_COUNT; ++i) {
+        positions.append(BoardPosition::fromTileStates(samples->randomBoard()));
+    }
+}
+
+void SearchBench::applyMoveCompact()
+{
+    // 与 RulesBench 中基于 QMap 的 do_plan_OP 对照
+    const QList<MoveCase> cases = samples->normalStepCases(512);
+    QList<BoardPosition> starts;
+    for (const MoveCase &c : cases) {
+        starts.append(BoardPosition::fromTileStates(c.tiles));
+    }
+
+    int i = 0;
+    QBENCHMARK {
+        const int n = i++ % cases.size();
+        BoardPosition position = starts.at(n);
+        GameRules::applyMove(position, cases.at(n).clientId, cases.at(n).dice, cases.at(n).planeId);
+    }
+
+    reportPerOp("GameRules::applyMove/normal-step", REPORT_ITERATIONS, [&](int k) {
+        const int n = k % cases.size();
+        BoardPosition position = starts.at(n);
+        GameRules::applyMove(position, cases.at(n).clientId, cases.at(n).dice, cases.at(n).planeId);
+    });
+}
+
+void SearchBench::expectimaxDepth_data()
+{
+    QTest::addColumn<int>("threads");
+    QTest::newRow("1 thread") << 1;
+    QTest::newRow("all threads") << QThread::idealThreadCount();
+}
+
+void SearchBench::expectimaxDepth()
+{
+    QFETCH(int, threads);
+
+    ExpectimaxOptions options;
+    options.threads = threads;
+    QThreadPool pool;
+
+    qint64 totalDepth = 0;
+    qint64 totalNodes = 0;
+    int minDepth = INT_MAX;
+    for (int i = 0; i < positions.size(); ++i) {
+        // 每个局面用新的置换表，避免上一个局面的结果抬高深度
+        ExpectimaxSearch search;
+        const BotDecision decision = search.chooseMove(positions.at(i), i % 4 + 1, 6, options, &pool);
+        totalDepth += decision.depth;
+        totalNodes += decision.work;
+        minDepth = qMin(minDepth, decision.depth);
+    }
+
+    qCInfo(lcBench).noquote() << QString("%1: avg depth %2, min depth %3, %4 nodes/search (%5 ms budget)")
+                                     .arg(QString("Expectimax/%1 threads").arg(threads), -40)
+                                     .arg(double(totalDepth) / positions.size(), 0, 'f', 2)
+                                     .arg(minDepth)
+                                     .arg(totalNodes / positions.size())
+                                     .arg(options.budgetMs);
+}
+
+void SearchBench::monteCarloPlayouts()
+{
+    MonteCarloOptions options;
+    QThreadPool pool;
+
+    qint64 totalPlayouts = 0;
+    for (int i = 0; i < positions.size(); ++i) {
+        totalPlayouts += MonteCarloBot::chooseMove(positions.at(i), i % 4 + 1, 6, options, &pool).work;
+    }
+
+    qCInfo(lcBench).noquote() << QString("%1: %2 playouts/move (%3 ms budget)")
+                                     .arg("MonteCarloBot", -40)
+                                     .arg(totalPlayouts / positions.size())
+                                     .arg(options.budgetMs);
+}
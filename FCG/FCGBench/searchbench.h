@@ -0,0 +1,33 @@
+#ifndef SEARCHBENCH_H
+#define SEARCHBENCH_H
+
+#include <QObject>
+#include <QList>
+#include "boardsamples.h"
+#include <../FCGClient/model/gamerules.h>
+
+class ServerController;
+
+// AI 搜索基准：紧凑局面上的走子开销、固定时间预算内期望搜索达到的深度、蒙特卡洛的模拟局数
+class SearchBench : public QObject
+{
+    Q_OBJECT
+public:
+    explicit SearchBench(QObject *parent = nullptr);
+    ~SearchBench();
+
+private slots:
+    void initTestCase();
+
+    void applyMoveCompact();
+    void expectimaxDepth_data();
+    void expectimaxDepth();
+    void monteCarloPlayouts();
+
+private:
+    ServerController *controller;
+    BoardSamples *samples;
+    QList<BoardPosition> positions;
+};
+
+#endif // SEARCHBENCH_H
@@ -0,0 +1,230 @@
+#include "serializationbench.h"
+#include "benchreport.h"
+#include "boardsamples.h"
+#include "servercontroller.h"
+#include <../FCGClient/model/gamestate.h>
+#include <../FCGClient/model/protocol.h>
+#include <QTest>
+
+static const int SAMPLE_COUNT = 256;
+static const int REPORT_ITERATIONS = 5000;
+
+enum FrameKind {
+    GameStateFrame,
+    EventFrame,
+    TurnNoticeFrame,
+    PlaneOpFrame,
+    // 改用 EVENT_MSG 之前的文本消息，留作对照
+    TextFrame,
+    TextTurnNoticeFrame
+};
+
+// 按当前服务器/客户端的写法构造一帧
+static QByteArray buildFrame(int kind, const QMap<int, QList<int>> &tiles)
+{
+    switch (kind) {
+    case GameStateFrame: {
+        // 与 ClientHandler::sendGameState 一致：先包装成 QVariant，再组帧
+        GameState state(tiles);
+        return Protocol::encodeFrame("GAME_STATE_MSG", QVariant::fromValue(state));
+    }
+    case EventFrame:
+        return Protocol::encodeFrame("EVENT_MSG", int(ServerEvent::YourTurnRoll), QVariantList());
+    case TurnNoticeFrame:
+        return Protocol::encodeFrame("EVENT_MSG", int(ServerEvent::TurnChanged), QVariantList{2});
+    case PlaneOpFrame:
+        return Protocol::encodeFrame("PLANE_OP_MSG", QVariant(6), QVariant(3));
+    case TextFrame:
+        return Protocol::encodeFrame("TEXT_MSG", QVariant("YOUR_TURN_ROLL_AND_CHOOSE_PLANE"));
+    case TextTurnNoticeFrame:
+        return Protocol::encodeFrame("TEXT_MSG", QVariant(QString("轮到玩家 %1 (%2) 操作").arg(2).arg("蓝")));
+    }
+    return QByteArray();
+}
+
+// 按 GameController::handleReadyRead / ClientHandler::readData 的方式解析一帧
+static int parseFrame(const QByteArray &frame)
+{
+    QDataStream in(frame);
+    in.setVersion(Protocol::STREAM_VERSION);
+
+    quint32 size = 0;
+    QString messageType;
+    in >> size >> messageType;
+
+    QVariant payload1, payload2;
+    if (!in.atEnd()) in >> payload1;
+    if (!in.atEnd()) in >> payload2;
+
+    if (messageType == "GAME_STATE_MSG") {
+        return payload1.value<GameState>().getTileStates().size();
+    }
+    if (messageType == "PLANE_OP_MSG") {
+        return payload1.toInt() + payload2.toInt();
+    }
+    if (messageType == "EVENT_MSG") {
+        return payload1.toInt() + payload2.toList().size();
+    }
+    return payload1.toString().size();
+}
+
+SerializationBench::SerializationBench(QObject *parent)
+    : QObject(parent), controller(nullptr), samples(nullptr)
+{
+}
+
+SerializationBench::~SerializationBench()
+{
+    delete samples;
+    delete controller;
+}
+
+void SerializationBench::initTestCase()
+{
+    controller = new ServerController;
+    samples = new BoardSamples(*controller, 7);
+    for (int i = 0; i < SAMPLE_COUNT; ++i) {
+        boards.append(samples->randomBoard());
+    }
+}
+
+void SerializationBench::gameStateEncode()
+{
+    QList<GameState> states;
+    for (const auto &tiles : std::as_const(boards)) {
+        states.append(GameState(tiles));
+    }
+
+    int i = 0;
+    QBENCHMARK {
+        QByteArray buffer;
+        QDataStream out(&buffer, QIODevice::WriteOnly);
+        out.setVersion(Protocol::STREAM_VERSION);
+        out << states.at(i++ % states.size());
+    }
+
+    // 字节数按实际编码的次数平均，与 reportPerOp 是否预热、预热几次无关
+    qint64 totalBytes = 0;
+    int encodedStates = 0;
+    reportPerOp("GameState operator<<", REPORT_ITERATIONS, [&](int n) {
+        QByteArray buffer;
+        QDataStream out(&buffer, QIODevice::WriteOnly);
+        out.setVersion(Protocol::STREAM_VERSION);
+        out << states.at(n % states.size());
+        totalBytes += buffer.size();
+        encodedStates++;
+    });
+    qCInfo(lcBench).noquote() << QString("GameState operator<<: %1 bytes/state")
+                                     .arg(double(totalBytes) / encodedStates, 0, 'f', 1);
+}
+
+void SerializationBench::gameStateDecode()
+{
+    QList<QByteArray> encoded;
+    for (const auto &tiles : std::as_const(boards)) {
+        QByteArray buffer;
+        QDataStream out(&buffer, QIODevice::WriteOnly);
+        out.setVersion(Protocol::STREAM_VERSION);
+        out << GameState(tiles);
+        encoded.append(buffer);
+    }
+
+    int i = 0;
+    QBENCHMARK {
+        QDataStream in(encoded.at(i++ % encoded.size()));
+        in.setVersion(Protocol::STREAM_VERSION);
+        GameState state;
+        in >> state;
+    }
+
+    reportPerOp("GameState operator>>", REPORT_ITERATIONS, [&](int n) {
+        QDataStream in(encoded.at(n % encoded.size()));
+        in.setVersion(Protocol::STREAM_VERSION);
+        GameState state;
+        in >> state;
+    });
+}
+
+void SerializationBench::addFrameRows(bool withSubscribers)
+{
+    QTest::addColumn<int>("kind");
+    QTest::addColumn<int>("subscribers");
+
+    const QList<QPair<const char *, int>> kinds = {
+        {"GAME_STATE_MSG", GameStateFrame},
+        {"EVENT_MSG", EventFrame},
+        {"EVENT_MSG(turn notice)", TurnNoticeFrame},
+        {"PLANE_OP_MSG", PlaneOpFrame},
+        {"TEXT_MSG(baseline)", TextFrame},
+        {"TEXT_MSG(turn notice, baseline)", TextTurnNoticeFrame}
+    };
+    const QList<int> subscriberCounts = withSubscribers ? QList<int>{1, 4, 64} : QList<int>{1};
+
+    for (const auto &kind : kinds) {
+        for (int subscribers : subscriberCounts) {
+            QTest::addRow("%s x%d", kind.first, subscribers) << kind.second << subscribers;
+        }
+    }
+}
+
+void SerializationBench::frameEncode_data()
+{
+    addFrameRows(true);
+}
+
+void SerializationBench::frameEncode()
+{
+    QFETCH(int, kind);
+    QFETCH(int, subscribers);
+
+    // 与 ServerController::broadcastFrame 一致：每次广播只组帧一次，再拷进每个接收者的写缓冲
+    QList<QByteArray> writeBuffers(subscribers);
+    auto broadcast = [&](const QMap<int, QList<int>> &tiles) {
+        const QByteArray frame = buildFrame(kind, tiles);
+        for (QByteArray &buffer : writeBuffers) {
+            buffer.truncate(0);
+            buffer.append(frame);
+        }
+        return frame.size();
+    };
+
+    int i = 0;
+    QBENCHMARK {
+        broadcast(boards.at(i++ % boards.size()));
+    }
+
+    qint64 totalBytes = 0;
+    int broadcasts = 0;
+    const QString name = QString("encode %1").arg(QTest::currentDataTag());
+    reportPerOp(name, REPORT_ITERATIONS / subscribers + 1, [&](int n) {
+        totalBytes += qint64(broadcast(boards.at(n % boards.size()))) * subscribers;
+        broadcasts++;
+    });
+    qCInfo(lcBench).noquote() << QString("%1: %2 bytes/broadcast")
+                                     .arg(name, -40)
+                                     .arg(double(totalBytes) / broadcasts, 0, 'f', 1);
+}
+
+void SerializationBench::frameDecode_data()
+{
+    addFrameRows(false);
+}
+
+void SerializationBench::frameDecode()
+{
+    QFETCH(int, kind);
+
+    QList<QByteArray> frames;
+    for (const auto &tiles : std::as_const(boards)) {
+        frames.append(buildFrame(kind, tiles));
+    }
+
+    int i = 0;
+    QBENCHMARK {
+        parseFrame(frames.at(i++ % frames.size()));
+    }
+
+    reportPerOp(QString("decode %1").arg(QTest::currentDataTag()), REPORT_ITERATIONS, [&](int n) {
+        parseFrame(frames.at(n % frames.size()));
+    });
+}
@@ -0,0 +1,40 @@
+#ifndef SERIALIZATIONBENCH_H
+#define SERIALIZATIONBENCH_H
+
+#include <QObject>
+#include <QList>
+#include <QMap>
+
+class ServerController;
+class BoardSamples;
+
+// 序列化与组帧基准：GameState 流操作、sendGameState 的 QVariant 包装、EVENT_MSG、PLANE_OP_MSG，
+// 以及改用 EVENT_MSG 之前的 TEXT_MSG（对照）；
+// 广播类消息分别按 1/4/64 个接收者测量，与服务器一样每次广播只组帧一次，再拷给每个接收者。
+class SerializationBench : public QObject
+{
+    Q_OBJECT
+public:
+    explicit SerializationBench(QObject *parent = nullptr);
+    ~SerializationBench();
+
+private slots:
+    void initTestCase();
+
+    void gameStateEncode();
+    void gameStateDecode();
+
+    void frameEncode_data();
+    void frameEncode();
+    void frameDecode_data();
+    void frameDecode();
+
+private:
+    void addFrameRows(bool withSubscribers);
+
+    ServerController *controller;
+    BoardSamples *samples;
+    QList<QMap<int, QList<int>>> boards;
+};
+
+#endif // SERIALIZATIONBENCH_H
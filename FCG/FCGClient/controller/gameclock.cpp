@@ -0,0 +1,29 @@
+#include "gameclock.h"
+#include <QThread>
+#include <QTimer>
+
+GameClock* GameClock::system()
+{
+    static SystemClock clock;
+    return &clock;
+}
+
+SystemClock::SystemClock()
+{
+    timer.start();
+}
+
+qint64 SystemClock::nowMs() const
+{
+    return timer.elapsed();
+}
+
+void SystemClock::sleep(int ms)
+{
+    if (ms > 0) QThread::msleep(ms);
+}
+
+void SystemClock::singleShot(int ms, QObject *context, std::function<void()> callback)
+{
+    QTimer::singleShot(ms, context, std::move(callback));
+}
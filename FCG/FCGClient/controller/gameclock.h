@@ -0,0 +1,36 @@
+#ifndef GAMECLOCK_H
+#define GAMECLOCK_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <functional>
+
+// 时钟抽象：服务器逐步移动时的停顿、客户端连接超时都经由它完成。
+// 默认使用真实时间；仿真时替换为虚拟时钟，整局游戏可以按CPU速度确定性地跑完。
+class GameClock
+{
+public:
+    virtual ~GameClock() = default;
+
+    virtual qint64 nowMs() const = 0;
+    virtual void sleep(int ms) = 0;
+    // context 被销毁后回调不再执行
+    virtual void singleShot(int ms, QObject* context, std::function<void()> callback) = 0;
+
+    static GameClock* system();
+};
+
+class SystemClock : public GameClock
+{
+public:
+    SystemClock();
+
+    qint64 nowMs() const override;
+    void sleep(int ms) override;
+    void singleShot(int ms, QObject* context, std::function<void()> callback) override;
+
+private:
+    QElapsedTimer timer;
+};
+
+#endif // GAMECLOCK_H
@@ -1,310 +1,672 @@
-#include "gamecontroller.h"
-#include <QTimer>
-#include <QDebug>
-#include "../model/gamestate.h"
-
-GameController::GameController(GameModel* gameModel, const QString& h, int p, QObject* parent)
-    : QObject(parent), model(gameModel), view(nullptr),
-    host(h), port(p), isConnected(false), expectedBytes(0), connectTimer(nullptr)
-{
-    socket = new QTcpSocket(this);
-
-    inStream.setDevice(socket);
-    inStream.setVersion(QDataStream::Qt_6_5);
-
-    connect(socket, &QTcpSocket::connected, this, &GameController::handleConnected);
-    connect(socket, &QTcpSocket::readyRead, this, &GameController::handleReadyRead);
-    connect(socket, &QTcpSocket::errorOccurred, this, &GameController::handleError);
-    connect(socket, &QTcpSocket::disconnected, this, &GameController::handleDisconnected);
-
-    qRegisterMetaType<QMap<int, QList<int>>>("QMap<int,QList<int>>");
-    qRegisterMetaType<GameState>("GameState");
-    //qRegisterMetaType<ControlPanel::GamePhase>("ControlPanel::GamePhase");
-    qDebug() << "GameController created. Attempting to connect to" << host << ":" << port;
-}
-
-GameController::~GameController()
-{
-    closeConnection();
-}
-
-void GameController::setView(MainView *v)
-{
-    this->view = v;
-}
-
-void GameController::connectToServer()
-{
-    if (socket->state() != QAbstractSocket::UnconnectedState) {
-        qWarning() << "GameController::connectToServer: Socket not in unconnected state, current state:" << socket->state();
-        if (isConnected) {
-            qInfo() << "Already connected.";
-            emit serverMessageReceived(tr("已连接到服务器"));
-            return;
-        }
-        if (socket->state() == QAbstractSocket::ConnectingState) {
-            qInfo() << "Connection attempt already in progress.";
-            return;
-        }
-        socket->abort();
-    }
-
-    qDebug() << "GameController: Connecting to server:" << host << ":" << port;
-    expectedBytes = 0;
-    socket->connectToHost(host, port);
-
-    if (!connectTimer) {
-        connectTimer = new QTimer(this);
-        connectTimer->setSingleShot(true);
-        connect(connectTimer, &QTimer::timeout, this, [this]() {
-            if (!isConnected && socket->state() == QAbstractSocket::ConnectingState) {
-                socket->abort();
-                qCritical() << "GameController: Connection timeout to" << host << ":" << port;
-                emit serverMessageReceived(tr("连接服务器超时"));
-                emit connectionStatusChanged(false);
-
-                if (view && view->getControlPanel()) {
-                    emit updateGamePhase(ControlPanel::GamePhase::WAITING, tr("连接超时，请重试"));
-                }
-            }
-        });
-    }
-    connectTimer->start(5000);
-}
-
-void GameController::sendTypedMessage(const QString& messageType, const QVariant& payload1, const QVariant& payload2) {
-    if (!isConnected || !socket || socket->state() != QTcpSocket::ConnectedState) {
-        qWarning() << "GameController: Cannot send [" << messageType << "]. Not connected.";
-        emit serverMessageReceived(tr("未连接到服务器，无法发送消息。"));
-        return;
-    }
-
-    QByteArray block;
-    QDataStream out(&block, QIODevice::WriteOnly);
-    out.setVersion(QDataStream::Qt_6_5);
-
-    out << quint32(0);
-    out << messageType;
-
-    if (payload1.isValid()) out << payload1;
-    if (payload2.isValid()) out << payload2;
-
-    out.device()->seek(0);
-    out << quint32(block.size() - sizeof(quint32));
-
-    qint64 bytesWritten = socket->write(block);
-    if (bytesWritten == -1) {
-        qWarning() << "GameController: Failed to write to socket for message [" << messageType << "]. Error:" << socket->errorString();
-    } else if (bytesWritten < block.size()) {
-        qWarning() << "GameController: Not all bytes written for message [" << messageType << "]. Wrote" << bytesWritten << "of" << block.size();
-        // Handle partial write, though for TCP this is less common unless buffer issues
-    } else {
-        socket->flush(); // Ensure data is sent immediately
-        qDebug() << "Client sent [" << messageType << "] size:" << block.size();
-    }
-
-}
-
-
-void GameController::sendReady()
-{
-    qDebug() << "Client sending READY_MSG. Connection status:" << isConnected;
-    sendTypedMessage("READY_MSG");
-}
-
-void GameController::sendPlaneOperation(int dice, int planeId)
-{
-    qDebug() << "Client sending PLANE_OP_MSG with dice:" << dice << "plane:" << planeId;
-    sendTypedMessage("PLANE_OP_MSG", QVariant(dice), QVariant(planeId));
-}
-
-void GameController::sendFlyOverChoice(bool isYes)
-{
-    qDebug() << "Client sending FLY_OVER_MSG with choice:" << isYes;
-    sendTypedMessage("FLY_OVER_MSG", QVariant(isYes));
-}
-
-
-void GameController::handleConnected()
-{
-    if(connectTimer && connectTimer->isActive()) {
-        connectTimer->stop();
-    }
-
-    qInfo() << "GameController: Successfully connected to server:" << host << ":" << port;
-    isConnected = true;
-    emit connectionStatusChanged(true);
-    emit serverMessageReceived(tr("已连接到服务器."));
-    if (view && view->getControlPanel()) {
-        emit updateGamePhase(ControlPanel::GamePhase::WAITING, tr("已连接，等待其他玩家准备..."));
-    }
-}
-
-void GameController::handleReadyRead()
-{
-    qDebug() << "Client: handleReadyRead() triggered. Bytes available:" << socket->bytesAvailable();
-    inStream.setVersion(QDataStream::Qt_6_5);
-
-    forever {
-        qDebug() << "Client: Top of forever loop. expectedBytes:" << expectedBytes << "Bytes available:" << socket->bytesAvailable() << "Stream status:" << inStream.status();
-        if (expectedBytes == 0) {
-            if (socket->bytesAvailable() < sizeof(quint32)) {
-                qDebug() << "Client: Not enough data for size yet. Have" << socket->bytesAvailable() << "need" << sizeof(quint32) << ". Returning.";
-                return;
-            }
-            inStream >> expectedBytes;
-            qDebug() << "Client: Expecting" << expectedBytes << "bytes from server.";
-        }
-
-        if (socket->bytesAvailable() < expectedBytes) {
-            qDebug() << "Client: Not enough data yet. Have" << socket->bytesAvailable() << "need" << expectedBytes;
-            return;
-        }
-
-        QString messageType;
-        inStream >> messageType;
-        if (inStream.status() != QDataStream::Ok) {
-            qWarning() << "Client: QDataStream error while reading messageType.";
-            socket->abort(); expectedBytes = 0; return;
-        }
-        qDebug() << "Client: Received message type:" << messageType;
-
-        if (messageType == "GAME_STATE_MSG") {
-            QVariant gameStatePayload;
-            inStream >> gameStatePayload;
-            if (inStream.status() != QDataStream::Ok || !gameStatePayload.canConvert<GameState>()) {
-                qWarning() << "Client: QDataStream error or type mismatch reading GAME_STATE_MSG payload.";
-                socket->abort(); expectedBytes = 0; return;
-            }
-            GameState receivedState = gameStatePayload.value<GameState>();
-            qDebug() << "Client: Received GAME_STATE_MSG, map size:" << receivedState.getTileStates().size();
-            if (model) model->setBoardState(receivedState.getTileStates());
-            emit gameStateUpdated(receivedState.getTileStates());
-        } else if (messageType == "TEXT_MSG") {
-            QVariant textPayload;
-            inStream >> textPayload;
-            if (inStream.status() != QDataStream::Ok) {
-                qWarning() << "Client: QDataStream error while reading TEXT_MSG QVariant payload.";
-                socket->abort(); expectedBytes = 0; return;
-            }
-            QString content = textPayload.toString();
-            qDebug() << "Client: Received TEXT_MSG content:" << content;
-
-            ControlPanel::GamePhase phase = ControlPanel::GamePhase::WAITING;
-            QString uiMessage = content;
-
-            if (content.startsWith("YOUR_TURN_ROLL_AND_CHOOSE_PLANE")) {
-                uiMessage = tr("轮到你了, 请投骰子并选择飞机!");
-                phase = ControlPanel::GamePhase::ROLL_AND_CHOOSE_PLANE;
-            } else if (content.startsWith("YOUR_TURN_CHOOSE_FLY")) {
-                uiMessage = tr("请选择是否飞跃!");
-                phase = ControlPanel::GamePhase::CHOOSE_FLY_OVER;
-            }else if (content.contains("已赢得游戏！游戏结束。")) {
-                uiMessage = content;
-                phase = ControlPanel::GamePhase::GAME_ENDED;
-            }else if (content.startsWith("ERROR:")) {
-                uiMessage = tr("服务器错误: %1").arg(content.mid(6));
-            } else if (content.startsWith("WELCOME:")) {
-                phase = ControlPanel::GamePhase::WAITING;
-            } else {
-                if (content.contains("等待") || content.contains("已准备") || content.contains("加入了游戏") || content.contains("游戏开始")) {
-                    phase = ControlPanel::GamePhase::WAITING;
-                }
-                if (content.contains("游戏开始!")) { }
-            }
-            emit serverMessageReceived(uiMessage);
-            if (view && view->getControlPanel()){
-                emit updateGamePhase(phase, uiMessage);
-            }
-        } else {
-            qWarning() << "Client: Received unknown message type from server:" << messageType;
-
-            QByteArray dummy = socket->read(expectedBytes); // Attempt to read out the rest of the expected block
-            qDebug() << "Client: Discarded" << dummy.size() << "bytes for unknown message type.";
-        }
-        expectedBytes = 0;
-
-        if(inStream.status() != QDataStream::Ok && socket->state() == QAbstractSocket::ConnectedState){
-            qWarning() << "Client: QDataStream not OK after processing message. Aborting.";
-            socket->abort();
-            return;
-        }
-
-        if (socket->bytesAvailable() == 0) break;
-    }
-}
-
-
-void GameController::handleError(QAbstractSocket::SocketError socketError)
-{
-    if(connectTimer && connectTimer->isActive()) {
-        connectTimer->stop();
-    }
-
-    QString errorMsg;
-    if (socketError == QAbstractSocket::RemoteHostClosedError) {
-        errorMsg = tr("连接被服务器关闭.");
-    } else if (socketError == QAbstractSocket::ConnectionRefusedError) {
-        errorMsg = tr("连接被服务器拒绝. 请确认服务器正在运行并且地址正确.");
-    } else if (socketError == QAbstractSocket::HostNotFoundError) {
-        errorMsg = tr("找不到服务器主机. 请检查主机名或IP地址.");
-    } else {
-        errorMsg = socket->errorString();
-    }
-
-    qCritical() << "GameController: Network error occurred:" << socketError << errorMsg;
-    emit serverMessageReceived(tr("网络错误: %1").arg(errorMsg));
-    if (isConnected) {
-        isConnected = false;
-        emit connectionStatusChanged(false);
-    }
-    if (view && view->getControlPanel()) {
-        emit updateGamePhase(ControlPanel::GamePhase::WAITING, tr("网络错误: %1").arg(errorMsg));
-    }
-}
-
-void GameController::handleDisconnected()
-{
-    qInfo() << "GameController: Disconnected from server.";
-    if(connectTimer && connectTimer->isActive()) {
-        connectTimer->stop();
-    }
-    bool wasConnected = isConnected;
-    isConnected = false;
-    expectedBytes = 0;
-
-    if (wasConnected) {
-        emit serverMessageReceived(tr("已从服务器断开连接."));
-        emit connectionStatusChanged(false);
-        if (view && view->getControlPanel()) {
-            emit updateGamePhase(ControlPanel::GamePhase::WAITING, tr("已断开连接. 请尝试重新连接."));
-        }
-    } else {
-        if (socket->error() == QAbstractSocket::RemoteHostClosedError) {
-            qDebug() << "GameController: Disconnected, but wasNotConnected or error already handled. Socket error:" << socket->errorString();
-            emit serverMessageReceived(tr("连接被服务器关闭."));
-        } else {
-            emit serverMessageReceived(tr("连接已关闭."));
-        }
-        if (view && view->getControlPanel()) { // Safely access controlPanel
-            emit updateGamePhase(ControlPanel::GamePhase::WAITING, tr("连接已关闭."));
-        }
-    }
-}
-
-void GameController::closeConnection()
-{
-    qDebug() << "GameController: closeConnection() called. Current state:" << (socket ? socket->state() : -1) << "isConnected:" << isConnected;
-    if (socket && socket->state() != QAbstractSocket::UnconnectedState) {
-        socket->abort();
-    }
-
-    bool oldStatus = isConnected;
-    isConnected = false;
-    expectedBytes = 0;
-
-    if (oldStatus) {
-        emit connectionStatusChanged(false);
-    }
-    qDebug() << "GameController: Connection resources cleaned up.";
-}
+#include "gamecontroller.h"
+#include <QTimer>
+#include <QDebug>
+#include <QLocalSocket>
+#include "../model/gamestate.h"
+#include "../model/protocol.h"
+
+static const int CONNECT_TIMEOUT_MS = 5000;
+
+namespace {
+QString playerName(const QVariant& playerId)
+{
+    static const char* const colors[] = { QT_TRANSLATE_NOOP("GameController", "黄"),
+                                          QT_TRANSLATE_NOOP("GameController", "蓝"),
+                                          QT_TRANSLATE_NOOP("GameController", "绿"),
+                                          QT_TRANSLATE_NOOP("GameController", "红") };
+    const int id = playerId.toInt();
+    const QString color = (id >= 1 && id <= 4) ? GameController::tr(colors[id - 1]) : GameController::tr("未知");
+    return GameController::tr("玩家 %1 (%2)").arg(id).arg(color);
+}
+
+QString errorText(const QVariantList& a)
+{
+    switch (ServerError(a.value(0).toInt())) {
+    case ServerError::GameNotStarted: return GameController::tr("服务器错误: 游戏尚未开始或未集齐玩家.");
+    case ServerError::NotYourTurn:    return GameController::tr("服务器错误: 不是你的回合!");
+    case ServerError::InvalidPlaneOp: return GameController::tr("服务器错误: 无效的飞机操作参数.");
+    case ServerError::InvalidHint:    return GameController::tr("服务器错误: 无效的提示请求.");
+    case ServerError::UnknownAction:  return GameController::tr("服务器错误: 未知操作! %1").arg(a.value(1).toString());
+    case ServerError::Spectating:     return GameController::tr("服务器错误: 观战中不能操作.");
+    case ServerError::Internal:
+        return a.size() > 1 ? GameController::tr("服务器错误: 处理操作时发生错误: %1").arg(a.value(1).toString())
+                            : GameController::tr("服务器错误: 处理操作时发生未知错误.");
+    }
+    return GameController::tr("服务器错误: %1").arg(a.value(0).toInt());
+}
+
+// EVENT_MSG 的分发表，下标为 事件编号-1。setsPhase 为 false 的事件只显示文字，不改变操作阶段
+struct EventEntry
+{
+    ServerEvent event;
+    bool setsPhase;
+    ControlPanel::GamePhase phase;
+    QString (*text)(const QVariantList& args);
+};
+
+using Phase = ControlPanel::GamePhase;
+const EventEntry EVENT_TABLE[] = {
+    { ServerEvent::Welcome, true, Phase::LOBBY, [](const QVariantList& a) {
+         return GameController::tr("已作为%1加入，等待游戏开始...").arg(playerName(a.value(0))); } },
+    { ServerEvent::PlayerJoined, true, Phase::LOBBY, [](const QVariantList& a) {
+         return GameController::tr("%1 加入了游戏. (%2/%3)").arg(playerName(a.value(0))).arg(a.value(1).toInt()).arg(a.value(2).toInt()); } },
+    { ServerEvent::BotJoined, true, Phase::LOBBY, [](const QVariantList& a) {
+         return GameController::tr("AI%1 加入了游戏. (%2/%3)").arg(playerName(a.value(0))).arg(a.value(1).toInt()).arg(a.value(2).toInt()); } },
+    { ServerEvent::PlayerLeft, false, Phase::WAITING, [](const QVariantList& a) {
+         return GameController::tr("%1 离开了游戏.").arg(playerName(a.value(0))); } },
+    { ServerEvent::PlayerLeftWaiting, true, Phase::LOBBY, [](const QVariantList& a) {
+         return GameController::tr("%1 离开了. 等待 %2 位玩家.").arg(playerName(a.value(0))).arg(a.value(1).toInt()); } },
+    { ServerEvent::PlayerReady, true, Phase::LOBBY, [](const QVariantList& a) {
+         return GameController::tr("%1 已准备. (%2/%3)").arg(playerName(a.value(0))).arg(a.value(1).toInt()).arg(a.value(2).toInt()); } },
+    { ServerEvent::WaitingForPlayers, true, Phase::LOBBY, [](const QVariantList& a) {
+         return GameController::tr("等待其他 %1 位玩家加入...").arg(a.value(0).toInt()); } },
+    { ServerEvent::AllReadyWaiting, true, Phase::LOBBY, [](const QVariantList& a) {
+         return GameController::tr("所有已连接玩家已准备，但等待 %1 位玩家加入...").arg(a.value(0).toInt()); } },
+    { ServerEvent::GameStarted, true, Phase::WAITING, [](const QVariantList& a) {
+         return GameController::tr("游戏开始! 轮到%1.").arg(playerName(a.value(0))); } },
+    { ServerEvent::YourTurnRoll, true, Phase::ROLL_AND_CHOOSE_PLANE, [](const QVariantList&) {
+         return GameController::tr("轮到你了, 请投骰子并选择飞机!"); } },
+    { ServerEvent::YourTurnChooseFly, true, Phase::CHOOSE_FLY_OVER, [](const QVariantList&) {
+         return GameController::tr("请选择是否飞跃!"); } },
+    { ServerEvent::TurnChanged, true, Phase::WAITING, [](const QVariantList& a) {
+         return GameController::tr("轮到%1操作").arg(playerName(a.value(0))); } },
+    { ServerEvent::BotRolled, false, Phase::WAITING, [](const QVariantList& a) {
+         return GameController::tr("AI%1 掷出了 %2 点").arg(playerName(a.value(0))).arg(a.value(1).toInt()); } },
+    { ServerEvent::CannotTakeOff, true, Phase::WAITING, [](const QVariantList&) {
+         return GameController::tr("点数不足以起飞"); } },
+    { ServerEvent::GameWon, true, Phase::GAME_ENDED, [](const QVariantList& a) {
+         return GameController::tr("%1 已赢得游戏！游戏结束。").arg(playerName(a.value(0))); } },
+    { ServerEvent::GameAlreadyEnded, true, Phase::GAME_ENDED, [](const QVariantList&) {
+         return GameController::tr("游戏已结束."); } },
+    { ServerEvent::NoNextPlayer, true, Phase::WAITING, [](const QVariantList&) {
+         return GameController::tr("没有有效的下一位玩家，游戏可能已结束或等待中。"); } },
+    { ServerEvent::Error, false, Phase::WAITING, errorText },
+    { ServerEvent::Spectating, true, Phase::WAITING, [](const QVariantList& a) {
+         return GameController::tr("座位已满 (%1/%2)，你正在观战.").arg(a.value(0).toInt()).arg(a.value(1).toInt()); } },
+};
+static_assert(sizeof(EVENT_TABLE) / sizeof(EVENT_TABLE[0]) == int(ServerEvent::EventCount) - 1,
+              "EVENT_TABLE must have one entry per ServerEvent");
+}
+
+GameController::GameController(GameModel* gameModel, const QString& h, int p, QObject* parent)
+    : QObject(parent), model(gameModel), view(nullptr), clock(GameClock::system()),
+    host(h), port(p), isConnected(false), expectedBytes(0)
+{
+    socket = new QTcpSocket(this);
+    device = socket;
+    networked = true;
+    heartbeatTimer = new QTimer(this);
+    heartbeatTimer->setInterval(Heartbeat::INTERVAL_MS);
+    connect(heartbeatTimer, &QTimer::timeout, this, &GameController::sendHeartbeat);
+
+    inStream.setDevice(device);
+    inStream.setVersion(QDataStream::Qt_6_5);
+
+    connect(socket, &QTcpSocket::connected, this, &GameController::handleConnected);
+    connect(socket, &QTcpSocket::readyRead, this, &GameController::handleReadyRead);
+    connect(socket, &QTcpSocket::errorOccurred, this, &GameController::handleError);
+    connect(socket, &QTcpSocket::disconnected, this, &GameController::handleDisconnected);
+
+    qRegisterMetaType<QMap<int, QList<int>>>("QMap<int,QList<int>>");
+    qRegisterMetaType<GameState>("GameState");
+    //qRegisterMetaType<ControlPanel::GamePhase>("ControlPanel::GamePhase");
+    qDebug() << "GameController created. Attempting to connect to" << host << ":" << port;
+}
+
+GameController::GameController(GameModel *gameModel, QIODevice *transport, QObject *parent)
+    : QObject(parent), model(gameModel), view(nullptr), socket(nullptr), device(transport),
+    clock(GameClock::system()), port(0), isConnected(transport && transport->isOpen()), expectedBytes(0)
+{
+    heartbeatTimer = new QTimer(this);
+    heartbeatTimer->setInterval(Heartbeat::INTERVAL_MS);
+    connect(heartbeatTimer, &QTimer::timeout, this, &GameController::sendHeartbeat);
+    if (device) {
+        device->setParent(this);
+        inStream.setDevice(device);
+        connect(device, &QIODevice::readyRead, this, &GameController::handleReadyRead);
+        connect(device, SIGNAL(disconnected()), this, SLOT(handleDisconnected()));
+        networked = qobject_cast<QLocalSocket*>(device) || device->inherits("MuxChannel");
+    }
+    inStream.setVersion(QDataStream::Qt_6_5);
+
+    qRegisterMetaType<QMap<int, QList<int>>>("QMap<int,QList<int>>");
+    qRegisterMetaType<GameState>("GameState");
+    qDebug() << "GameController created on an injected transport.";
+}
+
+GameController::~GameController()
+{
+    closeConnection();
+}
+
+void GameController::setView(MainView *v)
+{
+    this->view = v;
+}
+
+GameModel *GameController::getModel() const
+{
+    return model;
+}
+
+int GameController::getPlayerId() const
+{
+    return playerId;
+}
+
+int GameController::getRttMs() const
+{
+    return heartbeat.smoothedRttMs();
+}
+
+int GameController::getJitterMs() const
+{
+    return heartbeat.jitterMs();
+}
+
+void GameController::startHeartbeat()
+{
+    if (!networked) return;
+    heartbeat = Heartbeat();
+    heartbeatTimer->start();
+}
+
+void GameController::sendHeartbeat()
+{
+    if (!isConnected) {
+        heartbeatTimer->stop();
+        return;
+    }
+    if (!heartbeat.beginInterval()) {
+        qWarning() << "GameController: no heartbeat from server for" << Heartbeat::MAX_MISSED << "intervals, dropping connection.";
+        heartbeatTimer->stop();
+        abortDevice();
+        return;
+    }
+    sendTypedMessage("PING_MSG", QVariant(Heartbeat::nowMs()));
+}
+
+void GameController::setClock(GameClock *c)
+{
+    clock = c ? c : GameClock::system();
+}
+
+void GameController::abortDevice()
+{
+    if (socket) {
+        socket->abort();
+    } else if (device) {
+        device->close();
+    }
+}
+
+void GameController::connectToServer()
+{
+    if (!socket) {
+        qWarning() << "GameController::connectToServer: using an injected transport, nothing to connect.";
+        return;
+    }
+    if (socket->state() != QAbstractSocket::UnconnectedState) {
+        qWarning() << "GameController::connectToServer: Socket not in unconnected state, current state:" << socket->state();
+        if (isConnected) {
+            qInfo() << "Already connected.";
+            return;
+        }
+        if (socket->state() == QAbstractSocket::HostLookupState
+            || socket->state() == QAbstractSocket::ConnectingState) {
+            qInfo() << "Connection attempt already in progress.";
+            return;
+        }
+        socket->abort();
+    }
+
+    qDebug() << "GameController: Connecting to server:" << host << ":" << port;
+    expectedBytes = 0;
+    socket->connectToHost(host, port);
+
+    const int attempt = ++connectAttempt;
+    clock->singleShot(CONNECT_TIMEOUT_MS, this, [this, attempt]() {
+        if (attempt != connectAttempt) return;
+        if (!isConnected && socket->state() == QAbstractSocket::ConnectingState) {
+            socket->abort();
+            qCritical() << "GameController: Connection timeout to" << host << ":" << port;
+            if (eventsHeld) return;
+            emit serverMessageReceived(tr("连接服务器超时"));
+            emit connectionStatusChanged(false);
+            emit updateGamePhase(ControlPanel::GamePhase::WAITING, tr("连接超时，请重试"));
+        }
+    });
+}
+
+void GameController::sendTypedMessage(const QString& messageType, const QVariant& payload1, const QVariant& payload2) {
+    if (!isConnected || !device || !device->isOpen()) {
+        qWarning() << "GameController: Cannot send [" << messageType << "]. Not connected.";
+        emit serverMessageReceived(tr("未连接到服务器，无法发送消息。"));
+        return;
+    }
+
+    QByteArray block = Protocol::encodeFrame(messageType, payload1, payload2);
+    if (block.isEmpty()) {
+        qWarning() << "GameController: Failed to encode message [" << messageType << "].";
+        return;
+    }
+
+    qint64 bytesWritten = device->write(block);
+    if (bytesWritten == -1) {
+        qWarning() << "GameController: Failed to write to socket for message [" << messageType << "]. Error:" << device->errorString();
+    } else if (bytesWritten < block.size()) {
+        qWarning() << "GameController: Not all bytes written for message [" << messageType << "]. Wrote" << bytesWritten << "of" << block.size();
+        // Handle partial write, though for TCP this is less common unless buffer issues
+    } else {
+        if (socket) socket->flush(); // Ensure data is sent immediately
+        else if (QLocalSocket* localSocket = qobject_cast<QLocalSocket*>(device)) localSocket->flush();
+        qDebug() << "Client sent [" << messageType << "] size:" << block.size();
+    }
+
+}
+
+
+void GameController::sendReady()
+{
+    qDebug() << "Client sending READY_MSG. Connection status:" << isConnected;
+    sendTypedMessage("READY_MSG");
+}
+
+void GameController::sendPlaneOperation(int dice, int planeId, FlyPolicy policy)
+{
+    qDebug() << "Client sending PLANE_OP_MSG with dice:" << dice << "plane:" << planeId << "fly policy:" << int(policy);
+    if (policy == FlyPolicy::Ask) {
+        sendTypedMessage("PLANE_OP_MSG", QVariant(dice), QVariant(planeId));
+    } else {
+        sendTypedMessage("PLANE_OP_MSG", QVariant(dice), QVariantList{planeId, int(policy)});
+    }
+    lastPlaneId = planeId;
+
+    //与服务器跑同一份规则，先把预测结果显示出来
+    if (!model || !isConnected || playerId < 1 || playerId > 4) return;
+    const BoardPosition before = BoardPosition::fromTileStates(model->getBoardState());
+    BoardPosition after = before;
+    PlaneMove move;
+    const GameRules::MoveResult result = GameRules::applyMoveWithPath(after, playerId, dice, planeId, &move.path);
+    if (result != GameRules::MoveDone && result != GameRules::MoveCanFly) return;
+    move.globalPlaneId = (playerId - 1) * 4 + planeId;
+    predictMove(before, after, move);
+
+    if (result == GameRules::MoveCanFly && policy == FlyPolicy::Always) {
+        BoardPosition flown = after;
+        if (!GameRules::applyFly(flown, playerId, planeId)) return;
+        PlaneMove flyMove;
+        flyMove.globalPlaneId = move.globalPlaneId;
+        flyMove.path = { flown.tile[flyMove.globalPlaneId - 1] };
+        predictMove(after, flown, flyMove);
+    }
+}
+
+void GameController::sendFlyOverChoice(bool isYes)
+{
+    qDebug() << "Client sending FLY_OVER_MSG with choice:" << isYes;
+    sendTypedMessage("FLY_OVER_MSG", QVariant(isYes));
+
+    if (!isYes || !model || !isConnected || playerId < 1 || playerId > 4) return;
+    const BoardPosition before = BoardPosition::fromTileStates(model->getBoardState());
+    BoardPosition after = before;
+    if (!GameRules::applyFly(after, playerId, lastPlaneId)) return;
+    PlaneMove move;
+    move.globalPlaneId = (playerId - 1) * 4 + lastPlaneId;
+    move.path = { after.tile[move.globalPlaneId - 1] };
+    predictMove(before, after, move);
+}
+
+void GameController::predictMove(const BoardPosition &before, const BoardPosition &after, const PlaneMove &move)
+{
+    //上一次预测还没确认就以它为基准继续预测，回滚时回到最早的确认局面
+    if (predictions.isEmpty()) confirmedTiles = model->getBoardState();
+    Prediction prediction;
+    prediction.move = move;
+    prediction.move.captured = GameRules::capturedPlanes(before, after, move.globalPlaneId);
+    prediction.position = after;
+    predictions.append(prediction);
+
+    qDebug() << "Client: Predicted move for plane" << move.globalPlaneId << "path:" << move.path;
+    emit planeMoved(prediction.move);
+    model->setBoardState(after.toTileStates());
+}
+
+void GameController::rollbackPrediction()
+{
+    qWarning() << "Client: Prediction mismatch, rolling back to last confirmed state.";
+    predictions.clear();
+    if (model) model->setBoardState(confirmedTiles);
+    emit predictionResolved(false);
+}
+
+void GameController::requestHint(int dice)
+{
+    qDebug() << "Client sending HINT_MSG with dice:" << dice;
+    sendTypedMessage("HINT_MSG", QVariant(dice));
+}
+
+
+void GameController::dispatchEvent(int code, const QVariantList &args)
+{
+    if (code < 1 || code >= int(ServerEvent::EventCount)) {
+        qWarning() << "Client: Received unknown event code" << code << args;
+        return;
+    }
+    const EventEntry& entry = EVENT_TABLE[code - 1];
+    Q_ASSERT(int(entry.event) == code);
+    qDebug() << "Client: Received EVENT_MSG" << code << args;
+
+    if (entry.event == ServerEvent::Welcome) {
+        playerId = args.value(0).toInt();
+        roomId = args.value(1).toString();
+        seatToken = args.value(2).toString();
+        qDebug() << "Client: Assigned player id" << playerId << "in room" << roomId;
+    } else if (entry.event == ServerEvent::Spectating) {
+        spectating = true;
+        playerId = 0;
+        roomId = args.value(2).toString();
+    } else if (entry.event == ServerEvent::Error && !predictions.isEmpty()) {
+        //服务器拒绝了操作，预测作废
+        rollbackPrediction();
+    }
+
+    const QString uiMessage = entry.text(args);
+    emit serverMessageReceived(uiMessage);
+    //观众始终停留在等待阶段，所有操作按钮保持禁用
+    if (entry.setsPhase && (!spectating || entry.event == ServerEvent::Spectating)) {
+        emit updateGamePhase(entry.phase, uiMessage);
+    }
+}
+
+void GameController::setServer(const QString &h, int p)
+{
+    if (h == host && p == port) return;
+    qDebug() << "GameController: Switching target server to" << h << ":" << p;
+    if (socket && socket->state() != QAbstractSocket::UnconnectedState) {
+        //先改状态再断开，避免 handleDisconnected 当成掉线处理
+        const bool wasConnected = isConnected;
+        isConnected = false;
+        ++connectAttempt;
+        socket->abort();
+        if (wasConnected && !eventsHeld) emit connectionStatusChanged(false);
+    }
+    host = h;
+    port = p;
+    playerId = 0;
+    spectating = false;
+    roomId.clear();
+    seatToken.clear();
+    expectedBytes = 0;
+}
+
+void GameController::preconnect(const QString &h, int p)
+{
+    if (!socket) return;
+    setServer(h, p);
+    if (socket->state() == QAbstractSocket::UnconnectedState) {
+        qDebug() << "GameController: Pre-connecting to" << host << ":" << port;
+        connectToServer();
+    }
+}
+
+void GameController::setEventsHeld(bool held)
+{
+    if (eventsHeld == held) return;
+    eventsHeld = held;
+    if (held) return;
+
+    //把暂存期间发生的事补发出去
+    if (isConnected) announceConnected();
+    if (device && device->bytesAvailable() > 0) handleReadyRead();
+}
+
+void GameController::handleConnected()
+{
+    ++connectAttempt; // 作废挂起的连接超时
+
+    qInfo() << "GameController: Successfully connected to server:" << host << ":" << port;
+    isConnected = true;
+    if (eventsHeld) {
+        qDebug() << "GameController: Connected while events are held, announcing later.";
+        return;
+    }
+    announceConnected();
+}
+
+void GameController::setTableSize(int size)
+{
+    tableSize = size;
+}
+
+void GameController::sendMatchRequest()
+{
+    //断线重连时凭座位凭据回到原来的房间和座位（单桌服务器的房间号为空），否则由自动匹配的服务器分组；
+    //服务器收到这条消息才让本连接入座
+    if (!roomId.isEmpty() || !seatToken.isEmpty()) {
+        sendTypedMessage("ROOM_MSG", QVariant(roomId), seatToken.isEmpty() ? QVariant() : QVariant(seatToken));
+    } else {
+        sendTypedMessage("MATCH_MSG", QVariant(tableSize));
+    }
+    //服务器的大厅把第一条消息当作匹配请求，心跳要在它之后才开始
+    startHeartbeat();
+}
+
+void GameController::announceConnected()
+{
+    sendMatchRequest();
+    emit connectionStatusChanged(true);
+    emit serverMessageReceived(tr("已连接到服务器."));
+    emit updateGamePhase(ControlPanel::GamePhase::LOBBY, tr("已连接，等待其他玩家准备..."));
+}
+
+void GameController::handleReadyRead()
+{
+    qDebug() << "Client: handleReadyRead() triggered. Bytes available:" << device->bytesAvailable();
+    if (eventsHeld) return; // 留在缓冲区，解除暂存时再处理
+    inStream.setVersion(QDataStream::Qt_6_5);
+
+    forever {
+        qDebug() << "Client: Top of forever loop. expectedBytes:" << expectedBytes << "Bytes available:" << device->bytesAvailable() << "Stream status:" << inStream.status();
+        if (expectedBytes == 0) {
+            if (device->bytesAvailable() < sizeof(quint32)) {
+                qDebug() << "Client: Not enough data for size yet. Have" << device->bytesAvailable() << "need" << sizeof(quint32) << ". Returning.";
+                return;
+            }
+            inStream >> expectedBytes;
+            qDebug() << "Client: Expecting" << expectedBytes << "bytes from server.";
+        }
+
+        if (device->bytesAvailable() < expectedBytes) {
+            qDebug() << "Client: Not enough data yet. Have" << device->bytesAvailable() << "need" << expectedBytes;
+            return;
+        }
+
+        QString messageType;
+        inStream >> messageType;
+        if (inStream.status() != QDataStream::Ok) {
+            qWarning() << "Client: QDataStream error while reading messageType.";
+            abortDevice(); expectedBytes = 0; return;
+        }
+        qDebug() << "Client: Received message type:" << messageType;
+        heartbeat.peerAlive();
+
+        if (messageType == "GAME_STATE_MSG") {
+            QVariant gameStatePayload;
+            inStream >> gameStatePayload;
+            if (inStream.status() != QDataStream::Ok || !gameStatePayload.canConvert<GameState>()) {
+                qWarning() << "Client: QDataStream error or type mismatch reading GAME_STATE_MSG payload.";
+                abortDevice(); expectedBytes = 0; return;
+            }
+            GameState receivedState = gameStatePayload.value<GameState>();
+            qDebug() << "Client: Received GAME_STATE_MSG, map size:" << receivedState.getTileStates().size();
+            bool keepPrediction = false;
+            if (!predictions.isEmpty()) {
+                //预测正确时写入权威状态不会产生任何格子变化，也就不会重绘
+                const bool matched = BoardPosition::fromTileStates(receivedState.getTileStates())
+                                     == predictions.first().position;
+                qDebug() << "Client: Prediction" << (matched ? "confirmed" : "rejected") << "by server state.";
+                if (matched) {
+                    predictions.removeFirst();
+                    confirmedTiles = receivedState.getTileStates();
+                    //后面还有已预测的步骤时继续显示预测的最终局面
+                    keepPrediction = !predictions.isEmpty();
+                } else {
+                    predictions.clear();
+                }
+                emit predictionResolved(matched);
+            }
+            if (model && !keepPrediction) model->setBoardState(receivedState.getTileStates());
+            emit gameStateUpdated(receivedState.getTileStates());
+        } else if (messageType == "EVENT_MSG") {
+            QVariant eventPayload, argsPayload;
+            inStream >> eventPayload >> argsPayload;
+            if (inStream.status() != QDataStream::Ok) {
+                qWarning() << "Client: QDataStream error while reading EVENT_MSG payload.";
+                abortDevice(); expectedBytes = 0; return;
+            }
+            dispatchEvent(eventPayload.toInt(), argsPayload.toList());
+        } else if (messageType == "TEXT_MSG") {
+            //自由文本只做展示，不影响游戏阶段
+            QVariant textPayload;
+            inStream >> textPayload;
+            if (inStream.status() != QDataStream::Ok) {
+                qWarning() << "Client: QDataStream error while reading TEXT_MSG QVariant payload.";
+                abortDevice(); expectedBytes = 0; return;
+            }
+            qDebug() << "Client: Received TEXT_MSG content:" << textPayload.toString();
+            emit serverMessageReceived(textPayload.toString());
+        } else if (messageType == "PLANE_MOVE_MSG") {
+            QVariant movePayload;
+            inStream >> movePayload;
+            if (inStream.status() != QDataStream::Ok) {
+                qWarning() << "Client: QDataStream error while reading PLANE_MOVE_MSG payload.";
+                abortDevice(); expectedBytes = 0; return;
+            }
+            const PlaneMove move = PlaneMove::fromVariant(movePayload);
+            qDebug() << "Client: Received PLANE_MOVE_MSG plane:" << move.globalPlaneId << "path:" << move.path;
+            if (!predictions.isEmpty() && !predictions.first().animated
+                && move.globalPlaneId == predictions.first().move.globalPlaneId
+                && move.path == predictions.first().move.path) {
+                predictions.first().animated = true; // 已经按预测播放过了
+            } else {
+                //与预测不符：先退回确认局面，再按服务器的路径播放
+                if (!predictions.isEmpty()) rollbackPrediction();
+                emit planeMoved(move);
+            }
+        } else if (messageType == "PING_MSG" || messageType == "PONG_MSG") {
+            QVariant timePayload;
+            inStream >> timePayload;
+            if (inStream.status() != QDataStream::Ok) {
+                qWarning() << "Client: QDataStream error while reading" << messageType << "payload.";
+                abortDevice(); expectedBytes = 0; return;
+            }
+            if (messageType == "PING_MSG") {
+                sendTypedMessage("PONG_MSG", timePayload);
+            } else {
+                heartbeat.pongReceived(timePayload.toLongLong());
+                emit latencyUpdated(heartbeat.smoothedRttMs(), heartbeat.jitterMs());
+            }
+        } else if (messageType == "HINT_MSG") {
+            QVariant planePayload, flyPayload;
+            inStream >> planePayload >> flyPayload;
+            if (inStream.status() != QDataStream::Ok) {
+                qWarning() << "Client: QDataStream error while reading HINT_MSG payload.";
+                abortDevice(); expectedBytes = 0; return;
+            }
+            qDebug() << "Client: Received HINT_MSG plane:" << planePayload.toInt() << "fly:" << flyPayload.toBool();
+            emit hintReceived(planePayload.toInt(), flyPayload.toBool());
+        } else {
+            qWarning() << "Client: Received unknown message type from server:" << messageType;
+
+            QByteArray dummy = device->read(expectedBytes); // Attempt to read out the rest of the expected block
+            qDebug() << "Client: Discarded" << dummy.size() << "bytes for unknown message type.";
+        }
+        expectedBytes = 0;
+
+        if(inStream.status() != QDataStream::Ok && device->isOpen()){
+            qWarning() << "Client: QDataStream not OK after processing message. Aborting.";
+            abortDevice();
+            return;
+        }
+
+        if (device->bytesAvailable() == 0) break;
+    }
+}
+
+
+void GameController::handleError(QAbstractSocket::SocketError socketError)
+{
+    ++connectAttempt;
+
+    QString errorMsg;
+    if (socketError == QAbstractSocket::RemoteHostClosedError) {
+        errorMsg = tr("连接被服务器关闭.");
+    } else if (socketError == QAbstractSocket::ConnectionRefusedError) {
+        errorMsg = tr("连接被服务器拒绝. 请确认服务器正在运行并且地址正确.");
+    } else if (socketError == QAbstractSocket::HostNotFoundError) {
+        errorMsg = tr("找不到服务器主机. 请检查主机名或IP地址.");
+    } else {
+        errorMsg = socket->errorString();
+    }
+
+    qCritical() << "GameController: Network error occurred:" << socketError << errorMsg;
+    if (eventsHeld) {
+        //预连接失败不打扰用户，正式连接时会重试
+        isConnected = false;
+        return;
+    }
+    emit serverMessageReceived(tr("网络错误: %1").arg(errorMsg));
+    if (isConnected) {
+        isConnected = false;
+        emit connectionStatusChanged(false);
+    }
+    emit updateGamePhase(ControlPanel::GamePhase::WAITING, tr("网络错误: %1").arg(errorMsg));
+}
+
+void GameController::handleDisconnected()
+{
+    qInfo() << "GameController: Disconnected from server.";
+    ++connectAttempt;
+    heartbeatTimer->stop();
+    bool wasConnected = isConnected;
+    isConnected = false;
+    expectedBytes = 0;
+    //连接断了，未确认的预测不会再有结果
+    if (!predictions.isEmpty()) rollbackPrediction();
+    if (eventsHeld) return;
+
+    if (wasConnected) {
+        emit serverMessageReceived(tr("已从服务器断开连接."));
+        emit connectionStatusChanged(false);
+        emit updateGamePhase(ControlPanel::GamePhase::WAITING, tr("已断开连接. 请尝试重新连接."));
+    } else {
+        if (socket && socket->error() == QAbstractSocket::RemoteHostClosedError) {
+            qDebug() << "GameController: Disconnected, but wasNotConnected or error already handled. Socket error:" << socket->errorString();
+            emit serverMessageReceived(tr("连接被服务器关闭."));
+        } else {
+            emit serverMessageReceived(tr("连接已关闭."));
+        }
+        emit updateGamePhase(ControlPanel::GamePhase::WAITING, tr("连接已关闭."));
+    }
+}
+
+void GameController::closeConnection()
+{
+    qDebug() << "GameController: closeConnection() called. Current state:" << (socket ? socket->state() : -1) << "isConnected:" << isConnected;
+    if (socket && socket->state() != QAbstractSocket::UnconnectedState) {
+        socket->abort();
+    } else if (!socket && device && device->isOpen()) {
+        device->close();
+    }
+
+    bool oldStatus = isConnected;
+    isConnected = false;
+    expectedBytes = 0;
+    heartbeatTimer->stop();
+
+    if (oldStatus) {
+        emit connectionStatusChanged(false);
+    }
+    qDebug() << "GameController: Connection resources cleaned up.";
+}
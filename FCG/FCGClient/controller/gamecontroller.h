@@ -1,59 +1,126 @@
-#ifndef GAMECONTROLLER_H
-#define GAMECONTROLLER_H
-
-#include <QTcpSocket>
-#include <QDataStream>
-#include "mainview.h"
-//#include <view/controlpanel.h>
-#include <model/gamemodel.h>
-#include <QObject>
-#include <QTimer>
-#include <QVariant>
-
-class ControlPanel;
-class MainView;
-
-class GameController : public QObject
-{
-    Q_OBJECT
-
-public:
-    explicit GameController(GameModel* model ,const QString& host,int port,QObject* parent = nullptr);
-    ~GameController();
-    void setView(MainView* view);
-    void connectToServer();
-
-
-public slots:
-    void sendReady();
-    void sendPlaneOperation(int dice ,int planeId);
-    void sendFlyOverChoice(bool isYes);
-    void closeConnection();
-
-signals:
-    void gameStateUpdated(const QMap<int,QList<int>> & tileStates);
-    void serverMessageReceived(const QString& message);
-    void connectionStatusChanged(bool connected);
-    void updateGamePhase(ControlPanel::GamePhase phase , const QString& message);
-
-private slots:
-    void handleConnected();
-    void handleReadyRead();
-    void handleError(QAbstractSocket::SocketError error);
-    void handleDisconnected();
-
-private:
-    GameModel* model;
-    MainView* view;
-    QTcpSocket* socket;
-    QDataStream inStream;
-    QString host;
-    int port;
-    bool isConnected;
-    quint32 expectedBytes = 0;
-    QTimer* connectTimer = nullptr;
-
-    void sendTypedMessage(const QString& messageType, const QVariant& payload1 = QVariant(), const QVariant& payload2 = QVariant());
-};
-
-#endif // GAMECONTROLLER_H
+#ifndef GAMECONTROLLER_H
+#define GAMECONTROLLER_H
+
+#include <QTcpSocket>
+#include <QDataStream>
+#include "mainview.h"
+#include "gameclock.h"
+#include "heartbeat.h"
+//#include <view/controlpanel.h>
+#include <model/gamemodel.h>
+#include <model/protocol.h>
+#include <model/gamerules.h>
+#include <QObject>
+#include <QTimer>
+#include <QVariant>
+
+class ControlPanel;
+class MainView;
+
+class GameController : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit GameController(GameModel* model ,const QString& host,int port,QObject* parent = nullptr);
+    // 使用已建立好的传输通道（如内存管道），不经过 TCP 连接；通道需提供 disconnected() 信号
+    GameController(GameModel* model, QIODevice* transport, QObject* parent = nullptr);
+    ~GameController();
+    void setView(MainView* view);
+    void setClock(GameClock* clock);
+    GameModel* getModel() const;
+    // 服务器分配的座位号（1~4），收到欢迎消息前为 0
+    int getPlayerId() const;
+    void connectToServer();
+    // 更换目标服务器；已有的连接（包括预连接）指向别处时会被断开
+    void setServer(const QString& host, int port);
+    // 暂存事件：期间连接照常建立，但收到的数据留在 socket 缓冲区里，不发出任何信号，
+    // 界面就绪后解除暂存，再一次性处理
+    void setEventsHeld(bool held);
+    // 希望的每桌人数（2~4），0 表示由服务器决定；连接建立后随 MATCH_MSG 发出
+    void setTableSize(int size);
+    // 心跳测得的平滑往返时延与抖动（毫秒），还没有测量时为 -1
+    int getRttMs() const;
+    int getJitterMs() const;
+
+
+public slots:
+    void sendReady();
+    // policy 不是 Ask 时一并告诉服务器落在同色格后是否飞跃，省掉一次来回
+    void sendPlaneOperation(int dice ,int planeId, FlyPolicy policy = FlyPolicy::Ask);
+    void sendFlyOverChoice(bool isYes);
+    void requestHint(int dice);
+    // 发出 MATCH_MSG（已知房间号或座位凭据时为 ROOM_MSG）并开始心跳；TCP 连接建立后自动调用，
+    // 注入的传输（本地套接字等）由调用方在合适时机调用
+    void sendMatchRequest();
+    void closeConnection();
+    // 连接对话框里输入了有效地址后预先建立连接，正式连接时直接复用；
+    // 暂存事件期间不发匹配请求，服务器不会为预连接安排座位，长时间不用会被服务器断开
+    void preconnect(const QString& host, int port);
+
+signals:
+    void gameStateUpdated(const QMap<int,QList<int>> & tileStates);
+    void serverMessageReceived(const QString& message);
+    void connectionStatusChanged(bool connected);
+    void updateGamePhase(ControlPanel::GamePhase phase , const QString& message);
+    void hintReceived(int planeId, bool fly);
+    void planeMoved(const PlaneMove& move);
+    // 本地预测的局面与服务器结果比较完毕；matched 为 false 表示已回滚到服务器状态
+    void predictionResolved(bool matched);
+    // 每收到一次 PONG 更新
+    void latencyUpdated(int rttMs, int jitterMs);
+
+private slots:
+    void handleConnected();
+    void handleReadyRead();
+    void handleError(QAbstractSocket::SocketError error);
+    void handleDisconnected();
+    void sendHeartbeat();
+
+private:
+    GameModel* model;
+    MainView* view;
+    QTcpSocket* socket;     // 仅 TCP 模式下非空
+    QIODevice* device;      // 当前收发数据的通道
+    GameClock* clock;
+    QDataStream inStream;
+    QString host;
+    int port;
+    bool isConnected;
+    quint32 expectedBytes = 0;
+    int connectAttempt = 0; // 每次连接/断开都会递增，用于作废过期的连接超时回调
+    int playerId = 0;
+    bool spectating = false;    // 座位已满时以观众身份连接
+    int tableSize = 0;
+    QString roomId;             // 服务器在欢迎消息里给出，重连时用 ROOM_MSG 回到该房间
+    QString seatToken;          // 同样在欢迎消息里给出，随 ROOM_MSG 发回，回到原来的座位
+    bool eventsHeld = false;
+
+    //心跳只在网络连接上进行（TCP、本地套接字、多路复用会话），内存管道不发
+    QTimer* heartbeatTimer;
+    Heartbeat heartbeat;
+    bool networked = false;
+    void startHeartbeat();
+
+    //乐观预测：发出操作后立即用共享规则算出结果显示，等服务器的权威状态到达再核对
+    //一次操作可能对应多步（移动后直接飞跃），服务器按同样顺序发 PLANE_MOVE_MSG 与 GAME_STATE_MSG
+    struct Prediction
+    {
+        PlaneMove move;
+        BoardPosition position;
+        bool animated = false;  // 服务器的 PLANE_MOVE_MSG 与预测一致，不再重复播放动画
+    };
+    QList<Prediction> predictions;
+    QMap<int, QList<int>> confirmedTiles; // 最后一次确认的局面，用于回滚
+    int lastPlaneId = 0;
+
+    void predictMove(const BoardPosition& before, const BoardPosition& after, const PlaneMove& move);
+    void rollbackPrediction();
+
+    void abortDevice();
+    void announceConnected();
+    void dispatchEvent(int code, const QVariantList& args);
+    void sendTypedMessage(const QString& messageType, const QVariant& payload1 = QVariant(), const QVariant& payload2 = QVariant());
+};
+
+#endif // GAMECONTROLLER_H
@@ -0,0 +1,51 @@
+#include "heartbeat.h"
+#include <QElapsedTimer>
+#include <QtMath>
+
+qint64 Heartbeat::nowMs()
+{
+    static QElapsedTimer timer = [] { QElapsedTimer t; t.start(); return t; }();
+    return timer.elapsed();
+}
+
+bool Heartbeat::beginInterval()
+{
+    if (sampleCount > 0 && missed >= MAX_MISSED) return false;
+    missed++;
+    return true;
+}
+
+void Heartbeat::peerAlive()
+{
+    missed = 0;
+}
+
+void Heartbeat::pongReceived(qint64 sentMs)
+{
+    peerAlive();
+    const qint64 rtt = nowMs() - sentMs;
+    if (rtt < 0) return; // 不是本端发出的时刻
+    if (sampleCount == 0) {
+        srtt = double(rtt);
+        rttvar = double(rtt) / 2;
+    } else {
+        rttvar = 0.75 * rttvar + 0.25 * qAbs(srtt - double(rtt));
+        srtt = 0.875 * srtt + 0.125 * double(rtt);
+    }
+    sampleCount++;
+}
+
+int Heartbeat::smoothedRttMs() const
+{
+    return sampleCount > 0 ? qRound(srtt) : -1;
+}
+
+int Heartbeat::jitterMs() const
+{
+    return sampleCount > 0 ? qRound(rttvar) : -1;
+}
+
+int Heartbeat::samples() const
+{
+    return sampleCount;
+}
@@ -0,0 +1,38 @@
+#ifndef HEARTBEAT_H
+#define HEARTBEAT_H
+
+#include <QtGlobal>
+
+// 心跳：两端每隔 INTERVAL_MS 发一次 PING_MSG(发送方时刻)，对方原样回 PONG_MSG，
+// 发送方据此估计往返时延。收到对方的任何消息都说明对方还活着；
+// 对方回应过至少一次 PONG 后，连续 MAX_MISSED 个周期没有任何消息就视为断线。
+// 旧版本不回应 PONG，因而不会被误判。不加锁，由所属连接在自己的线程中使用
+class Heartbeat
+{
+public:
+    static constexpr int INTERVAL_MS = 5000;
+    static constexpr int MAX_MISSED = 3;
+
+    // 单调时钟，PING 中携带的时刻只对发送方自己有意义
+    static qint64 nowMs();
+
+    // 发 PING 之前调用；返回 false 表示对方已经连续错过 MAX_MISSED 个周期，应当断开
+    bool beginInterval();
+    // 收到对方任何消息
+    void peerAlive();
+    // 收到 PONG，sentMs 为对应 PING 的发送时刻
+    void pongReceived(qint64 sentMs);
+
+    // 平滑往返时延与抖动（RFC 6298 的做法），还没有样本时为 -1
+    int smoothedRttMs() const;
+    int jitterMs() const;
+    int samples() const;
+
+private:
+    double srtt = 0;
+    double rttvar = 0;
+    int sampleCount = 0;
+    int missed = 0;
+};
+
+#endif // HEARTBEAT_H
@@ -0,0 +1,187 @@
+#include "memorytransport.h"
+#include <QMetaObject>
+#include <QPointer>
+#include <cstring>
+
+QPair<MemoryPipe *, MemoryPipe *> MemoryPipe::createPair(MemoryNetwork *network)
+{
+    MemoryPipe* first = new MemoryPipe(network);
+    MemoryPipe* second = new MemoryPipe(network);
+    first->m_peer = second;
+    second->m_peer = first;
+    first->open(QIODevice::ReadWrite | QIODevice::Unbuffered);
+    second->open(QIODevice::ReadWrite | QIODevice::Unbuffered);
+    return qMakePair(first, second);
+}
+
+MemoryPipe::MemoryPipe(MemoryNetwork *network)
+    : QIODevice(nullptr), m_network(network)
+{
+}
+
+MemoryPipe::~MemoryPipe()
+{
+    if (m_network) {
+        m_network->remove(this);
+    }
+    if (m_peer) {
+        MemoryPipe* peer = m_peer;
+        peer->m_peer = nullptr;
+        m_peer = nullptr;
+        if (!m_closeSent) {
+            // 与 socket 被销毁时一样，对端稍后收到断开通知
+            QMetaObject::invokeMethod(peer, [peer]() { peer->peerClosed(); }, Qt::QueuedConnection);
+        }
+    }
+}
+
+bool MemoryPipe::isSequential() const
+{
+    return true;
+}
+
+qint64 MemoryPipe::bytesAvailable() const
+{
+    return m_inbox.size() + QIODevice::bytesAvailable();
+}
+
+void MemoryPipe::close()
+{
+    if (!isOpen()) return;
+    m_closePending = true;
+    QIODevice::close();
+    scheduleDelivery();
+}
+
+qint64 MemoryPipe::readData(char *data, qint64 maxSize)
+{
+    const qint64 n = qMin<qint64>(maxSize, m_inbox.size());
+    if (n <= 0) return 0;
+    memcpy(data, m_inbox.constData(), n);
+    m_inbox.remove(0, n);
+    return n;
+}
+
+qint64 MemoryPipe::writeData(const char *data, qint64 maxSize)
+{
+    if (!m_peer) {
+        return maxSize; // 对端已不存在，丢弃
+    }
+    m_outbox.append(data, maxSize);
+    scheduleDelivery();
+    emit bytesWritten(maxSize);
+    return maxSize;
+}
+
+bool MemoryPipe::hasPendingOutput() const
+{
+    return !m_outbox.isEmpty() || (m_closePending && !m_closeSent);
+}
+
+void MemoryPipe::scheduleDelivery()
+{
+    if (m_network) {
+        m_network->enqueue(this);
+        return;
+    }
+    if (m_deliveryQueued) return;
+    m_deliveryQueued = true;
+    QMetaObject::invokeMethod(this, [this]() {
+        m_deliveryQueued = false;
+        deliver();
+    }, Qt::QueuedConnection);
+}
+
+void MemoryPipe::deliver(qint64 maxBytes)
+{
+    MemoryPipe* peer = m_peer;
+    if (!peer) {
+        m_outbox.clear();
+        m_closeSent = true;
+        return;
+    }
+
+    if (!m_outbox.isEmpty()) {
+        const qint64 n = (maxBytes <= 0) ? m_outbox.size() : qMin<qint64>(maxBytes, m_outbox.size());
+        peer->m_inbox.append(m_outbox.constData(), n);
+        m_outbox.remove(0, n);
+        emit peer->readyRead();
+        if (!m_outbox.isEmpty()) return;
+    }
+
+    if (m_closePending && !m_closeSent) {
+        m_closeSent = true;
+        peer->peerClosed();
+    }
+}
+
+void MemoryPipe::peerClosed()
+{
+    m_closeSent = true; // 对端已关闭，不再回发关闭通知
+    m_peer = nullptr;
+    QIODevice::close();
+    emit disconnected(); // 槽函数里可能删除本对象，之后不再访问成员
+}
+
+MemoryNetwork::MemoryNetwork(quint32 seed)
+    : rng(seed)
+{
+}
+
+MemoryNetwork::~MemoryNetwork()
+{
+    for (MemoryPipe* pipe : std::as_const(pending)) {
+        pipe->m_network = nullptr;
+    }
+}
+
+void MemoryNetwork::setFragmentation(bool enabled)
+{
+    fragmentation = enabled;
+}
+
+bool MemoryNetwork::hasPending() const
+{
+    return !pending.isEmpty();
+}
+
+quint64 MemoryNetwork::deliveredChunks() const
+{
+    return chunks;
+}
+
+bool MemoryNetwork::deliverOne()
+{
+    if (pending.isEmpty()) return false;
+
+    const int index = rng.bounded(int(pending.size()));
+    MemoryPipe* pipe = pending.at(index);
+    qint64 maxBytes = 0;
+    if (fragmentation && pipe->m_outbox.size() > 1) {
+        maxBytes = 1 + rng.bounded(int(pipe->m_outbox.size()));
+    }
+    if (!pipe->hasPendingOutput()) {
+        pending.removeAt(index);
+        return true;
+    }
+    ++chunks;
+    // deliver 会同步触发对端槽函数，槽函数里可能销毁管道或增删 pending，这里按指针重新查找
+    QPointer<MemoryPipe> guard(pipe);
+    pipe->deliver(maxBytes);
+    if (guard && !guard->hasPendingOutput()) {
+        pending.removeOne(pipe);
+    }
+    return true;
+}
+
+void MemoryNetwork::enqueue(MemoryPipe *pipe)
+{
+    if (!pending.contains(pipe)) {
+        pending.append(pipe);
+    }
+}
+
+void MemoryNetwork::remove(MemoryPipe *pipe)
+{
+    pending.removeAll(pipe);
+}
@@ -0,0 +1,78 @@
+#ifndef MEMORYTRANSPORT_H
+#define MEMORYTRANSPORT_H
+
+#include <QIODevice>
+#include <QByteArray>
+#include <QList>
+#include <QPair>
+#include <QRandomGenerator>
+
+class MemoryNetwork;
+
+// 内存中的双工管道的一端，行为上模拟一个已连接的 socket：
+// 写入的数据进入对端的接收缓冲区并触发对端 readyRead，close() 后对端收到 disconnected()。
+// 没有挂接 MemoryNetwork 时通过事件循环异步投递；挂接后由 MemoryNetwork 决定投递顺序和分片。
+class MemoryPipe : public QIODevice
+{
+    Q_OBJECT
+public:
+    static QPair<MemoryPipe*, MemoryPipe*> createPair(MemoryNetwork* network = nullptr);
+    ~MemoryPipe() override;
+
+    bool isSequential() const override;
+    qint64 bytesAvailable() const override;
+    void close() override;
+
+signals:
+    void disconnected();
+
+protected:
+    qint64 readData(char* data, qint64 maxSize) override;
+    qint64 writeData(const char* data, qint64 maxSize) override;
+
+private:
+    friend class MemoryNetwork;
+    explicit MemoryPipe(MemoryNetwork* network);
+
+    // 把待发数据中最多 maxBytes 字节交给对端（<=0 表示全部）
+    void deliver(qint64 maxBytes = 0);
+    bool hasPendingOutput() const;
+    void scheduleDelivery();
+    void peerClosed();
+
+    MemoryPipe* m_peer = nullptr;
+    MemoryNetwork* m_network = nullptr;
+    QByteArray m_inbox;
+    QByteArray m_outbox;
+    bool m_deliveryQueued = false;
+    bool m_closePending = false;
+    bool m_closeSent = false;
+};
+
+// 管道投递调度器：每次随机挑一个有待发数据的管道投递一段，
+// 同一管道内保持先后顺序，不同管道之间的先后由随机种子决定，可复现。
+class MemoryNetwork
+{
+public:
+    explicit MemoryNetwork(quint32 seed = 1);
+    ~MemoryNetwork();
+
+    // 开启后每次只投递随机长度的一段，用于测试分帧/粘包处理
+    void setFragmentation(bool enabled);
+
+    bool hasPending() const;
+    bool deliverOne();
+    quint64 deliveredChunks() const;
+
+private:
+    friend class MemoryPipe;
+    void enqueue(MemoryPipe* pipe);
+    void remove(MemoryPipe* pipe);
+
+    QList<MemoryPipe*> pending;
+    QRandomGenerator rng;
+    bool fragmentation = false;
+    quint64 chunks = 0;
+};
+
+#endif // MEMORYTRANSPORT_H
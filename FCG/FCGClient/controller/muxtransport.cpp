@@ -0,0 +1,231 @@
+#include "muxtransport.h"
+#include <QDebug>
+#include <QtEndian>
+#include <cstring>
+
+namespace {
+// 会话号 + 类型
+const int MUX_HEADER_BYTES = 5;
+// 单个外层帧的上限，超过说明流已经错位
+const quint32 MAX_MUX_FRAME = 16 * 1024 * 1024;
+}
+
+MuxChannel::MuxChannel(quint32 sessionId, QObject *parent)
+    : QIODevice(parent), id(sessionId)
+{
+    open(QIODevice::ReadWrite | QIODevice::Unbuffered);
+}
+
+MuxChannel::~MuxChannel()
+{
+    //与 socket 被销毁时一样，对端稍后收到断开通知
+    if (!closeSent) {
+        closeSent = true;
+        emit chunkReady(id, MuxConnection::CloseFrame, QByteArray());
+    }
+}
+
+quint32 MuxChannel::sessionId() const
+{
+    return id;
+}
+
+bool MuxChannel::isSequential() const
+{
+    return true;
+}
+
+qint64 MuxChannel::bytesAvailable() const
+{
+    return inbox.size() + QIODevice::bytesAvailable();
+}
+
+void MuxChannel::close()
+{
+    if (!isOpen()) return;
+    QIODevice::close();
+    if (!closeSent) {
+        closeSent = true;
+        emit chunkReady(id, MuxConnection::CloseFrame, QByteArray());
+    }
+    //与 abort() 后的 socket 一样发出断开信号；排队发出，调用方此时可能还在读数据
+    QMetaObject::invokeMethod(this, &MuxChannel::disconnected, Qt::QueuedConnection);
+}
+
+qint64 MuxChannel::readData(char *data, qint64 maxSize)
+{
+    const qint64 n = qMin<qint64>(maxSize, inbox.size());
+    if (n <= 0) return 0;
+    memcpy(data, inbox.constData(), n);
+    inbox.remove(0, n);
+    return n;
+}
+
+qint64 MuxChannel::writeData(const char *data, qint64 maxSize)
+{
+    if (closeSent) return maxSize; // 对端已关闭，丢弃
+    emit chunkReady(id, MuxConnection::DataFrame, QByteArray(data, int(maxSize)));
+    emit bytesWritten(maxSize);
+    return maxSize;
+}
+
+void MuxChannel::receive(const QByteArray &data)
+{
+    if (!isOpen()) return;
+    inbox.append(data);
+    emit readyRead();
+}
+
+void MuxChannel::remoteClosed()
+{
+    if (closeSent) return;
+    closeSent = true; // 对端已关闭，不再回发关闭通知
+    QIODevice::close();
+    emit disconnected(); // 槽函数里可能删除本对象，之后不再访问成员
+}
+
+MuxConnection::MuxConnection(QIODevice *link, QObject *parent)
+    : QObject(parent), device(link)
+{
+    device->setParent(this);
+    connect(device, &QIODevice::readyRead, this, &MuxConnection::readLink);
+    // QTcpSocket 与 QLocalSocket 都提供 disconnected()，这里按名字连接
+    connect(device, SIGNAL(disconnected()), this, SLOT(handleLinkClosed()));
+}
+
+MuxConnection::~MuxConnection()
+{
+    //还没被接管的通道是子对象，随本对象销毁；已移交的通道收到断开通知
+    closed = true;
+    const QList<MuxChannel*> owned = findChildren<MuxChannel*>(Qt::FindDirectChildrenOnly);
+    for (MuxChannel* channel : owned) {
+        delete routes.take(channel->sessionId());
+    }
+    for (MuxRoute* route : std::as_const(routes)) {
+        emit route->closed();
+    }
+}
+
+MuxChannel *MuxConnection::openChannel()
+{
+    const quint32 sessionId = nextSessionId++;
+    MuxChannel* channel = addChannel(sessionId);
+    sendChunk(sessionId, OpenFrame, QByteArray());
+    return channel;
+}
+
+int MuxConnection::channelCount() const
+{
+    return routes.size();
+}
+
+void MuxConnection::setChannelLimit(int limit)
+{
+    channelLimit = limit;
+}
+
+QIODevice *MuxConnection::link() const
+{
+    return device;
+}
+
+MuxChannel *MuxConnection::addChannel(quint32 sessionId)
+{
+    MuxChannel* channel = new MuxChannel(sessionId, this);
+    //通道可能被移到其他线程，写出的数据排队回到本线程；收到的数据经路由排队送到通道所在线程
+    connect(channel, &MuxChannel::chunkReady, this, &MuxConnection::sendChunk);
+    MuxRoute* route = new MuxRoute(this);
+    connect(route, &MuxRoute::received, channel, &MuxChannel::receive);
+    connect(route, &MuxRoute::closed, channel, &MuxChannel::remoteClosed);
+    routes.insert(sessionId, route);
+    return channel;
+}
+
+void MuxConnection::sendChunk(quint32 sessionId, quint8 kind, const QByteArray &data)
+{
+    if (kind == CloseFrame) {
+        //可能正处在这个路由发出的信号里，推迟删除
+        if (MuxRoute* route = routes.take(sessionId)) route->deleteLater();
+    }
+    if (closed || !device->isOpen()) return;
+
+    QByteArray frame;
+    frame.resize(sizeof(quint32) + MUX_HEADER_BYTES + data.size());
+    char* out = frame.data();
+    qToBigEndian<quint32>(quint32(MUX_HEADER_BYTES + data.size()), out);
+    qToBigEndian<quint32>(sessionId, out + 4);
+    out[8] = char(kind);
+    if (!data.isEmpty()) memcpy(out + 9, data.constData(), data.size());
+    device->write(frame);
+}
+
+void MuxConnection::readLink()
+{
+    forever {
+        if (expectedBytes == 0) {
+            if (device->bytesAvailable() < qint64(sizeof(quint32))) return;
+            char header[sizeof(quint32)];
+            device->read(header, sizeof(header));
+            expectedBytes = qFromBigEndian<quint32>(header);
+            if (expectedBytes < quint32(MUX_HEADER_BYTES) || expectedBytes > MAX_MUX_FRAME) {
+                qWarning() << "MuxConnection: invalid frame length" << expectedBytes << ", dropping link.";
+                expectedBytes = 0;
+                device->close();
+                handleLinkClosed();
+                return;
+            }
+        }
+        if (device->bytesAvailable() < expectedBytes) return;
+
+        const QByteArray frame = device->read(expectedBytes);
+        expectedBytes = 0;
+        const quint32 sessionId = qFromBigEndian<quint32>(frame.constData());
+        const quint8 kind = quint8(frame.at(4));
+        const QByteArray data = frame.mid(MUX_HEADER_BYTES);
+
+        if (kind == OpenFrame) {
+            if (routes.contains(sessionId)) {
+                qWarning() << "MuxConnection: session" << sessionId << "opened twice.";
+                continue;
+            }
+            if (channelLimit > 0 && routes.size() >= channelLimit) {
+                //对端照常收到关闭通知，不必等超时
+                if (refusedChannels++ % 100 == 0) {
+                    qWarning() << "MuxConnection: refusing session" << sessionId << ", link already has"
+                               << routes.size() << "sessions. Total refused:" << refusedChannels;
+                }
+                sendChunk(sessionId, CloseFrame, QByteArray());
+                continue;
+            }
+            emit channelOpened(addChannel(sessionId));
+            continue;
+        }
+
+        MuxRoute* route = routes.value(sessionId);
+        if (!route) {
+            //会话刚在本端关闭，对端还不知道
+            continue;
+        }
+        if (kind == CloseFrame) {
+            routes.remove(sessionId);
+            emit route->closed();
+            route->deleteLater();
+        } else {
+            emit route->received(data);
+        }
+    }
+}
+
+void MuxConnection::handleLinkClosed()
+{
+    if (closed) return;
+    closed = true;
+    qInfo() << "MuxConnection: link closed with" << routes.size() << "open sessions.";
+    const QList<MuxRoute*> open = routes.values();
+    routes.clear();
+    for (MuxRoute* route : open) {
+        emit route->closed();
+        route->deleteLater();
+    }
+    emit linkClosed();
+}
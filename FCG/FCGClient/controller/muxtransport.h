@@ -0,0 +1,108 @@
+#ifndef MUXTRANSPORT_H
+#define MUXTRANSPORT_H
+
+#include <QIODevice>
+#include <QByteArray>
+#include <QHash>
+
+class MuxConnection;
+
+// 多路复用连接上的一个会话，两端都表现为一个独立的已连接设备：
+// 写入的字节原样送到对端同号会话，对端关闭后发出 disconnected()。
+// 可以移到其他线程使用（例如服务器的房间线程），与 MuxConnection 之间只通过信号交互。
+class MuxChannel : public QIODevice
+{
+    Q_OBJECT
+public:
+    ~MuxChannel() override;
+
+    quint32 sessionId() const;
+    bool isSequential() const override;
+    qint64 bytesAvailable() const override;
+    void close() override;
+
+signals:
+    void disconnected();
+    // 内部使用：交给 MuxConnection 写到底层连接
+    void chunkReady(quint32 sessionId, quint8 kind, const QByteArray& data);
+
+protected:
+    qint64 readData(char* data, qint64 maxSize) override;
+    qint64 writeData(const char* data, qint64 maxSize) override;
+
+private:
+    friend class MuxConnection;
+    MuxChannel(quint32 sessionId, QObject* parent);
+
+    // 以下在本对象所在线程中执行
+    void receive(const QByteArray& data);
+    void remoteClosed();
+
+    quint32 id;
+    QByteArray inbox;
+    bool closeSent = false;
+};
+
+// 内部使用：留在 MuxConnection 所在线程，代表一个会话，把收到的数据与关闭通知以信号转给通道。
+// 通道在其他线程销毁时 Qt 自动断开这些连接，MuxConnection 从不直接访问可能已经销毁的通道
+class MuxRoute : public QObject
+{
+    Q_OBJECT
+signals:
+    void received(const QByteArray& data);
+    void closed();
+
+private:
+    friend class MuxConnection;
+    explicit MuxRoute(QObject* parent) : QObject(parent) {}
+};
+
+// 在一条底层连接（TCP 或本地套接字）上承载多个会话。
+// 外层帧：[quint32 长度][quint32 会话号][quint8 类型][数据]，长度包含会话号与类型；
+// 数据是该会话原样的字节流，里面仍是普通的协议帧。
+// 只有一端（网关、客户端）发起会话，另一端（服务器）通过 channelOpened 接收。
+class MuxConnection : public QObject
+{
+    Q_OBJECT
+public:
+    enum FrameKind : quint8 {
+        DataFrame = 0,
+        OpenFrame,
+        CloseFrame
+    };
+
+    // 接管 link 的所有权
+    explicit MuxConnection(QIODevice* link, QObject* parent = nullptr);
+    ~MuxConnection() override;
+
+    // 发起一个新会话，返回的通道归本对象所有，直到调用方重新设置父对象
+    MuxChannel* openChannel();
+    int channelCount() const;
+    // 对端最多同时打开的会话数，超出的 OpenFrame 直接回 CloseFrame；0 表示不限
+    void setChannelLimit(int limit);
+    QIODevice* link() const;
+
+signals:
+    // 对端发起的新会话
+    void channelOpened(MuxChannel* channel);
+    // 底层连接断开，所有会话都已收到 disconnected()
+    void linkClosed();
+
+private slots:
+    void readLink();
+    void handleLinkClosed();
+    void sendChunk(quint32 sessionId, quint8 kind, const QByteArray& data);
+
+private:
+    MuxChannel* addChannel(quint32 sessionId);
+
+    QIODevice* device;
+    QHash<quint32, MuxRoute*> routes;  // 会话号 -> 路由，任一方向的 CloseFrame 之后移除
+    quint32 nextSessionId = 1;
+    int channelLimit = 0;
+    qint64 refusedChannels = 0;
+    quint32 expectedBytes = 0;
+    bool closed = false;
+};
+
+#endif // MUXTRANSPORT_H
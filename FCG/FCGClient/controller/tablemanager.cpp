@@ -0,0 +1,56 @@
+#include "tablemanager.h"
+#include "gamecontroller.h"
+#include "muxtransport.h"
+#include "../mainview.h"
+#include "../model/gamemodel.h"
+#include "../model/protocol.h"
+#include <QTcpSocket>
+#include <QDebug>
+
+TableManager::TableManager(const QString &h, const QString &name, int size, QObject *parent)
+    : QObject(parent), host(h), username(name), tableSize(size)
+{
+}
+
+MuxConnection *TableManager::link()
+{
+    if (mux) return mux;
+
+    //所有附加的桌面共用这一条连接，连接断开后下次开桌时重建
+    QTcpSocket* socket = new QTcpSocket;
+    mux = new MuxConnection(socket, this);
+    connect(mux, &MuxConnection::linkClosed, mux, &QObject::deleteLater);
+    qDebug() << "TableManager: Connecting multiplexed link to" << host << ":" << Protocol::MUX_PORT;
+    socket->connectToHost(host, Protocol::MUX_PORT);
+    return mux;
+}
+
+MainView *TableManager::openTable()
+{
+    MuxChannel* channel = link()->openChannel();
+    ++opened;
+
+    //与 main() 中第一桌的创建顺序相同：先暂存事件，界面建好后再处理
+    GameModel* model = new GameModel;
+    GameController* controller = new GameController(model, channel);
+    controller->setTableSize(tableSize);
+    controller->setEventsHeld(true);
+    MainView* view = new MainView(controller, QString());
+    controller->setParent(view);
+    controller->setView(view);
+    model->setParent(view);
+    view->setAttribute(Qt::WA_DeleteOnClose);
+    view->setUsername(tr("%1 (第%2桌)").arg(username).arg(opened + 1));
+    connect(view, &MainView::newTableRequested, this, &TableManager::openTable);
+    view->show();
+    controller->setEventsHeld(false);
+
+    qInfo() << "TableManager: Opened table on session" << channel->sessionId()
+            << "sharing one connection with" << link()->channelCount() - 1 << "other tables.";
+    return view;
+}
+
+int TableManager::tableCount() const
+{
+    return mux ? mux->channelCount() : 0;
+}
@@ -0,0 +1,33 @@
+#ifndef TABLEMANAGER_H
+#define TABLEMANAGER_H
+
+#include <QObject>
+#include <QPointer>
+#include <QString>
+
+class MainView;
+class MuxConnection;
+
+// 同时玩多桌：除第一桌外，其余每桌都是同一条多路复用 TCP 连接上的一个会话，
+// 各自拥有 GameModel、GameController 和 MainView，服务器按会话分到不同房间。
+class TableManager : public QObject
+{
+    Q_OBJECT
+public:
+    TableManager(const QString& host, const QString& username, int tableSize, QObject* parent = nullptr);
+
+    // 打开一个新的桌面窗口，窗口关闭时对应的会话随之关闭
+    MainView* openTable();
+    int tableCount() const;
+
+private:
+    MuxConnection* link();
+
+    QString host;
+    QString username;
+    int tableSize;
+    QPointer<MuxConnection> mux;
+    int opened = 0;
+};
+
+#endif // TABLEMANAGER_H
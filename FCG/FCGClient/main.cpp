@@ -1,34 +1,50 @@
-#include "mainview.h"
-
-#include <QApplication>
-
-#include <view/connectdialog.h>
-#include <model/gamemodel.h>
-#include <controller/gamecontroller.h>
-
-int main(int argc, char *argv[])
-
-{
-    QApplication a(argc, argv);
-
-    GameModel model;
-    ConnectDialog dialog;
-    if(dialog.exec() == QDialog::Accepted){
-        QString host = dialog.getHost();
-        int port = dialog.getPort();
-        QString username = dialog.getUsername();
-
-        GameController* controller= new GameController(&model,host,port);
-        MainView* mainView = new MainView(controller,username);
-
-        controller->setParent(mainView);
-        controller->setView(mainView);
-        mainView->show();
-
-        controller->connectToServer();
-    }
-    else {
-        return 0;
-    }
-    return a.exec();
-}
+#include "mainview.h"
+
+#include <QApplication>
+
+#include <view/connectdialog.h>
+#include <model/gamemodel.h>
+#include <controller/gamecontroller.h>
+#include <controller/tablemanager.h>
+
+int main(int argc, char *argv[])
+
+{
+    QApplication a(argc, argv);
+    QCoreApplication::setOrganizationName("FCG");
+    QCoreApplication::setApplicationName("FCGClient");
+
+    //主界面在连接对话框打开前就建好，对话框里地址一有效就开始解析并预连接，
+    //服务器发来的消息先留在缓冲区，主界面显示后再处理
+    GameModel model;
+    GameController* controller = new GameController(&model, QString(), 0);
+    controller->setEventsHeld(true);
+    MainView* mainView = new MainView(controller, QString());
+    controller->setParent(mainView);
+    controller->setView(mainView);
+
+    ConnectDialog dialog;
+    QObject::connect(&dialog, &ConnectDialog::serverReady, controller, &GameController::preconnect);
+    if(dialog.exec() == QDialog::Accepted){
+        QString host = dialog.getHost();
+        int port = dialog.getPort();
+        QString username = dialog.getUsername();
+
+        controller->setServer(host, port);
+        controller->setTableSize(dialog.getTableSize());
+        mainView->setUsername(username);
+        mainView->show();
+
+        controller->setEventsHeld(false);
+        controller->connectToServer();
+
+        //其余的桌面共用一条多路复用连接
+        TableManager* tables = new TableManager(host, username, dialog.getTableSize(), mainView);
+        QObject::connect(mainView, &MainView::newTableRequested, tables, &TableManager::openTable);
+    }
+    else {
+        delete mainView;
+        return 0;
+    }
+    return a.exec();
+}
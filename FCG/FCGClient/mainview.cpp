@@ -1,68 +1,127 @@
-#include "mainview.h"
-//#include "ui_mainview.h"
-#include <view/boardpanel.h>
-#include <view/controlpanel.h>
-#include <controller/gamecontroller.h>
-#include <QLabel>
-#include <QBoxLayout>
-
-MainView::MainView(GameController* controller,
-                   const QString& username,
-                   QWidget *parent)
-    : QWidget(parent)
-    , controller(controller)
-    , boardPanel(nullptr)
-    , controlPanel(nullptr)
-    , username(username)
-{
-//    ui->setupUi(this);
-
-    setupUI();
-    setupConnections();
-
-    setWindowTitle(tr("FCG - %1").arg(username));
-    setMinimumSize(1200,800);
-}
-
-MainView::~MainView(){}
-
-void MainView::showMessage(const QString &message)
-{
-    QMessageBox::information(this, "提示", message);
-}
-
-ControlPanel* MainView::getControlPanel()
-{
-    return controlPanel;
-}
-
-GameController *MainView::getController()
-{
-    return controller;
-}
-void MainView::setupUI()
-{
-    QHBoxLayout* mainLayout = new QHBoxLayout(this);
-
-    qDebug() << "Creating boardPanel...";
-    boardPanel = new BoardPanel(this);
-    qDebug() << "Creating controlPanel...";
-    controlPanel = new ControlPanel(this);
-
-    mainLayout->addWidget(boardPanel,7);
-    mainLayout->addWidget(controlPanel,3);
-
-    setLayout(mainLayout);
-}
-
-void MainView::setupConnections()
-{
-    if(controlPanel && controller){
-        connect(controller, &GameController::gameStateUpdated,
-                boardPanel, &BoardPanel::updateBoardState);
-        connect(controller, &GameController::serverMessageReceived,
-                this, &MainView::showMessage);
-        connect(controller, &GameController::updateGamePhase,
-                controlPanel,&ControlPanel::setGamePhase);
-    }
-}
+#include "mainview.h"
+//#include "ui_mainview.h"
+#include <view/boardpanel.h>
+#include <view/controlpanel.h>
+#include <controller/gamecontroller.h>
+#include <model/messagelogmodel.h>
+#include <view/toastwidget.h>
+#include <QLabel>
+#include <QBoxLayout>
+#include <QListView>
+#include <QScrollBar>
+#include <QPushButton>
+
+MainView::MainView(GameController* controller,
+                   const QString& username,
+                   QWidget *parent)
+    : QWidget(parent)
+    , controller(controller)
+    , boardPanel(nullptr)
+    , controlPanel(nullptr)
+    , statusLabel(nullptr)
+    , messageLog(nullptr)
+    , messageView(nullptr)
+    , toast(nullptr)
+    , username(username)
+{
+//    ui->setupUi(this);
+
+    setupUI();
+    setupConnections();
+
+    setUsername(username);
+    setMinimumSize(1200,800);
+}
+
+MainView::~MainView(){}
+
+void MainView::setUsername(const QString &name)
+{
+    username = name;
+    setWindowTitle(tr("FCG - %1").arg(username));
+}
+
+void MainView::showMessage(const QString &message)
+{
+    messageLog->append(message);
+    toast->showToast(message);
+}
+
+ControlPanel* MainView::getControlPanel()
+{
+    return controlPanel;
+}
+
+GameController *MainView::getController()
+{
+    return controller;
+}
+void MainView::setupUI()
+{
+    QHBoxLayout* mainLayout = new QHBoxLayout(this);
+
+    qDebug() << "Creating boardPanel...";
+    boardPanel = new BoardPanel(this);
+    qDebug() << "Creating controlPanel...";
+    controlPanel = new ControlPanel(this);
+
+    //消息记录最多保留 500 条，列表只绘制可见行
+    messageLog = new MessageLogModel(500, this);
+    messageView = new QListView(this);
+    messageView->setModel(messageLog);
+    messageView->setUniformItemSizes(true);
+    messageView->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    messageView->setSelectionMode(QAbstractItemView::NoSelection);
+    messageView->setWordWrap(false);
+    connect(messageLog, &QAbstractItemModel::rowsInserted, this, [this]() {
+        //只有用户没有往上翻看时才自动滚到最新一条
+        QScrollBar* bar = messageView->verticalScrollBar();
+        if (bar->value() >= bar->maximum() - 1) messageView->scrollToBottom();
+    });
+
+    toast = new ToastWidget(this);
+
+    QVBoxLayout* sideLayout = new QVBoxLayout;
+    sideLayout->addWidget(controlPanel,3);
+    sideLayout->addWidget(new QLabel(tr("消息记录"),this));
+    sideLayout->addWidget(messageView,2);
+    //心跳测得的网络延迟，收到第一次回应前不显示
+    statusLabel = new QLabel(this);
+    sideLayout->addWidget(statusLabel);
+    QPushButton* newTableButton = new QPushButton(tr("再开一桌"), this);
+    connect(newTableButton, &QPushButton::clicked, this, &MainView::newTableRequested);
+    sideLayout->addWidget(newTableButton);
+
+    mainLayout->addWidget(boardPanel,7);
+    mainLayout->addLayout(sideLayout,3);
+
+    setLayout(mainLayout);
+}
+
+void MainView::setupConnections()
+{
+    if(controlPanel && controller){
+        //模型只通知变化的格子，面板据此局部重绘
+        connect(controller->getModel(), &GameModel::tilesChanged,
+                boardPanel, &BoardPanel::updateBoardState);
+        connect(controller, &GameController::planeMoved,
+                boardPanel, &BoardPanel::animateMove);
+        connect(controller, &GameController::serverMessageReceived,
+                this, &MainView::showMessage);
+        connect(controller, &GameController::updateGamePhase,
+                controlPanel,&ControlPanel::setGamePhase);
+        connect(controller, &GameController::hintReceived,
+                controlPanel,&ControlPanel::showHint);
+        connect(controller, &GameController::latencyUpdated, this, [this](int rttMs, int jitterMs) {
+            statusLabel->setText(tr("延迟 %1 ms（抖动 %2 ms）").arg(rttMs).arg(jitterMs));
+        });
+        connect(controller, &GameController::connectionStatusChanged, this, [this](bool connected) {
+            if (!connected) statusLabel->clear();
+        });
+        //棋盘上直接点飞机，与点“飞机1..4”按钮等价
+        connect(controlPanel, &ControlPanel::movablePlanesChanged,
+                boardPanel, &BoardPanel::setSelectablePlanes);
+        connect(boardPanel, &BoardPanel::planeClicked,
+                controlPanel, &ControlPanel::selectPlane);
+    }
+}
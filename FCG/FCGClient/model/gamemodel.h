@@ -1,26 +1,32 @@
-#ifndef GAMEMODEL_H
-#define GAMEMODEL_H
-
-#include <QObject>
-#include <QMap>
-#include <QList>
-
-
-
-class GameModel : public QObject
-{
-    Q_OBJECT
-public:
-    explicit GameModel(QObject *parent = nullptr);
-
-    void initGame(int playerCount);
-
-    QMap<int, QList<int>> getBoardState() const;
-
-    void setBoardState(const QMap<int, QList<int>>& newState);
-
-private:
-    QMap<int, QList<int>> boardState;
-};
-
-#endif // GAMEMODEL_H
+#ifndef GAMEMODEL_H
+#define GAMEMODEL_H
+
+#include <QObject>
+#include <QMap>
+#include <QList>
+
+
+
+class GameModel : public QObject
+{
+    Q_OBJECT
+public:
+    explicit GameModel(QObject *parent = nullptr);
+
+    void initGame(int playerCount);
+
+    QMap<int, QList<int>> getBoardState() const;
+
+    void setBoardState(const QMap<int, QList<int>>& newState);
+
+signals:
+    // 只包含内容发生变化的格子及其新的飞机列表（被清空的格子对应空列表）
+    void tilesChanged(const QMap<int, QList<int>>& changedTiles);
+
+private:
+    QMap<int, QList<int>> boardState;
+
+    void emitChanges(const QMap<int, QList<int>>& oldState);
+};
+
+#endif // GAMEMODEL_H
@@ -0,0 +1,341 @@
+#include "gamerules.h"
+#include <array>
+#include <cstring>
+
+BoardPosition BoardPosition::fromTileStates(const QMap<int, QList<int>> &tileStates)
+{
+    BoardPosition position;
+    for (auto it = tileStates.constBegin(); it != tileStates.constEnd(); ++it) {
+        const int tileId = it.key();
+        if (tileId < 1 || tileId > 96) continue;
+        for (int pid : it.value()) {
+            if (pid > 100 && pid <= 100 + PLANE_COUNT) {
+                position.tile[pid - 101] = qint8(tileId);
+                position.finished |= quint16(1u << (pid - 101));
+            } else if (pid >= 1 && pid <= PLANE_COUNT) {
+                position.tile[pid - 1] = qint8(tileId);
+            }
+        }
+    }
+    return position;
+}
+
+QMap<int, QList<int>> BoardPosition::toTileStates() const
+{
+    QMap<int, QList<int>> tileStates;
+    for (int tileId = 1; tileId <= 96; ++tileId) {
+        tileStates.insert(tileId, QList<int>());
+    }
+    for (int i = 0; i < PLANE_COUNT; ++i) {
+        if (tile[i] <= 0) continue;
+        const int globalPlaneId = i + 1;
+        tileStates[tile[i]].append(isFinished(globalPlaneId) ? 100 + globalPlaneId : globalPlaneId);
+    }
+    return tileStates;
+}
+
+bool BoardPosition::isActivePlayer(int playerId) const
+{
+    if (playerId < 1 || playerId > 4) return false;
+    for (int planeId = 1; planeId <= 4; ++planeId) {
+        if (tile[(playerId - 1) * 4 + planeId - 1] > 0) return true;
+    }
+    return false;
+}
+
+bool BoardPosition::operator==(const BoardPosition &other) const
+{
+    return finished == other.finished && std::memcmp(tile, other.tile, sizeof(tile)) == 0;
+}
+
+GameRules::MoveResult GameRules::applyMove(BoardPosition &position, int playerId, int dice, int planeId,
+                                           const StepCallback &onStep)
+{
+    if (playerId < 1 || playerId > 4 || planeId < 1 || planeId > 4) return MoveInvalid;
+
+    const int globalPlaneId = (playerId - 1) * 4 + planeId;
+    const int index = globalPlaneId - 1;
+    if (!position.isOnBoard(globalPlaneId)) return MoveInvalid;
+
+    int currentPosition = position.tile[index];
+
+    //机场处理逻辑
+    if (isInAirport(currentPosition)) {
+        if (dice == 5 || dice == 6) {
+            position.tile[index] = qint8(getStartTile(playerId));
+            return MoveDone;
+        }
+        return MoveCannotTakeOff;
+    }
+
+    //移动逻辑
+    bool backwardFlag = false;
+    int steps = dice;
+    while (steps-- > 0) {
+        int nextPos = isExitRingPosition(playerId, currentPosition)
+                          ? getNextOnExitPath(playerId, currentPosition)
+                          : getNextPosition(playerId, currentPosition);
+        if (backwardFlag) nextPos = currentPosition - 1;
+
+        position.tile[index] = qint8(nextPos);
+        currentPosition = nextPos;
+        if (onStep) onStep(position);
+
+        //终点检测
+        if (isFinalEnd(playerId, currentPosition)) {
+            if (steps > 0) {
+                backwardFlag = true;
+            } else {
+                position.tile[index] = qint8(getAirportTile(playerId, planeId));
+                position.finished |= quint16(1u << index);
+            }
+        }
+    }
+
+    //碰撞处理
+    handleCollision(position, globalPlaneId, currentPosition);
+
+    return isTileColorMatchesPlayer(playerId, currentPosition)
+                   && !isExitRingPosition(playerId, currentPosition) ? MoveCanFly : MoveDone;
+}
+
+GameRules::MoveResult GameRules::applyMoveWithPath(BoardPosition &position, int playerId, int dice, int planeId,
+                                                   QList<int> *path)
+{
+    const int globalPlaneId = (playerId - 1) * 4 + planeId;
+    QList<int> steps;
+    const MoveResult result = applyMove(position, playerId, dice, planeId,
+                                        [&steps, globalPlaneId](const BoardPosition& step) {
+        steps.append(step.tile[globalPlaneId - 1]);
+    });
+    if (path && (result == MoveDone || result == MoveCanFly)) {
+        //起飞没有中间步；到达终点时最后一格是机场
+        const int finalTile = position.tile[globalPlaneId - 1];
+        if (steps.isEmpty() || steps.last() != finalTile) steps.append(finalTile);
+        *path = steps;
+    }
+    return result;
+}
+
+QList<int> GameRules::capturedPlanes(const BoardPosition &before, const BoardPosition &after, int moverId)
+{
+    QList<int> captured;
+    for (int pid = 1; pid <= BoardPosition::PLANE_COUNT; ++pid) {
+        if (pid != moverId && before.tile[pid - 1] != after.tile[pid - 1]) {
+            captured.append(pid);
+        }
+    }
+    return captured;
+}
+
+bool GameRules::applyFly(BoardPosition &position, int playerId, int planeId)
+{
+    const int globalPlaneId = (playerId - 1) * 4 + planeId;
+    if (playerId < 1 || playerId > 4 || planeId < 1 || planeId > 4 || !position.isOnBoard(globalPlaneId)) {
+        return false;
+    }
+    const int index = globalPlaneId - 1;
+    const int currentTile = position.tile[index];
+
+    //检查是否在特殊跳跃位置
+    const int specialJumpTarget = getSpecialJumpTarget(playerId, currentTile);
+    if (specialJumpTarget != -1) {
+        position.tile[index] = qint8(specialJumpTarget);
+        collisionDuringFly(position, playerId);
+        handleCollision(position, globalPlaneId, specialJumpTarget);
+        return true;
+    }
+
+    //执行常规飞跃
+    int currentPos = currentTile;
+    for (int i = 0; i < 4; i++) {
+        currentPos = isExitRingPosition(playerId, currentPos)
+                         ? getNextOnExitPath(playerId, currentPos)
+                         : getNextPosition(playerId, currentPos);
+    }
+    position.tile[index] = qint8(currentPos);
+    handleCollision(position, globalPlaneId, currentPos);
+    return true;
+}
+
+bool GameRules::canMove(const BoardPosition &position, int playerId, int dice, int planeId)
+{
+    const int globalPlaneId = (playerId - 1) * 4 + planeId;
+    if (playerId < 1 || playerId > 4 || planeId < 1 || planeId > 4 || !position.isOnBoard(globalPlaneId)) {
+        return false;
+    }
+    return !isInAirport(position.tile[globalPlaneId - 1]) || dice == 5 || dice == 6;
+}
+
+int GameRules::winner(const BoardPosition &position)
+{
+    for (int playerId = 1; playerId <= 4; ++playerId) {
+        const quint16 mask = quint16(0xF << ((playerId - 1) * 4));
+        if ((position.finished & mask) == mask) return playerId;
+    }
+    return 0;
+}
+
+quint16 GameRules::handleCollision(BoardPosition &position, int selfPlaneId, int tileId)
+{
+    quint16 captured = 0;
+    for (int i = 0; i < BoardPosition::PLANE_COUNT; ++i) {
+        const int pid = i + 1;
+        if (pid == selfPlaneId || position.tile[i] != tileId || position.isFinished(pid)) continue;
+        if (isSameColor(pid, selfPlaneId)) continue;
+        position.tile[i] = qint8(pid); // 机场格编号与全局编号相同
+        captured |= quint16(1u << i);
+    }
+    return captured;
+}
+
+quint16 GameRules::collisionDuringFly(BoardPosition &position, int playerId)
+{
+    int tileId = 0;
+    switch (playerId) {
+    case 1: tileId = 87; break;
+    case 2: tileId = 93; break;
+    case 3: tileId = 81; break;
+    case 4: tileId = 75; break;
+    default: return 0;
+    }
+
+    quint16 captured = 0;
+    for (int i = 0; i < BoardPosition::PLANE_COUNT; ++i) {
+        const int pid = i + 1;
+        if (position.tile[i] != tileId || position.isFinished(pid)) continue;
+        if ((pid - 1) / 4 + 1 == playerId) continue;
+        position.tile[i] = qint8(pid);
+        captured |= quint16(1u << i);
+    }
+    return captured;
+}
+
+int GameRules::distanceToGoal(int playerId, int tileId)
+{
+    // 每个玩家从起点到终点的路线固定，首次调用时沿规则走一遍建表
+    static const std::array<std::array<qint8, 97>, 5> table = []() {
+        std::array<std::array<qint8, 97>, 5> t{};
+        for (int p = 1; p <= 4; ++p) {
+            QList<int> route;
+            int pos = getStartTile(p);
+            route.append(pos);
+            while (!isFinalEnd(p, pos)) {
+                pos = isExitRingPosition(p, pos) ? getNextOnExitPath(p, pos) : getNextPosition(p, pos);
+                route.append(pos);
+            }
+            const int total = int(route.size());
+            for (int tile = 0; tile <= 96; ++tile) t[p][tile] = qint8(total); // 机场：还没起飞
+            for (int i = 0; i < total; ++i) t[p][route[i]] = qint8(total - 1 - i);
+        }
+        return t;
+    }();
+
+    if (playerId < 1 || playerId > 4 || tileId < 0 || tileId > 96) return 0;
+    return table[playerId][tileId];
+}
+
+int GameRules::planeTile(const BoardPosition &position, int globalPlaneId)
+{
+    if (globalPlaneId < 1 || globalPlaneId > BoardPosition::PLANE_COUNT || !position.isOnBoard(globalPlaneId)) {
+        return -1;
+    }
+    return position.tile[globalPlaneId - 1];
+}
+
+bool GameRules::isInAirport(int tileId)
+{
+    return tileId >= 1 && tileId <= 16;
+}
+
+int GameRules::getStartTile(int playerId)
+{
+    switch(playerId) {
+    case 1: return 17;
+    case 2: return 18;
+    case 3: return 20;
+    case 4: return 19;
+    default: return 0;
+    }
+}
+
+int GameRules::getAirportTile(int playerId, int planeId)
+{
+    return (playerId - 1) * 4 + planeId;
+}
+
+int GameRules::getNextPosition(int playerId, int currentPos)
+{
+    const int RING_START = 21;
+    const int RING_END = 72;
+
+    if (currentPos >= RING_START && currentPos < RING_END)
+        return currentPos + 1;
+    if (currentPos == RING_END)
+        return RING_START;
+
+    // 起点特殊处理
+    switch(playerId) {
+    case 1: return (currentPos == 17) ? 21 : currentPos+1;
+    case 2: return (currentPos == 18) ? 34 : currentPos+1;
+    case 3: return (currentPos == 20) ? 60 : currentPos+1;
+    case 4: return (currentPos == 19) ? 47 : currentPos+1;
+    default: return currentPos+1;
+    }
+}
+
+bool GameRules::isExitRingPosition(int playerId, int pos)
+{
+    switch (playerId) {
+    case 1: return pos == 70;
+    case 2: return pos == 31;
+    case 3: return pos == 57;
+    case 4: return pos == 44;
+    default: return false;
+    }
+}
+
+int GameRules::getNextOnExitPath(int playerId, int currentPos)
+{
+    switch (playerId) {
+    case 1: return 73;
+    case 2: return 79;
+    case 3: return 91;
+    case 4: return 85;
+    default: return currentPos;
+    }
+}
+
+bool GameRules::isFinalEnd(int playerId, int pos)
+{
+    switch (playerId) {
+    case 1: return pos == 78;
+    case 2: return pos == 84;
+    case 3: return pos == 96;
+    case 4: return pos == 90;
+    default: return false;
+    }
+}
+
+int GameRules::getSpecialJumpTarget(int playerId, int currentPos)
+{
+    switch (playerId) {
+    case 1: if (currentPos == 38) return 50; break; // Yellow
+    case 2: if (currentPos == 51) return 63; break; // Blue
+    case 3: if (currentPos == 25) return 37; break; // Green
+    case 4: if (currentPos == 64) return 24; break; // Red
+    }
+    return -1;
+}
+
+bool GameRules::isSameColor(int planeId1, int planeId2)
+{
+    return ((planeId1 - 1)/4) == ((planeId2 - 1)/4);
+}
+
+bool GameRules::isTileColorMatchesPlayer(int playerId, int tileId)
+{
+    if (tileId < 21 || tileId > 72) return false;
+    static const int colorByOffset[4] = {3, 1, 2, 4};
+    return colorByOffset[(tileId - 21) % 4] == playerId;
+}
@@ -0,0 +1,78 @@
+#ifndef GAMERULES_H
+#define GAMERULES_H
+
+#include <QMap>
+#include <QList>
+#include <functional>
+
+// 16 架飞机的紧凑局面，下标为 全局编号-1（全局编号 = (玩家-1)*4 + 飞机号）。
+// tile 为飞机所在格子，0 表示该飞机不在棋盘上（对应玩家未参战）；
+// 到达终点的飞机停回自己的机场格，并在 finished 中置位。
+struct BoardPosition
+{
+    static const int PLANE_COUNT = 16;
+
+    qint8 tile[PLANE_COUNT] = {};
+    quint16 finished = 0;
+
+    static BoardPosition fromTileStates(const QMap<int, QList<int>>& tileStates);
+    // 与 GameModel 相同的格式：1~96 号格子全部存在，终点飞机记为 100+全局编号
+    QMap<int, QList<int>> toTileStates() const;
+
+    bool isFinished(int globalPlaneId) const { return finished & (1u << (globalPlaneId - 1)); }
+    bool isOnBoard(int globalPlaneId) const { return tile[globalPlaneId - 1] > 0 && !isFinished(globalPlaneId); }
+    bool isActivePlayer(int playerId) const;
+
+    bool operator==(const BoardPosition& other) const;
+    bool operator!=(const BoardPosition& other) const { return !(*this == other); }
+};
+
+// 飞行棋规则，服务器与客户端共用。所有函数都是无副作用的纯计算（只修改传入的局面），
+// 可以在任意线程里并发调用。
+class GameRules
+{
+public:
+    enum MoveResult {
+        MoveDone,           // 正常完成
+        MoveCanFly,         // 停在同色格，可以选择飞跃
+        MoveCannotTakeOff,  // 在机场但点数不足以起飞
+        MoveInvalid         // 飞机不在棋盘上或已到达终点
+    };
+
+    using StepCallback = std::function<void(const BoardPosition&)>;
+
+    static MoveResult applyMove(BoardPosition& position, int playerId, int dice, int planeId,
+                                const StepCallback& onStep = StepCallback());
+    // 同 applyMove，另外把飞机依次经过的格子写入 path（最后一个是落点，到达终点时为机场格）
+    static MoveResult applyMoveWithPath(BoardPosition& position, int playerId, int dice, int planeId,
+                                        QList<int>* path);
+    // 比较移动前后的局面，返回被撞回机场的其他飞机全局编号
+    static QList<int> capturedPlanes(const BoardPosition& before, const BoardPosition& after, int moverId);
+    // 选择飞跃后的移动；飞机不在棋盘上时返回 false
+    static bool applyFly(BoardPosition& position, int playerId, int planeId);
+    static bool canMove(const BoardPosition& position, int playerId, int dice, int planeId);
+    // 返回胜者编号，没有则返回 0
+    static int winner(const BoardPosition& position);
+
+    // 把 tileId 上与 selfPlaneId 不同色的飞机送回机场，返回被撞飞机的位掩码
+    static quint16 handleCollision(BoardPosition& position, int selfPlaneId, int tileId);
+    // 走特殊飞跃线时，撞回横穿的终点通道格上的其他颜色飞机
+    static quint16 collisionDuringFly(BoardPosition& position, int playerId);
+
+    // 距离终点还剩多少步（已到达为 0），供 AI 评估局面
+    static int distanceToGoal(int playerId, int tileId);
+
+    static int planeTile(const BoardPosition& position, int globalPlaneId);
+    static bool isInAirport(int tileId);
+    static int getStartTile(int playerId);
+    static int getAirportTile(int playerId, int planeId);
+    static int getNextPosition(int playerId, int currentPos);
+    static bool isExitRingPosition(int playerId, int pos);
+    static int getNextOnExitPath(int playerId, int currentPos);
+    static bool isFinalEnd(int playerId, int pos);
+    static int getSpecialJumpTarget(int playerId, int currentPos);
+    static bool isSameColor(int planeId1, int planeId2);
+    static bool isTileColorMatchesPlayer(int playerId, int tileId);
+};
+
+#endif // GAMERULES_H
@@ -0,0 +1,55 @@
+#include "messagelogmodel.h"
+
+MessageLogModel::MessageLogModel(int capacity, QObject *parent)
+    : QAbstractListModel(parent)
+    , entries(qMax(1, capacity))
+{
+}
+
+int MessageLogModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : count;
+}
+
+QVariant MessageLogModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() < 0 || index.row() >= count) return QVariant();
+
+    const Entry &entry = entryAt(index.row());
+    if (role == Qt::DisplayRole) {
+        return QString("[%1] %2").arg(entry.time.toString("hh:mm:ss"), entry.text);
+    }
+    if (role == Qt::ToolTipRole) {
+        return entry.text;
+    }
+    return QVariant();
+}
+
+void MessageLogModel::append(const QString &message)
+{
+    //缓冲区满了先移走最旧的一行，行号整体前移
+    if (count == entries.size()) {
+        beginRemoveRows(QModelIndex(), 0, 0);
+        head = (head + 1) % entries.size();
+        --count;
+        endRemoveRows();
+    }
+
+    beginInsertRows(QModelIndex(), count, count);
+    entries[(head + count) % entries.size()] = Entry{QTime::currentTime(), message};
+    ++count;
+    endInsertRows();
+}
+
+void MessageLogModel::clear()
+{
+    beginResetModel();
+    head = 0;
+    count = 0;
+    endResetModel();
+}
+
+const MessageLogModel::Entry &MessageLogModel::entryAt(int row) const
+{
+    return entries[(head + row) % entries.size()];
+}
@@ -0,0 +1,36 @@
+#ifndef MESSAGELOGMODEL_H
+#define MESSAGELOGMODEL_H
+
+#include <QAbstractListModel>
+#include <QTime>
+#include <QVector>
+
+// 游戏消息记录：固定容量的环形缓冲区，满了以后丢弃最旧的一条。
+// 配合 QListView 使用，视图只会请求可见的那几行。
+class MessageLogModel : public QAbstractListModel
+{
+    Q_OBJECT
+public:
+    explicit MessageLogModel(int capacity = 500, QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+    void append(const QString &message);
+    void clear();
+
+private:
+    struct Entry
+    {
+        QTime time;
+        QString text;
+    };
+
+    QVector<Entry> entries;  // 大小固定为 capacity
+    int head = 0;            // 最旧一条所在的下标
+    int count = 0;
+
+    const Entry &entryAt(int row) const;
+};
+
+#endif // MESSAGELOGMODEL_H
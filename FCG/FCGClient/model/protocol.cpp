@@ -0,0 +1,47 @@
+#include "protocol.h"
+#include <QDebug>
+
+QByteArray Protocol::encodeFrame(const QString &messageType, const QVariant &payload1, const QVariant &payload2)
+{
+    QByteArray block;
+    QDataStream out(&block, QIODevice::WriteOnly);
+    out.setVersion(STREAM_VERSION);
+
+    out << quint32(0);
+    out << messageType;
+    if (payload1.isValid()) out << payload1;
+    if (payload2.isValid()) out << payload2;
+
+    if (out.status() != QDataStream::Ok) {
+        qWarning() << "Protocol: QDataStream error while encoding" << messageType << "Status:" << out.status();
+        return QByteArray();
+    }
+
+    out.device()->seek(0);
+    out << quint32(block.size() - sizeof(quint32));
+    return block;
+}
+
+QVariant PlaneMove::toVariant() const
+{
+    QVariantList pathList;
+    for (int tileId : path) pathList.append(tileId);
+    QVariantList capturedList;
+    for (int planeId : captured) capturedList.append(planeId);
+
+    QVariantMap map;
+    map.insert("plane", globalPlaneId);
+    map.insert("path", pathList);
+    map.insert("captured", capturedList);
+    return map;
+}
+
+PlaneMove PlaneMove::fromVariant(const QVariant &variant)
+{
+    const QVariantMap map = variant.toMap();
+    PlaneMove move;
+    move.globalPlaneId = map.value("plane").toInt();
+    for (const QVariant &tileId : map.value("path").toList()) move.path.append(tileId.toInt());
+    for (const QVariant &planeId : map.value("captured").toList()) move.captured.append(planeId.toInt());
+    return move;
+}
@@ -0,0 +1,93 @@
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QList>
+#include <QString>
+#include <QVariant>
+
+// 客户端与服务器共用的消息帧格式：
+// [quint32 正文长度][QString 消息类型][QVariant payload1][QVariant payload2]
+// payload 无效时不写入。
+class Protocol
+{
+public:
+    static const QDataStream::Version STREAM_VERSION = QDataStream::Qt_6_5;
+    // 同机的 AI、网关通过本地套接字（QLocalServer）连接服务器，帧格式与 TCP 相同
+    static constexpr char LOCAL_SERVER_NAME[] = "fcg-server";
+    // 多路复用连接（见 muxtransport.h）使用单独的端口和本地套接字名，一条连接承载多个会话
+    static constexpr quint16 MUX_PORT = 12346;
+    static constexpr char LOCAL_MUX_NAME[] = "fcg-server-mux";
+
+    // 编码失败（QDataStream 出错）时返回空 QByteArray
+    static QByteArray encodeFrame(const QString& messageType,
+                                  const QVariant& payload1 = QVariant(),
+                                  const QVariant& payload2 = QVariant());
+};
+
+// MATCH_MSG（客户端 -> 服务器，连接后的第一条消息）：payload1 为希望的每桌人数（2~4），0 表示不限。
+// 自动匹配模式的服务器据此分组，单桌模式下忽略人数、直接入座；两种模式都在收到它之后才安排座位
+// ROOM_MSG（代替 MATCH_MSG）：payload1 为房间号（欢迎消息中给出），重连或观战时直接回到该房间，
+// 房间在同机另一个服务器进程中时由收到连接的进程转交；payload2 为欢迎消息中的座位凭据（可选），
+// 凭据有效且原座位空着时回到原座位，否则观战
+// PING_MSG（双向）：payload1 为发送方的单调时钟毫秒数（qint64），对方立即以 PONG_MSG 原样返回，
+// 发送方据此估计往返时延；心跳规则见 controller/heartbeat.h
+
+// EVENT_MSG：payload1 为事件编号，payload2 为整数/字符串参数列表（QVariantList，可以为空）。
+// 服务器只发编号与参数，提示文字由客户端本地化，新增事件只能追加在末尾
+enum class ServerEvent : int {
+    Welcome = 1,        // [座位号, 房间号, 座位凭据]
+    PlayerJoined,       // [座位号, 已入座, 总座位]
+    BotJoined,          // [座位号, 已入座, 总座位]
+    PlayerLeft,         // [座位号]
+    PlayerLeftWaiting,  // [座位号, 还差几人]
+    PlayerReady,        // [座位号, 已准备, 总座位]
+    WaitingForPlayers,  // [还差几人]
+    AllReadyWaiting,    // [还差几人]
+    GameStarted,        // [先手座位号]
+    YourTurnRoll,       // []
+    YourTurnChooseFly,  // []
+    TurnChanged,        // [座位号]
+    BotRolled,          // [座位号, 点数]
+    CannotTakeOff,      // []
+    GameWon,            // [胜者座位号]
+    GameAlreadyEnded,   // []
+    NoNextPlayer,       // []
+    Error,              // [ServerError, 附加说明(可选)]
+    Spectating,         // [已入座, 总座位, 房间号]  座位已满，本连接只能观战
+    EventCount
+};
+
+enum class ServerError : int {
+    GameNotStarted = 1,
+    NotYourTurn,
+    InvalidPlaneOp,
+    InvalidHint,
+    UnknownAction,      // 附加说明为消息类型
+    Internal,           // 附加说明为异常信息（可选）
+    Spectating          // 观众不能操作
+};
+
+// PLANE_OP_MSG：payload1 为点数，payload2 为飞机号（1~4），或 [飞机号, FlyPolicy]。
+// 事先声明了飞跃策略时，落在同色格不再询问，一个来回就能走完整个回合
+enum class FlyPolicy : int {
+    Ask = 0,
+    Always,
+    Never
+};
+
+// PLANE_MOVE_MSG 的内容：服务器一次性算出整步移动，客户端据此播放动画，
+// 随后的 GAME_STATE_MSG 仍是权威状态
+struct PlaneMove
+{
+    int globalPlaneId = 0;
+    QList<int> path;        // 依次经过的格子，最后一个是落点（到达终点时为自己的机场格）
+    QList<int> captured;    // 被撞回机场的飞机全局编号
+
+    QVariant toVariant() const;
+    static PlaneMove fromVariant(const QVariant& variant);
+};
+Q_DECLARE_METATYPE(PlaneMove)
+
+#endif // PROTOCOL_H
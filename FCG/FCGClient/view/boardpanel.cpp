@@ -1,444 +1,539 @@
-#include "boardpanel.h"
-#include <QPainter>
-#include <QResizeEvent>
-
-BoardPanel::BoardPanel(QWidget *parent)
-    : QWidget(parent)
-{
-    //setStyleSheet("background-color: white;");
-    qDebug() << "Creating boardPanel...";
-    computeBoard();
-}
-
-void BoardPanel::updateBoardState(const QMap<int, QList<int> > &tilesState)
-{
-    for(Tile* tile : tiles){
-        if(tilesState.contains(tile->tileID())){
-            tile->setPlanes(tilesState[tile->tileID()]);
-        }
-    }
-    update();
-}
-
-void BoardPanel::paintEvent(QPaintEvent *event)
-{
-
-    QPainter painter(this);
-    QPen pen;
-    pen.setWidth(1);
-    painter.setPen(pen);
-
-    painter.setRenderHint(QPainter::Antialiasing);
-
-    for(Tile* tile : tiles){
-        tile->draw(painter);
-    }
-}
-
-void BoardPanel::resizeEvent(QResizeEvent *event)
-{
-    QWidget::resizeEvent(event);
-    computeBoard();
-}
-
-void BoardPanel::computeBoard()
-{
-    QMap<int ,QList<int>> currentState;
-    for(Tile* tile : qAsConst(tiles)){
-        currentState.insert(tile->tileID(),tile->getplanes());
-    }
-
-    qDeleteAll(tiles);
-    tiles.clear();
-    nextTileID = 1;
-
-    const int w = width();
-    const int h = height();
-    center = QPoint(w/2,h/2);
-    const int CELL_SIZE = cellSize;
-
-    //黄色起点
-    addRectTile(center.x() - 17*CELL_SIZE, center.y() - 17*CELL_SIZE, CELL_SIZE*4, CELL_SIZE*4, Qt::yellow);
-    addRectTile(center.x() - 13*CELL_SIZE, center.y() - 17*CELL_SIZE, CELL_SIZE*4, CELL_SIZE*4, Qt::yellow);
-    addRectTile(center.x() - 17*CELL_SIZE, center.y() - 13*CELL_SIZE, CELL_SIZE*4, CELL_SIZE*4, Qt::yellow);
-    addRectTile(center.x() - 13*CELL_SIZE, center.y() - 13*CELL_SIZE, CELL_SIZE*4, CELL_SIZE*4, Qt::yellow);
-
-    //蓝色起点
-    addRectTile(center.x() + 9*CELL_SIZE, center.y() - 17*CELL_SIZE, CELL_SIZE*4, CELL_SIZE*4, Qt::blue);
-    addRectTile(center.x() + 13*CELL_SIZE, center.y() - 17*CELL_SIZE, CELL_SIZE*4, CELL_SIZE*4, Qt::blue);
-    addRectTile(center.x() + 9*CELL_SIZE, center.y() - 13*CELL_SIZE, CELL_SIZE*4, CELL_SIZE*4, Qt::blue);
-    addRectTile(center.x() + 13*CELL_SIZE, center.y() - 13*CELL_SIZE, CELL_SIZE*4, CELL_SIZE*4, Qt::blue);
-
-    //绿色起点
-    addRectTile(center.x() - 17*CELL_SIZE, center.y() + 9*CELL_SIZE, CELL_SIZE*4, CELL_SIZE*4, Qt::green);
-    addRectTile(center.x() - 13*CELL_SIZE, center.y() + 9*CELL_SIZE, CELL_SIZE*4, CELL_SIZE*4, Qt::green);
-    addRectTile(center.x() - 17*CELL_SIZE, center.y() + 13*CELL_SIZE, CELL_SIZE*4, CELL_SIZE*4, Qt::green);
-    addRectTile(center.x() - 13*CELL_SIZE, center.y() + 13*CELL_SIZE, CELL_SIZE*4, CELL_SIZE*4, Qt::green);
-
-    //红色起点
-    addRectTile(center.x() + 9*CELL_SIZE, center.y() + 9*CELL_SIZE, CELL_SIZE*4, CELL_SIZE*4, Qt::red);
-    addRectTile(center.x() + 13*CELL_SIZE, center.y() + 9*CELL_SIZE, CELL_SIZE*4, CELL_SIZE*4, Qt::red);
-    addRectTile(center.x() + 9*CELL_SIZE, center.y() + 13*CELL_SIZE, CELL_SIZE*4, CELL_SIZE*4, Qt::red);
-    addRectTile(center.x() + 13*CELL_SIZE, center.y() + 13*CELL_SIZE, CELL_SIZE*4, CELL_SIZE*4, Qt::red);
-
-    //起点三角形
-    QVector<QPoint> trianglePoints17;
-    trianglePoints17 << QPoint(center.x() - 17*CELL_SIZE, center.y() - 9*CELL_SIZE)
-                   << QPoint(center.x() - 13*CELL_SIZE, center.y() - 9*CELL_SIZE)
-                   << QPoint(center.x() - 17*CELL_SIZE, center.y() - 5*CELL_SIZE);
-    addTriangle(trianglePoints17, Qt::yellow);
-
-    QVector<QPoint> trianglePoints18;
-    trianglePoints18 << QPoint(center.x() +5*CELL_SIZE, center.y() - 17*CELL_SIZE)
-                    << QPoint(center.x() +9*CELL_SIZE, center.y() - 17*CELL_SIZE)
-                    << QPoint(center.x() +9*CELL_SIZE, center.y() - 13*CELL_SIZE);
-    addTriangle(trianglePoints18, Qt::blue);
-
-    QVector<QPoint> trianglePoints19;
-    trianglePoints19 << QPoint(center.x() +13*CELL_SIZE, center.y() +9*CELL_SIZE)
-                    << QPoint(center.x() +17*CELL_SIZE, center.y() +5*CELL_SIZE)
-                    << QPoint(center.x() +17*CELL_SIZE, center.y() +9*CELL_SIZE);
-    addTriangle(trianglePoints19, Qt::red);
-
-    QVector<QPoint> trianglePoints20;
-    trianglePoints20 << QPoint(center.x() -9*CELL_SIZE, center.y() +13*CELL_SIZE)
-                    << QPoint(center.x() -9*CELL_SIZE, center.y() +17*CELL_SIZE)
-                    << QPoint(center.x() -5*CELL_SIZE, center.y() +17*CELL_SIZE);
-    addTriangle(trianglePoints20, Qt::green);
-
-    //外圈部分21
-    QVector<QPoint> trianglePoints21;
-    trianglePoints21 << QPoint(center.x() -17*CELL_SIZE, center.y() -5*CELL_SIZE)
-                     << QPoint(center.x() -13*CELL_SIZE, center.y() -5*CELL_SIZE)
-                     << QPoint(center.x() -13*CELL_SIZE, center.y() -9*CELL_SIZE);
-    addTriangle(trianglePoints21, Qt::green);
-    addRectTile(center.x() - 13*CELL_SIZE, center.y() - 9*CELL_SIZE, CELL_SIZE*2, CELL_SIZE*4, Qt::yellow);
-    addRectTile(center.x() - 11*CELL_SIZE, center.y() - 9*CELL_SIZE, CELL_SIZE*2, CELL_SIZE*4, Qt::blue);
-
-    //24
-    QVector<QPoint> trianglePoints24;
-    trianglePoints24 << QPoint(center.x() -9*CELL_SIZE, center.y() -9*CELL_SIZE)
-                     << QPoint(center.x() -9*CELL_SIZE, center.y() -5*CELL_SIZE)
-                     << QPoint(center.x() -5*CELL_SIZE, center.y() -5*CELL_SIZE);
-    addTriangle(trianglePoints24, Qt::red);
-    //25
-    QVector<QPoint> trianglePoints25;
-    trianglePoints25 << QPoint(center.x() -9*CELL_SIZE, center.y() -9*CELL_SIZE)
-                     << QPoint(center.x() -5*CELL_SIZE, center.y() -9*CELL_SIZE)
-                     << QPoint(center.x() -5*CELL_SIZE, center.y() -5*CELL_SIZE);
-    addTriangle(trianglePoints25, Qt::green);
-    addRectTile(center.x() - 9*CELL_SIZE, center.y() - 11*CELL_SIZE, CELL_SIZE*4, CELL_SIZE*2, Qt::yellow);
-    addRectTile(center.x() - 9*CELL_SIZE, center.y() - 13*CELL_SIZE, CELL_SIZE*4, CELL_SIZE*2, Qt::blue);
-
-    //28
-    QVector<QPoint> trianglePoints28;
-    trianglePoints28 << QPoint(center.x() -5*CELL_SIZE, center.y() -17*CELL_SIZE)
-                     << QPoint(center.x() -5*CELL_SIZE, center.y() -13*CELL_SIZE)
-                     << QPoint(center.x() -9*CELL_SIZE, center.y() -13*CELL_SIZE);
-    addTriangle(trianglePoints28, Qt::red);
-
-    addRectTile(center.x() - 5*CELL_SIZE, center.y() - 17*CELL_SIZE, CELL_SIZE*2, CELL_SIZE*4, Qt::green);
-    addRectTile(center.x() - 3*CELL_SIZE, center.y() - 17*CELL_SIZE, CELL_SIZE*2, CELL_SIZE*4, Qt::yellow);
-    addRectTile(center.x() - 1*CELL_SIZE, center.y() - 17*CELL_SIZE, CELL_SIZE*2, CELL_SIZE*4, Qt::blue);
-    addRectTile(center.x() + 1*CELL_SIZE, center.y() - 17*CELL_SIZE, CELL_SIZE*2, CELL_SIZE*4, Qt::red);
-    addRectTile(center.x() + 3*CELL_SIZE, center.y() - 17*CELL_SIZE, CELL_SIZE*2, CELL_SIZE*4, Qt::green);
-
-    //34
-    QVector<QPoint> trianglePoints34;
-    trianglePoints34 << QPoint(center.x() +5*CELL_SIZE, center.y() -17*CELL_SIZE)
-                     << QPoint(center.x() +5*CELL_SIZE, center.y() -13*CELL_SIZE)
-                     << QPoint(center.x() +9*CELL_SIZE, center.y() -13*CELL_SIZE);
-    addTriangle(trianglePoints34, Qt::yellow);
-    addRectTile(center.x() +5*CELL_SIZE, center.y() -13*CELL_SIZE, CELL_SIZE*4, CELL_SIZE*2, Qt::blue);
-    addRectTile(center.x() +5*CELL_SIZE, center.y() -11*CELL_SIZE, CELL_SIZE*4, CELL_SIZE*2, Qt::red);
-
-    //37
-    QVector<QPoint> trianglePoints37;
-    trianglePoints37 << QPoint(center.x() +9*CELL_SIZE, center.y() -9*CELL_SIZE)
-                     << QPoint(center.x() +5*CELL_SIZE, center.y() -9*CELL_SIZE)
-                     << QPoint(center.x() +5*CELL_SIZE, center.y() -5*CELL_SIZE);
-    addTriangle(trianglePoints37, Qt::green);
-    //38
-    QVector<QPoint> trianglePoints38;
-    trianglePoints38 << QPoint(center.x() +9*CELL_SIZE, center.y() -9*CELL_SIZE)
-                     << QPoint(center.x() +9*CELL_SIZE, center.y() -5*CELL_SIZE)
-                     << QPoint(center.x() +5*CELL_SIZE, center.y() -5*CELL_SIZE);
-    addTriangle(trianglePoints38, Qt::yellow);
-    addRectTile(center.x() +9*CELL_SIZE, center.y() -9*CELL_SIZE, CELL_SIZE*2, CELL_SIZE*4, Qt::blue);
-    addRectTile(center.x() +11*CELL_SIZE, center.y() -9*CELL_SIZE, CELL_SIZE*2, CELL_SIZE*4, Qt::red);
-
-    //41
-    QVector<QPoint> trianglePoints41;
-    trianglePoints41 << QPoint(center.x() +17*CELL_SIZE, center.y() -5*CELL_SIZE)
-                     << QPoint(center.x() +13*CELL_SIZE, center.y() -5*CELL_SIZE)
-                     << QPoint(center.x() +13*CELL_SIZE, center.y() -9*CELL_SIZE);
-    addTriangle(trianglePoints41, Qt::green);
-
-    addRectTile(center.x() +13*CELL_SIZE, center.y() - 5*CELL_SIZE, CELL_SIZE*4, CELL_SIZE*2, Qt::yellow);
-    addRectTile(center.x() +13*CELL_SIZE, center.y() - 3*CELL_SIZE, CELL_SIZE*4, CELL_SIZE*2, Qt::blue);
-    addRectTile(center.x() +13*CELL_SIZE, center.y() - 1*CELL_SIZE, CELL_SIZE*4, CELL_SIZE*2, Qt::red);
-    addRectTile(center.x() +13*CELL_SIZE, center.y() + 1*CELL_SIZE, CELL_SIZE*4, CELL_SIZE*2, Qt::green);
-    addRectTile(center.x() +13*CELL_SIZE, center.y() + 3*CELL_SIZE, CELL_SIZE*4, CELL_SIZE*2, Qt::yellow);
-
-    //47
-    QVector<QPoint> trianglePoints47;
-    trianglePoints47 << QPoint(center.x() +17*CELL_SIZE, center.y() +5*CELL_SIZE)
-                     << QPoint(center.x() +13*CELL_SIZE, center.y() +5*CELL_SIZE)
-                     << QPoint(center.x() +13*CELL_SIZE, center.y() +9*CELL_SIZE);
-    addTriangle(trianglePoints47, Qt::blue);
-    addRectTile(center.x() +11*CELL_SIZE, center.y() +5*CELL_SIZE, CELL_SIZE*2, CELL_SIZE*4, Qt::red);
-    addRectTile(center.x() +9*CELL_SIZE, center.y() +5*CELL_SIZE, CELL_SIZE*2, CELL_SIZE*4, Qt::green);
-
-    //50
-    QVector<QPoint> trianglePoints50;
-    trianglePoints50 << QPoint(center.x() +9*CELL_SIZE, center.y() +9*CELL_SIZE)
-                     << QPoint(center.x() +9*CELL_SIZE, center.y() +5*CELL_SIZE)
-                     << QPoint(center.x() +5*CELL_SIZE, center.y() +5*CELL_SIZE);
-    addTriangle(trianglePoints50, Qt::yellow);
-    //51
-    QVector<QPoint> trianglePoints51;
-    trianglePoints51 << QPoint(center.x() +9*CELL_SIZE, center.y() +9*CELL_SIZE)
-                     << QPoint(center.x() +5*CELL_SIZE, center.y() +9*CELL_SIZE)
-                     << QPoint(center.x() +5*CELL_SIZE, center.y() +5*CELL_SIZE);
-    addTriangle(trianglePoints51, Qt::blue);
-    addRectTile(center.x() +5*CELL_SIZE, center.y() +9*CELL_SIZE, CELL_SIZE*4, CELL_SIZE*2, Qt::red);
-    addRectTile(center.x() +5*CELL_SIZE, center.y() +11*CELL_SIZE, CELL_SIZE*4, CELL_SIZE*2, Qt::green);
-
-    //54
-    QVector<QPoint> trianglePoints54;
-    trianglePoints54 << QPoint(center.x() +5*CELL_SIZE, center.y() +17*CELL_SIZE)
-                     << QPoint(center.x() +5*CELL_SIZE, center.y() +13*CELL_SIZE)
-                     << QPoint(center.x() +9*CELL_SIZE, center.y() +13*CELL_SIZE);
-    addTriangle(trianglePoints54, Qt::yellow);
-
-    addRectTile(center.x() +3*CELL_SIZE, center.y() +13*CELL_SIZE, CELL_SIZE*2, CELL_SIZE*4, Qt::blue);
-    addRectTile(center.x() +1*CELL_SIZE, center.y() +13*CELL_SIZE, CELL_SIZE*2, CELL_SIZE*4, Qt::red);
-    addRectTile(center.x() -1*CELL_SIZE, center.y() +13*CELL_SIZE, CELL_SIZE*2, CELL_SIZE*4, Qt::green);
-    addRectTile(center.x() -3*CELL_SIZE, center.y() +13*CELL_SIZE, CELL_SIZE*2, CELL_SIZE*4, Qt::yellow);
-    addRectTile(center.x() -5*CELL_SIZE, center.y() +13*CELL_SIZE, CELL_SIZE*2, CELL_SIZE*4, Qt::blue);
-
-    //60
-    QVector<QPoint> trianglePoints60;
-    trianglePoints60 << QPoint(center.x() -5*CELL_SIZE, center.y() +17*CELL_SIZE)
-                     << QPoint(center.x() -5*CELL_SIZE, center.y() +13*CELL_SIZE)
-                     << QPoint(center.x() -9*CELL_SIZE, center.y() +13*CELL_SIZE);
-    addTriangle(trianglePoints60, Qt::red);
-    addRectTile(center.x() -9*CELL_SIZE, center.y() +11*CELL_SIZE, CELL_SIZE*4, CELL_SIZE*2, Qt::green);
-    addRectTile(center.x() -9*CELL_SIZE, center.y() +9*CELL_SIZE, CELL_SIZE*4, CELL_SIZE*2, Qt::yellow);
-
-    //63
-    QVector<QPoint> trianglePoints63;
-    trianglePoints63 << QPoint(center.x() -9*CELL_SIZE, center.y() +9*CELL_SIZE)
-                     << QPoint(center.x() -5*CELL_SIZE, center.y() +9*CELL_SIZE)
-                     << QPoint(center.x() -5*CELL_SIZE, center.y() +5*CELL_SIZE);
-    addTriangle(trianglePoints63, Qt::blue);
-    //64
-    QVector<QPoint> trianglePoints64;
-    trianglePoints64 << QPoint(center.x() -9*CELL_SIZE, center.y() +9*CELL_SIZE)
-                     << QPoint(center.x() -9*CELL_SIZE, center.y() +5*CELL_SIZE)
-                     << QPoint(center.x() -5*CELL_SIZE, center.y() +5*CELL_SIZE);
-    addTriangle(trianglePoints64, Qt::red);
-    addRectTile(center.x() -11*CELL_SIZE, center.y() +5*CELL_SIZE, CELL_SIZE*2, CELL_SIZE*4, Qt::green);
-    addRectTile(center.x() -13*CELL_SIZE, center.y() +5*CELL_SIZE, CELL_SIZE*2, CELL_SIZE*4, Qt::yellow);
-
-    //67
-    QVector<QPoint> trianglePoints67;
-    trianglePoints67 << QPoint(center.x() -17*CELL_SIZE, center.y() +5*CELL_SIZE)
-                     << QPoint(center.x() -13*CELL_SIZE, center.y() +5*CELL_SIZE)
-                     << QPoint(center.x() -13*CELL_SIZE, center.y() +9*CELL_SIZE);
-    addTriangle(trianglePoints67, Qt::blue);
-
-    addRectTile(center.x() -17*CELL_SIZE, center.y() +3*CELL_SIZE, CELL_SIZE*4, CELL_SIZE*2, Qt::red);
-    addRectTile(center.x() -17*CELL_SIZE, center.y() +1*CELL_SIZE, CELL_SIZE*4, CELL_SIZE*2, Qt::green);
-    addRectTile(center.x() -17*CELL_SIZE, center.y() -1*CELL_SIZE, CELL_SIZE*4, CELL_SIZE*2, Qt::yellow);
-    addRectTile(center.x() -17*CELL_SIZE, center.y() -3*CELL_SIZE, CELL_SIZE*4, CELL_SIZE*2, Qt::blue);
-    addRectTile(center.x() -17*CELL_SIZE, center.y() -5*CELL_SIZE, CELL_SIZE*4, CELL_SIZE*2, Qt::red);
-
-    //黄色路径73
-    addRectTile(center.x() -13*CELL_SIZE, center.y() -1*CELL_SIZE, CELL_SIZE*2, CELL_SIZE*2, Qt::yellow);
-    addRectTile(center.x() -11*CELL_SIZE, center.y() -1*CELL_SIZE, CELL_SIZE*2, CELL_SIZE*2, Qt::yellow);
-    addRectTile(center.x() -9*CELL_SIZE, center.y() -1*CELL_SIZE, CELL_SIZE*2, CELL_SIZE*2, Qt::yellow);
-    addRectTile(center.x() -7*CELL_SIZE, center.y() -1*CELL_SIZE, CELL_SIZE*2, CELL_SIZE*2, Qt::yellow);
-    addRectTile(center.x() -5*CELL_SIZE, center.y() -1*CELL_SIZE, CELL_SIZE*2, CELL_SIZE*2, Qt::yellow);
-
-    //78
-    QVector<QPoint> trianglePoints78;
-    trianglePoints78 << QPoint(center.x() -3*CELL_SIZE, center.y() -3*CELL_SIZE)
-                     << QPoint(center.x() -3*CELL_SIZE, center.y() +3*CELL_SIZE)
-                     << QPoint(center.x() +0*CELL_SIZE, center.y() -0*CELL_SIZE);
-    addTriangle(trianglePoints78, Qt::yellow);
-
-    //蓝色路径79
-    addRectTile(center.x() -1*CELL_SIZE, center.y() -13*CELL_SIZE, CELL_SIZE*2, CELL_SIZE*2, Qt::blue);
-    addRectTile(center.x() -1*CELL_SIZE, center.y() -11*CELL_SIZE, CELL_SIZE*2, CELL_SIZE*2, Qt::blue);
-    addRectTile(center.x() -1*CELL_SIZE, center.y() -9*CELL_SIZE, CELL_SIZE*2, CELL_SIZE*2, Qt::blue);
-    addRectTile(center.x() -1*CELL_SIZE, center.y() -7*CELL_SIZE, CELL_SIZE*2, CELL_SIZE*2, Qt::blue);
-    addRectTile(center.x() -1*CELL_SIZE, center.y() -5*CELL_SIZE, CELL_SIZE*2, CELL_SIZE*2, Qt::blue);
-
-    //84
-    QVector<QPoint> trianglePoints84;
-    trianglePoints84 << QPoint(center.x() -0*CELL_SIZE, center.y() -0*CELL_SIZE)
-                     << QPoint(center.x() -3*CELL_SIZE, center.y() -3*CELL_SIZE)
-                     << QPoint(center.x() +3*CELL_SIZE, center.y() -3*CELL_SIZE);
-    addTriangle(trianglePoints84, Qt::blue);
-
-    //红色路径85
-    addRectTile(center.x() +11*CELL_SIZE, center.y() -1*CELL_SIZE, CELL_SIZE*2, CELL_SIZE*2, Qt::red);
-    addRectTile(center.x() +9*CELL_SIZE, center.y() -1*CELL_SIZE, CELL_SIZE*2, CELL_SIZE*2, Qt::red);
-    addRectTile(center.x() +7*CELL_SIZE, center.y() -1*CELL_SIZE, CELL_SIZE*2, CELL_SIZE*2, Qt::red);
-    addRectTile(center.x() +5*CELL_SIZE, center.y() -1*CELL_SIZE, CELL_SIZE*2, CELL_SIZE*2, Qt::red);
-    addRectTile(center.x() +3*CELL_SIZE, center.y() -1*CELL_SIZE, CELL_SIZE*2, CELL_SIZE*2, Qt::red);
-
-    //90
-    QVector<QPoint> trianglePoints90;
-    trianglePoints90 << QPoint(center.x() +3*CELL_SIZE, center.y() -3*CELL_SIZE)
-                     << QPoint(center.x() +3*CELL_SIZE, center.y() +3*CELL_SIZE)
-                     << QPoint(center.x() +0*CELL_SIZE, center.y() -0*CELL_SIZE);
-    addTriangle(trianglePoints90, Qt::red);
-
-    //绿色路径91
-    addRectTile(center.x() -1*CELL_SIZE, center.y() +11*CELL_SIZE, CELL_SIZE*2, CELL_SIZE*2, Qt::green);
-    addRectTile(center.x() -1*CELL_SIZE, center.y() +9*CELL_SIZE, CELL_SIZE*2, CELL_SIZE*2, Qt::green);
-    addRectTile(center.x() -1*CELL_SIZE, center.y() +7*CELL_SIZE, CELL_SIZE*2, CELL_SIZE*2, Qt::green);
-    addRectTile(center.x() -1*CELL_SIZE, center.y() +5*CELL_SIZE, CELL_SIZE*2, CELL_SIZE*2, Qt::green);
-    addRectTile(center.x() -1*CELL_SIZE, center.y() +3*CELL_SIZE, CELL_SIZE*2, CELL_SIZE*2, Qt::green);
-
-    //96
-    QVector<QPoint> trianglePoints96;
-    trianglePoints96 << QPoint(center.x() +3*CELL_SIZE, center.y() +3*CELL_SIZE)
-                     << QPoint(center.x() -3*CELL_SIZE, center.y() +3*CELL_SIZE)
-                     << QPoint(center.x() +0*CELL_SIZE, center.y() -0*CELL_SIZE);
-    addTriangle(trianglePoints96, Qt::green);
-
-    for (Tile* tile : tiles) {
-        if (currentState.contains(tile->tileID())) {
-            tile->setPlanes(currentState[tile->tileID()]);
-        }
-    }
-
-    update();
-}
-
-void BoardPanel::addRectTile(int x, int y, int w,int h, const QColor &color)
-{
-    QPolygon poly;
-    poly << QPoint(x, y)
-         << QPoint(x+w, y)
-         << QPoint(x+w, y+h)
-         << QPoint(x, y+h);
-    tiles.append(new Tile(nextTileID++, poly, color));
-}
-
-void BoardPanel::addTriangle(const QVector<QPoint> &points, const QColor &color)
-{
-    QPolygon poly(points);
-    tiles.append(new Tile(nextTileID++, poly, color));
-}
-
-BoardPanel::Tile::Tile(int id, const QPolygon &poly, const QColor &color)
-    :m_id(id), m_polygon(poly),m_baseColor(color){}
-
-void BoardPanel::Tile::draw(QPainter &painter) const
-{
-    QPen pen;
-    pen.setWidth(1);
-    painter.setPen(pen);
-    painter.setBrush(m_baseColor);
-    painter.drawPolygon(m_polygon);
-
-    painter.setPen(Qt::black);
-    painter.drawPolygon(m_polygon);
-
-    drawCircle(painter);
-    drawPlanes(painter);
-}
-
-void BoardPanel::Tile::drawCircle(QPainter &painter) const
-{
-    double avgX = 0, avgY = 0;
-    const int n = m_polygon.size();
-
-    for (const QPoint& p : m_polygon) {
-        avgX += p.x();
-        avgY += p.y();
-    }
-
-    if (n > 0) {
-        avgX /= n;
-        avgY /= n;
-    }
-
-    //QPointF center = m_polygon.boundingRect().center();
-    int r = 20/1.15;
-
-    QPen pen;
-    pen.setWidth(1);
-    painter.setPen(pen);
-    painter.setBrush(QColor(240,240,240));
-    painter.drawEllipse(QPointF(avgX,avgY),r,r);
-
-    painter.setPen(Qt::black);
-    painter.setBrush(Qt::NoBrush);
-    painter.drawEllipse(QPointF(avgX,avgY),r,r);
-}
-
-void BoardPanel::Tile::drawPlanes(QPainter &painter) const
-{
-    //QRectF rect = m_polygon.boundingRect();
-    //QPointF center = rect.center();
-    double avgX = 0, avgY = 0;
-    const int n = m_polygon.size();
-
-    for (const QPoint& p : m_polygon) {
-        avgX += p.x();
-        avgY += p.y();
-    }
-
-    if (n > 0) {
-        avgX /= n;
-        avgY /= n;
-    }
-
-    const int r = 20 / 2;
-    QVector<QPointF> offsets;
-
-    switch (m_planes.size()){
-    case 2:
-        offsets << QPointF(-r,0) << QPointF(r,0);
-        break;
-    case 3: case 4:
-        offsets << QPointF(-r,-r) << QPointF(r,-r)
-                << QPointF(-r,r) << QPointF(r,r);
-        break;
-    default:
-        for(int i=0;i< m_planes.size();i++){
-            offsets << QPointF(0,0);
-        }
-    }
-    QPen pen;
-    pen.setWidth(1);
-    painter.setPen(pen);
-    for(int i=0;i<m_planes.size();i++){
-        QPointF pos = QPointF(avgX,avgY) + offsets[i];
-        QColor color = playerColor(m_planes[i]);
-
-        painter.setBrush(color);
-        painter.drawEllipse(pos, r, r);
-
-        painter.setPen(Qt::black);
-        painter.drawText(QRectF(pos.x()-r,pos.y()-r,2*r,2*r),
-                         Qt::AlignCenter,
-                         QString::number((m_planes[i]-1)%4 + 1));
-    }
-}
-
-QColor BoardPanel::Tile::playerColor(int planeID) const
-{
-    if (planeID >= 1 && planeID <= 4) return Qt::yellow;
-    if (planeID >= 5 && planeID <= 8) return Qt::blue;
-    if (planeID >= 9 && planeID <= 12) return Qt::green;
-    if (planeID >= 13 && planeID <= 16) return Qt::red;
-    return Qt::gray;
-}
-
-
+#include "boardpanel.h"
+#include <QPainter>
+#include <QPolygonF>
+#include <QResizeEvent>
+#include <QMouseEvent>
+#include <QVariantAnimation>
+#include <QtMath>
+
+namespace {
+// 棋盘拓扑：按格子编号顺序给出每个格子的顶点（格子单位，以棋盘中心为原点）。
+// 三角形只用前三个顶点。
+struct TileShape
+{
+    int pointCount;
+    struct { qint8 x, y; } points[4];
+    Qt::GlobalColor color;
+};
+
+const TileShape TILE_SHAPES[BoardPanel::TILE_COUNT] = {
+    //黄色起点
+    {4, {{-17, -17}, {-13, -17}, {-13, -13}, {-17, -13}}, Qt::yellow},
+    {4, {{-13, -17}, {-9, -17}, {-9, -13}, {-13, -13}}, Qt::yellow},
+    {4, {{-17, -13}, {-13, -13}, {-13, -9}, {-17, -9}}, Qt::yellow},
+    {4, {{-13, -13}, {-9, -13}, {-9, -9}, {-13, -9}}, Qt::yellow},
+    //蓝色起点
+    {4, {{9, -17}, {13, -17}, {13, -13}, {9, -13}}, Qt::blue},
+    {4, {{13, -17}, {17, -17}, {17, -13}, {13, -13}}, Qt::blue},
+    {4, {{9, -13}, {13, -13}, {13, -9}, {9, -9}}, Qt::blue},
+    {4, {{13, -13}, {17, -13}, {17, -9}, {13, -9}}, Qt::blue},
+    //绿色起点
+    {4, {{-17, 9}, {-13, 9}, {-13, 13}, {-17, 13}}, Qt::green},
+    {4, {{-13, 9}, {-9, 9}, {-9, 13}, {-13, 13}}, Qt::green},
+    {4, {{-17, 13}, {-13, 13}, {-13, 17}, {-17, 17}}, Qt::green},
+    {4, {{-13, 13}, {-9, 13}, {-9, 17}, {-13, 17}}, Qt::green},
+    //红色起点
+    {4, {{9, 9}, {13, 9}, {13, 13}, {9, 13}}, Qt::red},
+    {4, {{13, 9}, {17, 9}, {17, 13}, {13, 13}}, Qt::red},
+    {4, {{9, 13}, {13, 13}, {13, 17}, {9, 17}}, Qt::red},
+    {4, {{13, 13}, {17, 13}, {17, 17}, {13, 17}}, Qt::red},
+    //起点三角形
+    {3, {{-17, -9}, {-13, -9}, {-17, -5}, {0, 0}}, Qt::yellow},
+    {3, {{5, -17}, {9, -17}, {9, -13}, {0, 0}}, Qt::blue},
+    {3, {{13, 9}, {17, 5}, {17, 9}, {0, 0}}, Qt::red},
+    {3, {{-9, 13}, {-9, 17}, {-5, 17}, {0, 0}}, Qt::green},
+    //外圈部分21
+    {3, {{-17, -5}, {-13, -5}, {-13, -9}, {0, 0}}, Qt::green},
+    {4, {{-13, -9}, {-11, -9}, {-11, -5}, {-13, -5}}, Qt::yellow},
+    {4, {{-11, -9}, {-9, -9}, {-9, -5}, {-11, -5}}, Qt::blue},
+    //24
+    {3, {{-9, -9}, {-9, -5}, {-5, -5}, {0, 0}}, Qt::red},
+    //25
+    {3, {{-9, -9}, {-5, -9}, {-5, -5}, {0, 0}}, Qt::green},
+    {4, {{-9, -11}, {-5, -11}, {-5, -9}, {-9, -9}}, Qt::yellow},
+    {4, {{-9, -13}, {-5, -13}, {-5, -11}, {-9, -11}}, Qt::blue},
+    //28
+    {3, {{-5, -17}, {-5, -13}, {-9, -13}, {0, 0}}, Qt::red},
+    {4, {{-5, -17}, {-3, -17}, {-3, -13}, {-5, -13}}, Qt::green},
+    {4, {{-3, -17}, {-1, -17}, {-1, -13}, {-3, -13}}, Qt::yellow},
+    {4, {{-1, -17}, {1, -17}, {1, -13}, {-1, -13}}, Qt::blue},
+    {4, {{1, -17}, {3, -17}, {3, -13}, {1, -13}}, Qt::red},
+    {4, {{3, -17}, {5, -17}, {5, -13}, {3, -13}}, Qt::green},
+    //34
+    {3, {{5, -17}, {5, -13}, {9, -13}, {0, 0}}, Qt::yellow},
+    {4, {{5, -13}, {9, -13}, {9, -11}, {5, -11}}, Qt::blue},
+    {4, {{5, -11}, {9, -11}, {9, -9}, {5, -9}}, Qt::red},
+    //37
+    {3, {{9, -9}, {5, -9}, {5, -5}, {0, 0}}, Qt::green},
+    //38
+    {3, {{9, -9}, {9, -5}, {5, -5}, {0, 0}}, Qt::yellow},
+    {4, {{9, -9}, {11, -9}, {11, -5}, {9, -5}}, Qt::blue},
+    {4, {{11, -9}, {13, -9}, {13, -5}, {11, -5}}, Qt::red},
+    //41
+    {3, {{17, -5}, {13, -5}, {13, -9}, {0, 0}}, Qt::green},
+    {4, {{13, -5}, {17, -5}, {17, -3}, {13, -3}}, Qt::yellow},
+    {4, {{13, -3}, {17, -3}, {17, -1}, {13, -1}}, Qt::blue},
+    {4, {{13, -1}, {17, -1}, {17, 1}, {13, 1}}, Qt::red},
+    {4, {{13, 1}, {17, 1}, {17, 3}, {13, 3}}, Qt::green},
+    {4, {{13, 3}, {17, 3}, {17, 5}, {13, 5}}, Qt::yellow},
+    //47
+    {3, {{17, 5}, {13, 5}, {13, 9}, {0, 0}}, Qt::blue},
+    {4, {{11, 5}, {13, 5}, {13, 9}, {11, 9}}, Qt::red},
+    {4, {{9, 5}, {11, 5}, {11, 9}, {9, 9}}, Qt::green},
+    //50
+    {3, {{9, 9}, {9, 5}, {5, 5}, {0, 0}}, Qt::yellow},
+    //51
+    {3, {{9, 9}, {5, 9}, {5, 5}, {0, 0}}, Qt::blue},
+    {4, {{5, 9}, {9, 9}, {9, 11}, {5, 11}}, Qt::red},
+    {4, {{5, 11}, {9, 11}, {9, 13}, {5, 13}}, Qt::green},
+    //54
+    {3, {{5, 17}, {5, 13}, {9, 13}, {0, 0}}, Qt::yellow},
+    {4, {{3, 13}, {5, 13}, {5, 17}, {3, 17}}, Qt::blue},
+    {4, {{1, 13}, {3, 13}, {3, 17}, {1, 17}}, Qt::red},
+    {4, {{-1, 13}, {1, 13}, {1, 17}, {-1, 17}}, Qt::green},
+    {4, {{-3, 13}, {-1, 13}, {-1, 17}, {-3, 17}}, Qt::yellow},
+    {4, {{-5, 13}, {-3, 13}, {-3, 17}, {-5, 17}}, Qt::blue},
+    //60
+    {3, {{-5, 17}, {-5, 13}, {-9, 13}, {0, 0}}, Qt::red},
+    {4, {{-9, 11}, {-5, 11}, {-5, 13}, {-9, 13}}, Qt::green},
+    {4, {{-9, 9}, {-5, 9}, {-5, 11}, {-9, 11}}, Qt::yellow},
+    //63
+    {3, {{-9, 9}, {-5, 9}, {-5, 5}, {0, 0}}, Qt::blue},
+    //64
+    {3, {{-9, 9}, {-9, 5}, {-5, 5}, {0, 0}}, Qt::red},
+    {4, {{-11, 5}, {-9, 5}, {-9, 9}, {-11, 9}}, Qt::green},
+    {4, {{-13, 5}, {-11, 5}, {-11, 9}, {-13, 9}}, Qt::yellow},
+    //67
+    {3, {{-17, 5}, {-13, 5}, {-13, 9}, {0, 0}}, Qt::blue},
+    {4, {{-17, 3}, {-13, 3}, {-13, 5}, {-17, 5}}, Qt::red},
+    {4, {{-17, 1}, {-13, 1}, {-13, 3}, {-17, 3}}, Qt::green},
+    {4, {{-17, -1}, {-13, -1}, {-13, 1}, {-17, 1}}, Qt::yellow},
+    {4, {{-17, -3}, {-13, -3}, {-13, -1}, {-17, -1}}, Qt::blue},
+    {4, {{-17, -5}, {-13, -5}, {-13, -3}, {-17, -3}}, Qt::red},
+    //黄色路径73
+    {4, {{-13, -1}, {-11, -1}, {-11, 1}, {-13, 1}}, Qt::yellow},
+    {4, {{-11, -1}, {-9, -1}, {-9, 1}, {-11, 1}}, Qt::yellow},
+    {4, {{-9, -1}, {-7, -1}, {-7, 1}, {-9, 1}}, Qt::yellow},
+    {4, {{-7, -1}, {-5, -1}, {-5, 1}, {-7, 1}}, Qt::yellow},
+    {4, {{-5, -1}, {-3, -1}, {-3, 1}, {-5, 1}}, Qt::yellow},
+    //78
+    {3, {{-3, -3}, {-3, 3}, {0, 0}, {0, 0}}, Qt::yellow},
+    //蓝色路径79
+    {4, {{-1, -13}, {1, -13}, {1, -11}, {-1, -11}}, Qt::blue},
+    {4, {{-1, -11}, {1, -11}, {1, -9}, {-1, -9}}, Qt::blue},
+    {4, {{-1, -9}, {1, -9}, {1, -7}, {-1, -7}}, Qt::blue},
+    {4, {{-1, -7}, {1, -7}, {1, -5}, {-1, -5}}, Qt::blue},
+    {4, {{-1, -5}, {1, -5}, {1, -3}, {-1, -3}}, Qt::blue},
+    //84
+    {3, {{0, 0}, {-3, -3}, {3, -3}, {0, 0}}, Qt::blue},
+    //红色路径85
+    {4, {{11, -1}, {13, -1}, {13, 1}, {11, 1}}, Qt::red},
+    {4, {{9, -1}, {11, -1}, {11, 1}, {9, 1}}, Qt::red},
+    {4, {{7, -1}, {9, -1}, {9, 1}, {7, 1}}, Qt::red},
+    {4, {{5, -1}, {7, -1}, {7, 1}, {5, 1}}, Qt::red},
+    {4, {{3, -1}, {5, -1}, {5, 1}, {3, 1}}, Qt::red},
+    //90
+    {3, {{3, -3}, {3, 3}, {0, 0}, {0, 0}}, Qt::red},
+    //绿色路径91
+    {4, {{-1, 11}, {1, 11}, {1, 13}, {-1, 13}}, Qt::green},
+    {4, {{-1, 9}, {1, 9}, {1, 11}, {-1, 11}}, Qt::green},
+    {4, {{-1, 7}, {1, 7}, {1, 9}, {-1, 9}}, Qt::green},
+    {4, {{-1, 5}, {1, 5}, {1, 7}, {-1, 7}}, Qt::green},
+    {4, {{-1, 3}, {1, 3}, {1, 5}, {-1, 5}}, Qt::green},
+    //96
+    {3, {{3, 3}, {-3, 3}, {0, 0}, {0, 0}}, Qt::green},
+};
+
+// 圆圈与飞机的半径（格子单位），对应原来 20 像素格子下的 17 与 10 像素
+const qreal CIRCLE_RADIUS = 1.0 / 1.15;
+const qreal PLANE_RADIUS = 0.5;
+// 飞机图集：4 列 6 行，前四行按全局编号排列，第五行是已到达终点的灰色飞机，
+// 最后是可选飞机的高亮圈
+const int ATLAS_COLUMNS = 4;
+const int ATLAS_GLYPHS = 21;
+const int HIGHLIGHT_GLYPH = 20;
+// 每走一格的动画时长，整段动画限制在这个范围内
+const int MOVE_MS_PER_TILE = 120;
+const int MOVE_MIN_MS = 200;
+const int MOVE_MAX_MS = 1200;
+}
+
+BoardPanel::BoardPanel(QWidget *parent)
+    : QWidget(parent)
+{
+    //setStyleSheet("background-color: white;");
+    qDebug() << "Creating boardPanel...";
+    updateTransform();
+
+    moveAnimation = new QVariantAnimation(this);
+    moveAnimation->setStartValue(0.0);
+    moveAnimation->setEndValue(1.0);
+    moveAnimation->setEasingCurve(QEasingCurve::InOutQuad);
+    connect(moveAnimation, &QVariantAnimation::valueChanged, this, [this](const QVariant& value) {
+        if (movingPlane == 0) return;
+        const QRect oldRect = spriteRect(movingPos);
+        movingPos = pointAlongPath(value.toReal());
+        update(oldRect.united(spriteRect(movingPos)));
+    });
+    connect(moveAnimation, &QVariantAnimation::finished, this, &BoardPanel::finishMove);
+}
+
+const std::array<BoardPanel::TileGeometry, BoardPanel::TILE_COUNT> &BoardPanel::boardGeometry()
+{
+    static const std::array<TileGeometry, TILE_COUNT> geometry = []() {
+        std::array<TileGeometry, TILE_COUNT> g;
+        for (int i = 0; i < TILE_COUNT; ++i) {
+            const TileShape& shape = TILE_SHAPES[i];
+            TileGeometry& tile = g[i];
+            tile.pointCount = shape.pointCount;
+            tile.color = QColor(shape.color);
+            QPointF sum;
+            for (int p = 0; p < shape.pointCount; ++p) {
+                tile.points[p] = QPointF(shape.points[p].x, shape.points[p].y);
+                sum += tile.points[p];
+            }
+            tile.centroid = sum / shape.pointCount;
+            //飞机最多向质心四周伸出两个半径
+            const QRectF planeReach(tile.centroid - QPointF(2 * PLANE_RADIUS, 2 * PLANE_RADIUS),
+                                    QSizeF(4 * PLANE_RADIUS, 4 * PLANE_RADIUS));
+            tile.bounds = QPolygonF(QList<QPointF>(tile.points, tile.points + tile.pointCount))
+                              .boundingRect().united(planeReach);
+        }
+        return g;
+    }();
+    return geometry;
+}
+
+const BoardPanel::HitGrid &BoardPanel::hitGrid()
+{
+    static const HitGrid grid = []() {
+        HitGrid g;
+        const qreal bucket = 2.0 * BOARD_HALF_EXTENT / HIT_GRID_BUCKETS;
+        auto bucketOf = [bucket](qreal v) {
+            return qBound(0, int((v + BOARD_HALF_EXTENT) / bucket), HIT_GRID_BUCKETS - 1);
+        };
+        for (int i = 0; i < TILE_COUNT; ++i) {
+            const QRectF& bounds = boardGeometry()[i].bounds;
+            for (int y = bucketOf(bounds.top()); y <= bucketOf(bounds.bottom()); ++y) {
+                for (int x = bucketOf(bounds.left()); x <= bucketOf(bounds.right()); ++x) {
+                    g[y * HIT_GRID_BUCKETS + x].append(i);
+                }
+            }
+        }
+        return g;
+    }();
+    return grid;
+}
+
+int BoardPanel::planeAt(const QPointF &widgetPos) const
+{
+    bool invertible = false;
+    const QPointF p = boardTransform.inverted(&invertible).map(widgetPos);
+    if (!invertible || qAbs(p.x()) > BOARD_HALF_EXTENT || qAbs(p.y()) > BOARD_HALF_EXTENT) return 0;
+
+    const qreal bucket = 2.0 * BOARD_HALF_EXTENT / HIT_GRID_BUCKETS;
+    const int x = qBound(0, int((p.x() + BOARD_HALF_EXTENT) / bucket), HIT_GRID_BUCKETS - 1);
+    const int y = qBound(0, int((p.y() + BOARD_HALF_EXTENT) / bucket), HIT_GRID_BUCKETS - 1);
+    for (int index : hitGrid()[y * HIT_GRID_BUCKETS + x]) {
+        const QList<int> planes = visiblePlanes(index);
+        for (int i = 0; i < planes.size(); ++i) {
+            const QPointF d = p - (boardGeometry()[index].centroid + planeOffset(planes.size(), i));
+            if (QPointF::dotProduct(d, d) <= PLANE_RADIUS * PLANE_RADIUS) return planes[i];
+        }
+    }
+    return 0;
+}
+
+void BoardPanel::mousePressEvent(QMouseEvent *event)
+{
+    if (event->button() == Qt::LeftButton) {
+        const int planeId = planeAt(event->position());
+        if (planeId > 0 && planeId <= 16) {
+            emit planeClicked(planeId);
+            return;
+        }
+    }
+    QWidget::mousePressEvent(event);
+}
+
+void BoardPanel::setSelectablePlanes(const QList<int> &globalPlaneIds)
+{
+    if (selectablePlanes == globalPlaneIds) return;
+    //新旧高亮飞机所在的格子都要重画
+    for (int planeId : selectablePlanes + globalPlaneIds) {
+        const int tile = findPlaneTile(planeId);
+        if (tile > 0) update(tileRect(tile - 1));
+    }
+    selectablePlanes = globalPlaneIds;
+}
+
+void BoardPanel::updateBoardState(const QMap<int, QList<int> > &tilesState)
+{
+    for (auto it = tilesState.constBegin(); it != tilesState.constEnd(); ++it) {
+        if (it.key() < 1 || it.key() > TILE_COUNT) continue;
+        const int index = it.key() - 1;
+        if (tilePlanes[index] == it.value()) continue;
+        tilePlanes[index] = it.value();
+        update(tileRect(index));
+    }
+}
+
+void BoardPanel::animateMove(const PlaneMove &move)
+{
+    //上一段还没播完就直接跳到终点
+    if (movingPlane != 0) {
+        moveAnimation->stop();
+        finishMove();
+    }
+
+    const int fromTile = findPlaneTile(move.globalPlaneId);
+    movePoints.clear();
+    if (fromTile > 0) movePoints.append(boardGeometry()[fromTile - 1].centroid);
+    for (int tileId : move.path) {
+        if (tileId >= 1 && tileId <= TILE_COUNT) movePoints.append(boardGeometry()[tileId - 1].centroid);
+    }
+    if (fromTile <= 0 || movePoints.size() < 2) return;
+
+    movingPlane = move.globalPlaneId;
+    moveDestination = move.path.last();
+    movingPos = movePoints.first();
+    update(tileRect(fromTile - 1));
+
+    moveAnimation->setDuration(qBound(MOVE_MIN_MS, MOVE_MS_PER_TILE * int(movePoints.size() - 1), MOVE_MAX_MS));
+    moveAnimation->start();
+}
+
+void BoardPanel::finishMove()
+{
+    if (movingPlane == 0) return;
+    update(spriteRect(movingPos));
+    //到达终点的飞机会以 100+编号 回到机场，所以按当前所在格子再刷新一次
+    const int currentTile = qMax(findPlaneTile(movingPlane), findPlaneTile(100 + movingPlane));
+    movingPlane = 0;
+    if (moveDestination >= 1 && moveDestination <= TILE_COUNT) {
+        update(tileRect(moveDestination - 1));
+    }
+    if (currentTile > 0) update(tileRect(currentTile - 1));
+}
+
+int BoardPanel::findPlaneTile(int globalPlaneId) const
+{
+    for (int i = 0; i < TILE_COUNT; ++i) {
+        if (tilePlanes[i].contains(globalPlaneId)) return i + 1;
+    }
+    return -1;
+}
+
+QPointF BoardPanel::pointAlongPath(qreal progress) const
+{
+    //路径按格子等分，progress 已经过缓动曲线
+    const int segments = int(movePoints.size()) - 1;
+    if (segments <= 0) return movePoints.value(0);
+    const qreal t = qBound<qreal>(0.0, progress, 1.0) * segments;
+    const int i = qMin(int(t), segments - 1);
+    const qreal frac = t - i;
+    return movePoints[i] + (movePoints[i + 1] - movePoints[i]) * frac;
+}
+
+QRect BoardPanel::spriteRect(const QPointF &pos) const
+{
+    const QRectF sprite(pos - QPointF(PLANE_RADIUS, PLANE_RADIUS), QSizeF(2 * PLANE_RADIUS, 2 * PLANE_RADIUS));
+    //精灵四周有一个像素的边，贴图时还会对齐到物理像素
+    return boardTransform.mapRect(sprite).toAlignedRect().adjusted(-2, -2, 2, 2);
+}
+
+QRect BoardPanel::tileRect(int index) const
+{
+    //多留两个像素给抗锯齿边缘和飞机精灵的像素对齐
+    return boardTransform.mapRect(boardGeometry()[index].bounds).toAlignedRect().adjusted(-2, -2, 2, 2);
+}
+
+int BoardPanel::getCellSize() const
+{
+    return qRound(boardTransform.m11());
+}
+
+void BoardPanel::paintEvent(QPaintEvent *event)
+{
+    //棋盘本身不会变化，缓存成位图，每次只贴图再画飞机
+    const qreal dpr = devicePixelRatioF();
+    if (boardLayer.isNull() || boardLayer.devicePixelRatio() != dpr
+        || boardLayer.size() != (QSizeF(size()) * dpr).toSize()) {
+        renderBoardLayer();
+    }
+    if (planeAtlas.isNull() || planeAtlas.devicePixelRatio() != dpr) {
+        renderPlaneAtlas();
+    }
+
+    //只重绘脏区域：贴对应部分的底图，再画与脏区域相交的格子上的飞机
+    const QRegion dirty = event->region();
+    QPainter painter(this);
+    for (const QRect& r : dirty) {
+        painter.drawPixmap(r, boardLayer, QRectF(QPointF(r.topLeft()) * dpr, QSizeF(r.size()) * dpr));
+    }
+
+    //飞机直接从图集贴图，不再逐个画圆和排版文字
+    for (int i = 0; i < TILE_COUNT; ++i) {
+        if (!tilePlanes[i].isEmpty() && dirty.intersects(tileRect(i))) {
+            drawPlanes(painter, i);
+        }
+    }
+    if (movingPlane != 0 && dirty.intersects(spriteRect(movingPos))) {
+        drawPlaneGlyph(painter, movingPos, movingPlane);
+    }
+}
+
+void BoardPanel::renderBoardLayer()
+{
+    const qreal dpr = devicePixelRatioF();
+    boardLayer = QPixmap((QSizeF(size()) * dpr).toSize());
+    boardLayer.setDevicePixelRatio(dpr);
+    boardLayer.fill(Qt::transparent);
+
+    QPainter painter(&boardLayer);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setTransform(boardTransform);
+    for (int i = 0; i < TILE_COUNT; ++i) {
+        drawTile(painter, i);
+    }
+}
+
+void BoardPanel::renderPlaneAtlas()
+{
+    //每个精灵按当前格子大小画一次，四周各留一个像素给抗锯齿边缘
+    const qreal dpr = devicePixelRatioF();
+    const qreal cell = boardTransform.m11();
+    const qreal radius = PLANE_RADIUS * cell;
+    const qreal spriteSize = 2 * radius + 2;
+    atlasSprite = qCeil(spriteSize * dpr);
+
+    const int rows = (ATLAS_GLYPHS + ATLAS_COLUMNS - 1) / ATLAS_COLUMNS;
+    planeAtlas = QPixmap(atlasSprite * ATLAS_COLUMNS, atlasSprite * rows);
+    planeAtlas.setDevicePixelRatio(dpr);
+    planeAtlas.fill(Qt::transparent);
+
+    QPainter painter(&planeAtlas);
+    painter.setRenderHint(QPainter::Antialiasing);
+    QPen pen(Qt::black);
+    pen.setCosmetic(true);
+    painter.setPen(pen);
+    QFont font = painter.font();
+    font.setPixelSize(qMax(6, qRound(cell * 0.6)));
+    painter.setFont(font);
+
+    const qreal logicalSprite = atlasSprite / dpr;
+    for (int glyph = 0; glyph < ATLAS_GLYPHS; ++glyph) {
+        const QPointF origin((glyph % ATLAS_COLUMNS) * logicalSprite, (glyph / ATLAS_COLUMNS) * logicalSprite);
+        const QPointF center = origin + QPointF(logicalSprite / 2, logicalSprite / 2);
+        if (glyph == HIGHLIGHT_GLYPH) {
+            QPen ring(QColor(255, 140, 0), 2);
+            ring.setCosmetic(true);
+            painter.setPen(ring);
+            painter.setBrush(Qt::NoBrush);
+            painter.drawEllipse(center, radius, radius);
+            painter.setPen(pen);
+            continue;
+        }
+        const int planeId = glyph < 16 ? glyph + 1 : 100 + glyph - 15;
+        painter.setBrush(playerColor(planeId));
+        painter.drawEllipse(center, radius, radius);
+        painter.drawText(QRectF(center - QPointF(radius, radius), QSizeF(2 * radius, 2 * radius)),
+                         Qt::AlignCenter, QString::number(glyph % 4 + 1));
+    }
+}
+
+int BoardPanel::glyphIndex(int planeId)
+{
+    if (planeId >= 1 && planeId <= 16) return planeId - 1;
+    //已到达终点（100+编号）或其它编号都画成灰色
+    return 16 + qAbs(planeId - 1) % 4;
+}
+
+void BoardPanel::resizeEvent(QResizeEvent *event)
+{
+    QWidget::resizeEvent(event);
+    updateTransform();
+}
+
+void BoardPanel::updateTransform()
+{
+    //整个棋盘等比缩放到控件里居中显示，只更新变换矩阵，不重建格子
+    const qreal cell = qMax<qreal>(1.0, qMin(width(), height()) / (2.0 * BOARD_HALF_EXTENT + 1.0));
+    boardTransform.reset();
+    boardTransform.translate(width() / 2.0, height() / 2.0);
+    boardTransform.scale(cell, cell);
+    planeAtlas = QPixmap(); // 格子大小变了，飞机精灵要重画
+    update();
+}
+
+void BoardPanel::drawTile(QPainter &painter, int index) const
+{
+    const TileGeometry& tile = boardGeometry()[index];
+
+    QPen pen(Qt::black);
+    pen.setWidth(1);
+    pen.setCosmetic(true); // 线宽不随缩放变化
+    painter.setPen(pen);
+    painter.setBrush(tile.color);
+    painter.drawPolygon(tile.points, tile.pointCount);
+
+    painter.setBrush(QColor(240,240,240));
+    painter.drawEllipse(tile.centroid, CIRCLE_RADIUS, CIRCLE_RADIUS);
+}
+
+void BoardPanel::drawPlanes(QPainter &painter, int index) const
+{
+    const QList<int> planes = visiblePlanes(index);
+    const QPointF center = boardGeometry()[index].centroid;
+    for(int i=0;i<planes.size();i++){
+        const QPointF pos = center + planeOffset(planes.size(), i);
+        drawPlaneGlyph(painter, pos, planes[i]);
+        if (selectablePlanes.contains(planes[i])) drawGlyph(painter, pos, HIGHLIGHT_GLYPH);
+    }
+}
+
+QList<int> BoardPanel::visiblePlanes(int index) const
+{
+    QList<int> planes = tilePlanes[index];
+    if (movingPlane != 0) planes.removeAll(movingPlane); // 移动中的飞机单独绘制
+    return planes;
+}
+
+QPointF BoardPanel::planeOffset(int count, int slot)
+{
+    //一架飞机画在质心；两架左右排开；三四架排成田字
+    const qreal r = PLANE_RADIUS;
+    static const QPointF twoOffsets[2] = { QPointF(-r,0), QPointF(r,0) };
+    static const QPointF fourOffsets[4] = { QPointF(-r,-r), QPointF(r,-r), QPointF(-r,r), QPointF(r,r) };
+    if (count == 2) return twoOffsets[slot];
+    if (count > 2 && count <= 4) return fourOffsets[slot];
+    return QPointF(0, 0);
+}
+
+void BoardPanel::drawPlaneGlyph(QPainter &painter, const QPointF &pos, int planeId) const
+{
+    drawGlyph(painter, pos, glyphIndex(planeId));
+}
+
+void BoardPanel::drawGlyph(QPainter &painter, const QPointF &pos, int glyph) const
+{
+    //pos 是格子单位；对齐到物理像素，保证图集按 1:1 贴上去不被重采样
+    const qreal dpr = planeAtlas.devicePixelRatio();
+    const qreal logicalSprite = atlasSprite / dpr;
+    const QPointF center = boardTransform.map(pos);
+    const QPointF topLeft(qRound((center.x() - logicalSprite / 2) * dpr) / dpr,
+                          qRound((center.y() - logicalSprite / 2) * dpr) / dpr);
+
+    const QRectF source((glyph % ATLAS_COLUMNS) * atlasSprite, (glyph / ATLAS_COLUMNS) * atlasSprite,
+                        atlasSprite, atlasSprite);
+    painter.drawPixmap(QRectF(topLeft, QSizeF(logicalSprite, logicalSprite)), planeAtlas, source);
+}
+
+QColor BoardPanel::playerColor(int planeID)
+{
+    if (planeID >= 1 && planeID <= 4) return Qt::yellow;
+    if (planeID >= 5 && planeID <= 8) return Qt::blue;
+    if (planeID >= 9 && planeID <= 12) return Qt::green;
+    if (planeID >= 13 && planeID <= 16) return Qt::red;
+    return Qt::gray;
+}
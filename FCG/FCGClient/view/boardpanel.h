@@ -1,56 +1,97 @@
-#ifndef BOARDPANEL_H
-#define BOARDPANEL_H
-
-#include <QWidget>
-#include <QPolygon>
-#include <QColor>
-#include <QList>
-#include <QMap>
-
-
-class BoardPanel : public QWidget
-{
-    Q_OBJECT
-public:
-    explicit BoardPanel(QWidget *parent = nullptr);
-
-    void updateBoardState(const QMap<int , QList<int>>& tilesState);
-    int getCellSize()const{return cellSize;}
-    int cellSize = 20;
-
-protected:
-    void paintEvent(QPaintEvent *event) override;
-    void resizeEvent(QResizeEvent *event) override;
-
-private:
-    class Tile{
-    public:
-        Tile(int id,const QPolygon& poly,const QColor& color);
-
-        void draw(QPainter& painter ) const;
-        int tileID() const{return m_id;}
-
-        QList<int> getplanes()const{return m_planes;}
-        void setPlanes(const QList<int>& planes){ m_planes = planes;}
-
-    private:
-        void drawCircle(QPainter& painter) const;
-        void drawPlanes(QPainter& painter) const;
-        QColor playerColor(int planeID) const;
-
-        int m_id;
-        QPolygon m_polygon;
-        QColor m_baseColor;
-        QList<int> m_planes;
-    };
-
-    void computeBoard();
-    void addRectTile(int x,int y,int w,int h,const QColor& color);
-    void addTriangle(const QVector<QPoint>& points,const QColor& color);
-
-    QList<Tile*> tiles;
-    int nextTileID = 1;
-    QPoint center;
-};
-
-#endif // BOARDPANEL_H
+#ifndef BOARDPANEL_H
+#define BOARDPANEL_H
+
+#include <QWidget>
+#include <QColor>
+#include <QList>
+#include <QMap>
+#include <QPointF>
+#include <QTransform>
+#include <QPixmap>
+#include <array>
+#include <model/protocol.h>
+
+class QVariantAnimation;
+
+
+class BoardPanel : public QWidget
+{
+    Q_OBJECT
+public:
+    static const int TILE_COUNT = 96;
+    // 棋盘外沿到中心的距离（格子单位）
+    static const int BOARD_HALF_EXTENT = 17;
+
+    explicit BoardPanel(QWidget *parent = nullptr);
+
+    // tilesState 可以只包含部分格子，只有内容变化的格子会被重绘
+    void updateBoardState(const QMap<int , QList<int>>& tilesState);
+    // 当前一个格子单位对应的像素数
+    int getCellSize() const;
+    // 沿服务器给出的路径播放一次飞机移动动画；期间该飞机不在格子上绘制
+    void animateMove(const PlaneMove& move);
+
+public slots:
+    // 高亮这些飞机（全局编号），表示本回合可以点击移动
+    void setSelectablePlanes(const QList<int>& globalPlaneIds);
+
+signals:
+    void planeClicked(int globalPlaneId);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+
+private:
+    // 格子的几何形状：以棋盘中心为原点、格子边长为单位，与窗口大小无关，所有面板共享一份
+    struct TileGeometry
+    {
+        QPointF points[4];
+        int pointCount = 0;
+        QPointF centroid;
+        QRectF bounds;      // 格子连同其上飞机的外接矩形，用于局部重绘
+        QColor color;
+    };
+    static const std::array<TileGeometry, TILE_COUNT>& boardGeometry();
+
+    // 点击检测用的均匀网格：把棋盘切成 HIT_GRID_BUCKETS×HIT_GRID_BUCKETS 个桶，
+    // 每个桶记录外接矩形与之相交的格子下标，点击时只检查一个桶里的几个格子
+    static const int HIT_GRID_BUCKETS = 17;
+    using HitGrid = std::array<QList<int>, HIT_GRID_BUCKETS * HIT_GRID_BUCKETS>;
+    static const HitGrid& hitGrid();
+    int planeAt(const QPointF& widgetPos) const;
+
+    void updateTransform();
+    void renderBoardLayer();
+    void renderPlaneAtlas();
+    static int glyphIndex(int planeId);
+    QRect tileRect(int index) const;
+    void drawTile(QPainter& painter, int index) const;
+    void drawPlanes(QPainter& painter, int index) const;
+    void drawPlaneGlyph(QPainter& painter, const QPointF& pos, int planeId) const;
+    void drawGlyph(QPainter& painter, const QPointF& pos, int glyph) const;
+    QList<int> visiblePlanes(int index) const;
+    static QPointF planeOffset(int count, int slot);
+    QRect spriteRect(const QPointF& pos) const;
+    QPointF pointAlongPath(qreal progress) const;
+    int findPlaneTile(int globalPlaneId) const;
+    void finishMove();
+    static QColor playerColor(int planeID);
+
+    std::array<QList<int>, TILE_COUNT> tilePlanes;  // 下标为 格子编号-1
+    QTransform boardTransform;                      // 格子单位 -> 控件像素，只在尺寸变化时更新
+    QPixmap boardLayer;                             // 静态棋盘（格子与圆圈），按尺寸与 DPR 缓存
+    QPixmap planeAtlas;                             // 16 架飞机 + 4 个已到达的灰色飞机，按格子大小与 DPR 缓存
+    int atlasSprite = 0;                            // 图集中每个精灵的边长（物理像素）
+    QList<int> selectablePlanes;                    // 高亮的飞机（全局编号）
+
+    //移动动画：一个 QVariantAnimation 驱动进度 0~1，只重绘飞机精灵经过的区域
+    QVariantAnimation* moveAnimation;
+    QList<QPointF> movePoints;                      // 路径上各格子的质心（格子单位）
+    int movingPlane = 0;                            // 正在移动的飞机全局编号，0 表示没有动画
+    int moveDestination = 0;
+    QPointF movingPos;
+};
+
+#endif // BOARDPANEL_H
@@ -1,85 +1,189 @@
-#include "connectdialog.h"
-
-
-ConnectDialog::ConnectDialog(QWidget *parent)
-    : QDialog(parent)
-{
-    setupUI();
-    setWindowTitle(tr("连接到服务器"));
-    setModal(true);
-}
-
-QString ConnectDialog::getHost() const
-{
-    return hostEdit->text().trimmed();
-}
-
-int ConnectDialog::getPort() const
-{
-    return portEdit->text().toInt();
-}
-
-QString ConnectDialog::getUsername() const
-{
-    return usernameEdit->text().trimmed();
-}
-
-void ConnectDialog::setupUI()
-{
-    hostEdit = new QLineEdit(this);
-    hostEdit->setText("localhost");
-    hostEdit->setPlaceholderText(tr("Server IP or hostname"));
-
-    portEdit = new QLineEdit(this);
-    portEdit->setText("12345");
-    portEdit->setValidator(new QIntValidator(1,65535,this));
-    portEdit->setPlaceholderText(tr("Port number (1-65535)"));
-
-    usernameEdit = new QLineEdit(this);
-    usernameEdit->setPlaceholderText(tr("Your nickname"));
-
-    connectButton = new QPushButton(tr("Connect"),this);
-    cancelButton = new QPushButton(tr("Cancel"),this);
-
-    //布局
-    QFormLayout *formLayout = new QFormLayout();
-    formLayout->addRow(tr("Server:"),hostEdit);
-    formLayout->addRow(tr("Port:"),portEdit);
-    formLayout->addRow(tr("Username:"),usernameEdit);
-
-    QHBoxLayout *buttonLayout = new QHBoxLayout();
-    buttonLayout->addStretch();
-    buttonLayout->addWidget(connectButton);
-    buttonLayout->addWidget(cancelButton);
-
-    QVBoxLayout *mainLayout = new QVBoxLayout(this);
-    mainLayout->addLayout(formLayout);
-    mainLayout->addLayout(buttonLayout);
-
-    connect(connectButton, &QPushButton::clicked,this,&ConnectDialog::onConnectClicked);
-    connect(cancelButton, &QPushButton::clicked, this, &QDialog::reject);
-}
-
-void ConnectDialog::onConnectClicked()
-{
-    if(validateInput()){
-        accept();
-    }
-    else{
-        QMessageBox::warning(this,
-                             tr("Invalid Input"),
-                             tr("Please check:\n"
-                                "- Valid host address\n"
-                                "- Port between 1-65535\n"
-                                "- Non-empty username"));
-        hostEdit->setText("localhost");
-        portEdit->setText("12345");
-        usernameEdit->clear();
-        hostEdit->setFocus();
-    }
-}
-bool ConnectDialog::validateInput() const
-{
-    return !hostEdit->text().isEmpty() && portEdit->hasAcceptableInput() && !usernameEdit->text().trimmed().isEmpty() ;
-}
-
+#include "connectdialog.h"
+#include <QHostInfo>
+#include <QSettings>
+
+namespace {
+// 停止输入这么久之后才开始解析和预连接，避免每敲一个字符就发起一次
+const int WARM_UP_DELAY_MS = 300;
+const int MAX_RECENT_SERVERS = 5;
+const char* const RECENT_SERVERS_KEY = "recentServers";
+}
+
+ConnectDialog::ConnectDialog(QWidget *parent)
+    : QDialog(parent)
+{
+    setupUI();
+    setWindowTitle(tr("连接到服务器"));
+    setModal(true);
+
+    warmUpTimer.setSingleShot(true);
+    warmUpTimer.setInterval(WARM_UP_DELAY_MS);
+    connect(&warmUpTimer, &QTimer::timeout, this, &ConnectDialog::warmUp);
+    connect(hostEdit, &QLineEdit::textChanged, this, &ConnectDialog::onServerEdited);
+    connect(portEdit, &QLineEdit::textChanged, this, &ConnectDialog::onServerEdited);
+    //默认地址也立即预热
+    onServerEdited();
+}
+
+QString ConnectDialog::getHost() const
+{
+    return hostEdit->text().trimmed();
+}
+
+int ConnectDialog::getPort() const
+{
+    return portEdit->text().toInt();
+}
+
+int ConnectDialog::getTableSize() const
+{
+    return tableSizeCombo->currentData().toInt();
+}
+
+QString ConnectDialog::getUsername() const
+{
+    return usernameEdit->text().trimmed();
+}
+
+void ConnectDialog::setupUI()
+{
+    recentCombo = new QComboBox(this);
+    recentCombo->setPlaceholderText(tr("Recent servers"));
+
+    hostEdit = new QLineEdit(this);
+    hostEdit->setText("localhost");
+    hostEdit->setPlaceholderText(tr("Server IP or hostname"));
+
+    portEdit = new QLineEdit(this);
+    portEdit->setText("12345");
+    portEdit->setValidator(new QIntValidator(1,65535,this));
+    portEdit->setPlaceholderText(tr("Port number (1-65535)"));
+
+    usernameEdit = new QLineEdit(this);
+    usernameEdit->setPlaceholderText(tr("Your nickname"));
+
+    tableSizeCombo = new QComboBox(this);
+    tableSizeCombo->addItem(tr("Any"), 0);
+    for (int size = 2; size <= 4; ++size) {
+        tableSizeCombo->addItem(tr("%1 players").arg(size), size);
+    }
+
+    connectButton = new QPushButton(tr("Connect"),this);
+    cancelButton = new QPushButton(tr("Cancel"),this);
+
+    loadRecentServers();
+
+    //布局
+    QFormLayout *formLayout = new QFormLayout();
+    if (recentCombo->count() > 0) {
+        formLayout->addRow(tr("Recent:"),recentCombo);
+    } else {
+        recentCombo->hide();
+    }
+    formLayout->addRow(tr("Server:"),hostEdit);
+    formLayout->addRow(tr("Port:"),portEdit);
+    formLayout->addRow(tr("Username:"),usernameEdit);
+    formLayout->addRow(tr("Table size:"),tableSizeCombo);
+
+    QHBoxLayout *buttonLayout = new QHBoxLayout();
+    buttonLayout->addStretch();
+    buttonLayout->addWidget(connectButton);
+    buttonLayout->addWidget(cancelButton);
+
+    QVBoxLayout *mainLayout = new QVBoxLayout(this);
+    mainLayout->addLayout(formLayout);
+    mainLayout->addLayout(buttonLayout);
+
+    connect(connectButton, &QPushButton::clicked,this,&ConnectDialog::onConnectClicked);
+    connect(cancelButton, &QPushButton::clicked, this, &QDialog::reject);
+    connect(recentCombo, &QComboBox::activated, this, [this](int index) {
+        const QStringList parts = recentCombo->itemData(index).toStringList();
+        if (parts.size() != 2) return;
+        hostEdit->setText(parts.at(0));
+        portEdit->setText(parts.at(1));
+    });
+}
+
+void ConnectDialog::onServerEdited()
+{
+    warmUpTimer.start();
+}
+
+void ConnectDialog::warmUp()
+{
+    if (!validateServer()) return;
+    const QString host = getHost();
+    const int port = getPort();
+
+    //解析结果会进入 Qt 的主机名缓存，之后 connectToHost 直接命中
+    if (lookupId != -1) QHostInfo::abortHostLookup(lookupId);
+    lookupId = QHostInfo::lookupHost(host, this, [this, host, port](const QHostInfo& info) {
+        lookupId = -1;
+        if (info.error() != QHostInfo::NoError) {
+            qDebug() << "ConnectDialog: Warm-up lookup failed for" << host << info.errorString();
+            return;
+        }
+        //地址在解析期间又被改过，就不再预连接
+        if (host != getHost() || port != getPort()) return;
+        qDebug() << "ConnectDialog: Resolved" << host << "to" << info.addresses();
+        emit serverReady(host, port);
+    });
+}
+
+void ConnectDialog::loadRecentServers()
+{
+    QSettings settings;
+    const QStringList recent = settings.value(RECENT_SERVERS_KEY).toStringList();
+    for (const QString& entry : recent) {
+        const int colon = entry.lastIndexOf(':');
+        if (colon <= 0) continue;
+        recentCombo->addItem(entry, QStringList{entry.left(colon), entry.mid(colon + 1)});
+    }
+    //上次连过的服务器作为默认值
+    if (recentCombo->count() > 0) {
+        const QStringList parts = recentCombo->itemData(0).toStringList();
+        hostEdit->setText(parts.at(0));
+        portEdit->setText(parts.at(1));
+    }
+}
+
+void ConnectDialog::saveRecentServer()
+{
+    QSettings settings;
+    QStringList recent = settings.value(RECENT_SERVERS_KEY).toStringList();
+    const QString entry = QString("%1:%2").arg(getHost()).arg(getPort());
+    recent.removeAll(entry);
+    recent.prepend(entry);
+    while (recent.size() > MAX_RECENT_SERVERS) recent.removeLast();
+    settings.setValue(RECENT_SERVERS_KEY, recent);
+}
+
+void ConnectDialog::onConnectClicked()
+{
+    if(validateInput()){
+        saveRecentServer();
+        accept();
+    }
+    else{
+        QMessageBox::warning(this,
+                             tr("Invalid Input"),
+                             tr("Please check:\n"
+                                "- Valid host address\n"
+                                "- Port between 1-65535\n"
+                                "- Non-empty username"));
+        hostEdit->setText("localhost");
+        portEdit->setText("12345");
+        usernameEdit->clear();
+        hostEdit->setFocus();
+    }
+}
+bool ConnectDialog::validateInput() const
+{
+    return validateServer() && !usernameEdit->text().trimmed().isEmpty() ;
+}
+
+bool ConnectDialog::validateServer() const
+{
+    return !hostEdit->text().trimmed().isEmpty() && portEdit->hasAcceptableInput();
+}
+
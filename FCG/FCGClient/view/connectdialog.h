@@ -1,33 +1,51 @@
-#ifndef CONNECTDIALOG_H
-#define CONNECTDIALOG_H
-
-#include <QDialog>
-#include <QLineEdit>
-#include <QPushButton>
-#include <QFormLayout>
-#include <QPushButton>
-#include <QMessageBox>
-#include <QIntValidator>
-
-class ConnectDialog : public QDialog
-{
-
-public:
-    explicit ConnectDialog(QWidget *parent = nullptr);
-    QString getHost() const;
-    int getPort() const;
-    QString getUsername() const;
-
-private:
-    QLineEdit *hostEdit;
-    QLineEdit *portEdit;
-    QLineEdit *usernameEdit;
-    QPushButton *connectButton;
-    QPushButton *cancelButton;
-
-    void setupUI();
-    bool validateInput() const;
-    void onConnectClicked();
-};
-
-#endif // CONNECTDIALOG_H
+#ifndef CONNECTDIALOG_H
+#define CONNECTDIALOG_H
+
+#include <QDialog>
+#include <QLineEdit>
+#include <QPushButton>
+#include <QFormLayout>
+#include <QPushButton>
+#include <QMessageBox>
+#include <QIntValidator>
+#include <QComboBox>
+#include <QTimer>
+
+class ConnectDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit ConnectDialog(QWidget *parent = nullptr);
+    QString getHost() const;
+    int getPort() const;
+    // 0 表示不限人数
+    int getTableSize() const;
+    QString getUsername() const;
+
+signals:
+    // 地址停止编辑一小段时间且已解析成功后发出，可以据此预先建立连接
+    void serverReady(const QString& host, int port);
+
+private:
+    QComboBox *recentCombo;
+    QLineEdit *hostEdit;
+    QLineEdit *portEdit;
+    QLineEdit *usernameEdit;
+    QComboBox *tableSizeCombo;
+    QPushButton *connectButton;
+    QPushButton *cancelButton;
+    QTimer warmUpTimer;
+    int lookupId = -1;
+
+    void setupUI();
+    bool validateInput() const;
+    bool validateServer() const;
+    void onConnectClicked();
+    void onServerEdited();
+    void warmUp();
+    void loadRecentServers();
+    void saveRecentServer();
+};
+
+#endif // CONNECTDIALOG_H
@@ -1,70 +1,86 @@
-#ifndef CONTROLPANEL_H
-#define CONTROLPANEL_H
-
-#include <QWidget>
-#include <QLabel>
-#include <QObject>
-#include <QPushButton>
-#include <QButtonGroup>
-#include <QVBoxLayout>
-#include <QHBoxLayout>
-#include <QGroupBox>
-#include <QMessageBox>
-#include <QRandomGenerator>
-#include <QTextEdit>
-class GameController;
-class MainView;
-
-
-class ControlPanel : public QWidget
-{
-    Q_OBJECT
-
-public:
-
-    enum GamePhase {
-        ROLL_AND_CHOOSE_PLANE,
-        CHOOSE_FLY_OVER,
-        WAITING,
-        GAME_ENDED
-    };
-    Q_ENUM(GamePhase)
-
-    explicit ControlPanel(MainView* gameView,QWidget *parent = nullptr);
-    void setGamePhase(GamePhase phase, const QString& message);
-    //void setDiceResult(int value);
-
-signals:
-    //void readyClicked();
-    //void rollDiceClicked();
-    void planeSelected(int planeId);
-    void flyOverChoice(bool accepted);
-
-private slots:
-    void handleReady();
-    void handleRollDice();
-    void handlePlaneButton(int id);
-    void handleFlyOver(bool yes);
-
-private:
-    void setupUI();
-    void setupConnections();
-    void setAllControlsEnabled(bool enabled);
-
-    MainView* gameView;
-    GameController* controller;
-
-    // UI Components
-    QLabel* serverMessage;
-    QPushButton* readyButton;
-    QPushButton* rollDiceButton;
-    QPushButton* planeButton1;
-    QPushButton* planeButton2;
-    QPushButton* planeButton3;
-    QPushButton* planeButton4;
-    QPushButton* flyYesButton;
-    QPushButton* flyNoButton;
-    // State
-    int currentDice = 0;
-};
-#endif // CONTROLPANEL_H
+#ifndef CONTROLPANEL_H
+#define CONTROLPANEL_H
+
+#include <QWidget>
+#include <QLabel>
+#include <QObject>
+#include <QPushButton>
+#include <QButtonGroup>
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QGroupBox>
+#include <QMessageBox>
+#include <QRandomGenerator>
+#include <QTextEdit>
+#include <QComboBox>
+class GameController;
+class MainView;
+
+
+class ControlPanel : public QWidget
+{
+    Q_OBJECT
+
+public:
+
+    enum GamePhase {
+        ROLL_AND_CHOOSE_PLANE,
+        CHOOSE_FLY_OVER,
+        WAITING,
+        GAME_ENDED,
+        LOBBY           // 尚未开局，可以点“准备”
+    };
+    Q_ENUM(GamePhase)
+
+    explicit ControlPanel(MainView* gameView,QWidget *parent = nullptr);
+    void setGamePhase(GamePhase phase, const QString& message);
+    void showHint(int planeId, bool fly);
+    //void setDiceResult(int value);
+
+public slots:
+    //棋盘上点击了飞机（全局编号），只接受自己可以移动的飞机
+    void selectPlane(int globalPlaneId);
+
+signals:
+    //void readyClicked();
+    //void rollDiceClicked();
+    void planeSelected(int planeId);
+    void flyOverChoice(bool accepted);
+    //投骰子后可以移动的飞机（全局编号），空列表表示取消高亮
+    void movablePlanesChanged(const QList<int>& globalPlaneIds);
+
+private slots:
+    void handleReady();
+    void handleRollDice();
+    void handlePlaneButton(int id);
+    void handleFlyOver(bool yes);
+    void handleHint();
+
+private:
+    void setupUI();
+    void setupConnections();
+    void setAllControlsEnabled(bool enabled);
+    void updateMovablePlanes();
+    void clearMovablePlanes();
+    QPushButton* planeButton(int planeId) const;
+
+    MainView* gameView;
+    GameController* controller;
+
+    // UI Components
+    QLabel* serverMessage;
+    QPushButton* readyButton;
+    QPushButton* rollDiceButton;
+    QPushButton* hintButton;
+    QPushButton* planeButton1;
+    QPushButton* planeButton2;
+    QPushButton* planeButton3;
+    QPushButton* planeButton4;
+    QPushButton* flyYesButton;
+    QPushButton* flyNoButton;
+    QComboBox* flyPolicyBox;
+    // State
+    int currentDice = 0;
+    bool readySent = false;
+};
+#endif // CONTROLPANEL_H
@@ -1,5 +1,5 @@
-#include "mainwindow.h"
-
-MainWindow::MainWindow(QWidget *parent)
-    : QMainWindow{parent}
-{}
+#include "mainwindow.h"
+
+MainWindow::MainWindow(QWidget *parent)
+    : QMainWindow{parent}
+{}
@@ -0,0 +1,50 @@
+#include "toastwidget.h"
+#include <QEvent>
+
+ToastWidget::ToastWidget(QWidget *parent)
+    : QLabel(parent)
+{
+    setAttribute(Qt::WA_TransparentForMouseEvents);
+    setAlignment(Qt::AlignCenter);
+    setWordWrap(true);
+    setStyleSheet(
+        "QLabel {"
+        "  background-color: rgba(40, 40, 40, 200);"
+        "  color: white;"
+        "  border-radius: 6px;"
+        "  padding: 8px 16px;"
+        "}"
+        );
+    hide();
+
+    hideTimer.setSingleShot(true);
+    connect(&hideTimer, &QTimer::timeout, this, &QWidget::hide);
+    //父窗口改变大小时跟着重新摆放
+    parent->installEventFilter(this);
+}
+
+void ToastWidget::showToast(const QString &message, int durationMs)
+{
+    setText(message);
+    reposition();
+    show();
+    raise();
+    hideTimer.start(durationMs);
+}
+
+bool ToastWidget::eventFilter(QObject *watched, QEvent *event)
+{
+    if (watched == parentWidget() && event->type() == QEvent::Resize && isVisible()) {
+        reposition();
+    }
+    return QLabel::eventFilter(watched, event);
+}
+
+void ToastWidget::reposition()
+{
+    QWidget *p = parentWidget();
+    const int maxWidth = qMax(100, p->width() / 2);
+    setMaximumWidth(maxWidth);
+    adjustSize();
+    move((p->width() - width()) / 2, p->height() - height() - 40);
+}
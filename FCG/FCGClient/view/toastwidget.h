@@ -0,0 +1,26 @@
+#ifndef TOASTWIDGET_H
+#define TOASTWIDGET_H
+
+#include <QLabel>
+#include <QTimer>
+
+// 浮在父窗口底部的短暂提示，几秒后自动消失，不抢焦点也不阻塞事件循环。
+// 新消息直接替换正在显示的旧消息。
+class ToastWidget : public QLabel
+{
+    Q_OBJECT
+public:
+    explicit ToastWidget(QWidget *parent);
+
+    void showToast(const QString &message, int durationMs = 2500);
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private:
+    QTimer hideTimer;
+
+    void reposition();
+};
+
+#endif // TOASTWIDGET_H
@@ -0,0 +1,26 @@
+QT += core network websockets
+QT -= gui
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+# You can make your code fail to compile if it uses deprecated APIs.
+# In order to do so, uncomment the following line.
+#DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
+
+INCLUDEPATH += ../FCGClient
+
+SOURCES += \
+    ../FCGClient/controller/muxtransport.cpp \
+    gateway.cpp \
+    main.cpp
+
+HEADERS += \
+    ../FCGClient/controller/muxtransport.h \
+    ../FCGClient/model/protocol.h \
+    gateway.h
+
+# Default rules for deployment.
+qnx: target.path = /tmp/$${TARGET}/bin
+else: unix:!android: target.path = /opt/$${TARGET}/bin
+!isEmpty(target.path): INSTALLS += target
@@ -0,0 +1,157 @@
+#include "gateway.h"
+#include <model/protocol.h>
+#include <QDebug>
+#include <QLocalSocket>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QWebSocket>
+#include <QtEndian>
+#include <memory>
+
+namespace {
+const int RECONNECT_DELAY_MS = 1000;
+// 浏览器发来的单帧上限，与服务器对普通连接的容忍度一致即可
+const int MAX_CLIENT_FRAME = 64 * 1024;
+}
+
+Gateway::Gateway(const GatewayOptions& gatewayOptions, QObject *parent)
+    : QObject(parent),
+    options(gatewayOptions),
+    server(QStringLiteral("FCGGateway"), QWebSocketServer::NonSecureMode)
+{
+    options.upstreamLinks = qMax(1, options.upstreamLinks);
+    for (int i = 0; i < options.upstreamLinks; ++i) {
+        upstreams.append(nullptr);
+    }
+}
+
+bool Gateway::start()
+{
+    if (!server.listen(QHostAddress::Any, options.listenPort)) {
+        qCritical() << "Gateway: cannot listen on port" << options.listenPort << server.errorString();
+        return false;
+    }
+    connect(&server, &QWebSocketServer::newConnection, this, &Gateway::handleNewSocket);
+    for (int i = 0; i < upstreams.size(); ++i) {
+        connectUpstream(i);
+    }
+    qInfo() << "Gateway: listening for WebSocket clients on port" << options.listenPort
+            << "with" << upstreams.size() << "upstream links.";
+    return true;
+}
+
+void Gateway::connectUpstream(int index)
+{
+    QLocalSocket* localSocket = nullptr;
+    QTcpSocket* tcpSocket = nullptr;
+    MuxConnection* connection = nullptr;
+    if (options.upstreamHost.isEmpty()) {
+        localSocket = new QLocalSocket;
+        connection = new MuxConnection(localSocket, this);
+    } else {
+        tcpSocket = new QTcpSocket;
+        connection = new MuxConnection(tcpSocket, this);
+    }
+    upstreams[index] = connection;
+
+    //断开后其上的浏览器会话都会收到 disconnected()，稍后重连，新来的浏览器分到其他连接
+    auto retry = [this, index, connection]() {
+        if (upstreams.value(index) != connection) return;
+        upstreams[index] = nullptr;
+        connection->deleteLater();
+        QTimer::singleShot(RECONNECT_DELAY_MS, this, [this, index]() { connectUpstream(index); });
+    };
+    connect(connection, &MuxConnection::linkClosed, this, retry);
+
+    if (localSocket) {
+        connect(localSocket, &QLocalSocket::connected, this, [index]() {
+            qInfo() << "Gateway: upstream link" << index << "connected (local socket).";
+        });
+        connect(localSocket, &QLocalSocket::errorOccurred, this, [index, localSocket, retry]() {
+            qWarning() << "Gateway: upstream link" << index << "error:" << localSocket->errorString();
+            if (localSocket->state() == QLocalSocket::UnconnectedState) retry();
+        });
+        localSocket->connectToServer(Protocol::LOCAL_MUX_NAME);
+    } else {
+        connect(tcpSocket, &QTcpSocket::connected, this, [index]() {
+            qInfo() << "Gateway: upstream link" << index << "connected.";
+        });
+        connect(tcpSocket, &QTcpSocket::errorOccurred, this, [index, tcpSocket, retry]() {
+            qWarning() << "Gateway: upstream link" << index << "error:" << tcpSocket->errorString();
+            if (tcpSocket->state() == QAbstractSocket::UnconnectedState) retry();
+        });
+        tcpSocket->connectToHost(options.upstreamHost, options.upstreamPort ? options.upstreamPort : Protocol::MUX_PORT);
+    }
+}
+
+MuxConnection *Gateway::pickUpstream() const
+{
+    //会话数最少的已连接上游
+    MuxConnection* best = nullptr;
+    for (MuxConnection* connection : upstreams) {
+        if (!connection || !connection->link()->isOpen()) continue;
+        if (!best || connection->channelCount() < best->channelCount()) best = connection;
+    }
+    return best;
+}
+
+void Gateway::handleNewSocket()
+{
+    while (server.hasPendingConnections()) {
+        QWebSocket* socket = server.nextPendingConnection();
+        if (!socket) continue;
+
+        MuxConnection* upstream = pickUpstream();
+        if (!upstream) {
+            qWarning() << "Gateway: no upstream link available, rejecting" << socket->peerAddress().toString();
+            socket->close(QWebSocketProtocol::CloseCodeTryAgainLater, tr("server unavailable"));
+            socket->deleteLater();
+            continue;
+        }
+        MuxChannel* channel = upstream->openChannel();
+        qInfo() << "Gateway: browser" << socket->peerAddress().toString() << "mapped to session" << channel->sessionId();
+        bridge(socket, channel);
+    }
+}
+
+void Gateway::bridge(QWebSocket *socket, MuxChannel *channel)
+{
+    //通道随 WebSocket 一起销毁，销毁时通知服务器关闭会话
+    channel->setParent(socket);
+
+    connect(socket, &QWebSocket::binaryMessageReceived, channel, [socket, channel](const QByteArray& message) {
+        //长度字段必须与消息长度一致，否则后续字节流会错位
+        if (message.size() < int(sizeof(quint32)) || message.size() > MAX_CLIENT_FRAME
+            || qFromBigEndian<quint32>(message.constData()) != quint32(message.size() - sizeof(quint32))) {
+            qWarning() << "Gateway: malformed frame from browser, closing session" << channel->sessionId();
+            socket->close(QWebSocketProtocol::CloseCodeProtocolError);
+            return;
+        }
+        channel->write(message);
+    });
+    connect(socket, &QWebSocket::textMessageReceived, socket, [socket]() {
+        socket->close(QWebSocketProtocol::CloseCodeDatatypeNotSupported);
+    });
+
+    std::shared_ptr<QByteArray> pending = std::make_shared<QByteArray>();
+    connect(channel, &QIODevice::readyRead, socket, [socket, channel, pending]() {
+        //按帧切开：每个完整帧作为一条二进制消息，不完整的留到下次
+        pending->append(channel->readAll());
+        qsizetype offset = 0;
+        while (pending->size() - offset >= qsizetype(sizeof(quint32))) {
+            const qsizetype frameSize = sizeof(quint32) + qFromBigEndian<quint32>(pending->constData() + offset);
+            if (pending->size() - offset < frameSize) break;
+            socket->sendBinaryMessage(pending->mid(offset, frameSize));
+            offset += frameSize;
+        }
+        pending->remove(0, offset);
+    });
+
+    connect(channel, &MuxChannel::disconnected, socket, [socket]() {
+        socket->close(QWebSocketProtocol::CloseCodeGoingAway);
+    });
+    connect(socket, &QWebSocket::disconnected, socket, [socket, channel]() {
+        qDebug() << "Gateway: browser session" << channel->sessionId() << "closed.";
+        socket->deleteLater();
+    });
+}
@@ -0,0 +1,44 @@
+#ifndef GATEWAY_H
+#define GATEWAY_H
+
+#include <QObject>
+#include <QList>
+#include <QWebSocketServer>
+#include <controller/muxtransport.h>
+
+class QWebSocket;
+
+struct GatewayOptions
+{
+    quint16 listenPort = 8080;
+    // 为空时通过本地套接字连接同机的服务器
+    QString upstreamHost;
+    quint16 upstreamPort = 0;
+    int upstreamLinks = 2;      // 到服务器的多路复用连接数，浏览器会话分摊到这些连接上
+};
+
+// WebSocket 网关：浏览器的每条 WebSocket 连接对应服务器上的一个会话。
+// 一条二进制消息恰好是一个协议帧（[quint32 长度][类型][payload...]），原样转发；
+// 服务器发来的字节流按帧切开，每帧作为一条二进制消息发给浏览器。
+// WebSocket 握手与掩码都在这里处理，服务器只看到多路复用连接。
+class Gateway : public QObject
+{
+    Q_OBJECT
+public:
+    explicit Gateway(const GatewayOptions& options, QObject* parent = nullptr);
+    bool start();
+
+private slots:
+    void handleNewSocket();
+
+private:
+    void connectUpstream(int index);
+    MuxConnection* pickUpstream() const;
+    void bridge(QWebSocket* socket, MuxChannel* channel);
+
+    GatewayOptions options;
+    QWebSocketServer server;
+    QList<MuxConnection*> upstreams;   // 下标即连接编号，断开期间为 nullptr
+};
+
+#endif // GATEWAY_H
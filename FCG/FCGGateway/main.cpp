@@ -0,0 +1,34 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include "gateway.h"
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("FCG WebSocket gateway for browser clients");
+    parser.addHelpOption();
+    QCommandLineOption portOption("port", "WebSocket listen port.", "port", "8080");
+    QCommandLineOption upstreamOption("upstream", "FCGServer multiplexing endpoint as host[:port]. "
+                                                  "Defaults to the local socket on this machine.", "host");
+    QCommandLineOption linksOption("links", "Number of upstream connections.", "n", "2");
+    parser.addOptions({portOption, upstreamOption, linksOption});
+    parser.process(app);
+
+    GatewayOptions options;
+    options.listenPort = quint16(parser.value(portOption).toUInt());
+    options.upstreamLinks = parser.value(linksOption).toInt();
+    if (parser.isSet(upstreamOption)) {
+        const QString upstream = parser.value(upstreamOption);
+        const int colon = upstream.lastIndexOf(':');
+        options.upstreamHost = colon > 0 ? upstream.left(colon) : upstream;
+        if (colon > 0) options.upstreamPort = quint16(upstream.mid(colon + 1).toUInt());
+    }
+
+    Gateway gateway(options);
+    if (!gateway.start()) {
+        return 1;
+    }
+    return app.exec();
+}
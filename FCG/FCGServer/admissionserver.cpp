@@ -0,0 +1,47 @@
+#include "admissionserver.h"
+#include "ratelimiter.h"
+#include <QDebug>
+#include <QTcpSocket>
+#if defined(Q_OS_UNIX)
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+AdmissionServer::AdmissionServer(QObject *parent)
+    : QTcpServer(parent)
+{
+}
+
+void AdmissionServer::incomingConnection(qintptr socketDescriptor)
+{
+#if defined(Q_OS_UNIX)
+    //直接从描述符取对端地址，拒绝时只需关闭描述符
+    sockaddr_storage storage{};
+    socklen_t length = sizeof(storage);
+    QHostAddress address;
+    if (::getpeername(int(socketDescriptor), reinterpret_cast<sockaddr*>(&storage), &length) == 0) {
+        address = QHostAddress(reinterpret_cast<sockaddr*>(&storage));
+    }
+    if (!RateLimiter::shared()->admitConnection(address)) {
+        ::close(int(socketDescriptor));
+        return;
+    }
+
+    QTcpSocket* socket = new QTcpSocket(this);
+    if (!socket->setSocketDescriptor(socketDescriptor)) {
+        qWarning() << "AdmissionServer: cannot adopt descriptor" << socketDescriptor << socket->errorString();
+        RateLimiter::shared()->releaseConnection(address);
+        delete socket;
+        return;
+    }
+    //连接可能已经移到房间线程，销毁时在那个线程归还
+    connect(socket, &QObject::destroyed, [address]() {
+        RateLimiter::shared()->releaseConnection(address);
+    });
+    //newConnection() 由 QTcpServer 在本函数返回后发出
+    addPendingConnection(socket);
+#else
+    //其他平台没有取对端地址的通用办法，按默认方式接受
+    QTcpServer::incomingConnection(socketDescriptor);
+#endif
+}
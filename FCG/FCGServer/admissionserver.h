@@ -0,0 +1,19 @@
+#ifndef ADMISSIONSERVER_H
+#define ADMISSIONSERVER_H
+
+#include <QTcpServer>
+
+// 接入控制：在 QTcpServer 为新连接创建 QTcpSocket 之前，按全局接入速率和单 IP 连接数筛选，
+// 被拒绝的连接只关闭描述符，不分配任何对象，也不进入事件循环。
+// 放行的连接在 QTcpSocket 销毁时归还该 IP 的连接数
+class AdmissionServer : public QTcpServer
+{
+    Q_OBJECT
+public:
+    explicit AdmissionServer(QObject* parent = nullptr);
+
+protected:
+    void incomingConnection(qintptr socketDescriptor) override;
+};
+
+#endif // ADMISSIONSERVER_H
@@ -0,0 +1,276 @@
+#include "expectimaxsearch.h"
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QSemaphore>
+#include <QThreadPool>
+#include <array>
+#include <climits>
+#include <cstring>
+
+namespace {
+// 最多 4 架飞机 × 是否飞跃
+const int MAX_MOVES = 8;
+// 每搜索这么多个节点检查一次时间
+const int TIME_CHECK_INTERVAL = 1024;
+
+// Zobrist 键：每架飞机在每个格子上一个随机数，97 号位表示已到达终点；另加轮到谁走。
+// 估值以搜索方的视角给出，所以存表时还要混入搜索方
+struct ZobristKeys
+{
+    quint64 plane[BoardPosition::PLANE_COUNT][98];
+    quint64 player[5];
+    quint64 perspective[5];
+
+    ZobristKeys()
+    {
+        // 固定种子，保证同一局面在不同进程里得到相同的键
+        QRandomGenerator rng(0x46434721u);
+        for (auto& keys : plane) {
+            for (quint64& key : keys) key = rng.generate64();
+        }
+        for (quint64& key : player) key = rng.generate64();
+        for (quint64& key : perspective) key = rng.generate64();
+    }
+};
+
+const ZobristKeys& zobrist()
+{
+    static const ZobristKeys keys;
+    return keys;
+}
+
+quint64 packEntry(int depth, float value)
+{
+    quint32 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return (quint64(quint8(depth)) << 32) | bits;
+}
+}
+
+struct ExpectimaxSearch::Context
+{
+    int rootPlayer;
+    int budgetMs;
+    int nodeBudget;     // 大于 0 时按节点数停止
+    QElapsedTimer timer;
+    std::atomic<bool>* stop;
+    qint64 nodes = 0;
+
+    bool timeUp()
+    {
+        if (stop->load(std::memory_order_relaxed)) return true;
+        ++nodes;
+        if (nodeBudget > 0 ? nodes >= nodeBudget
+                           : nodes % TIME_CHECK_INTERVAL == 0 && timer.hasExpired(budgetMs)) {
+            stop->store(true, std::memory_order_relaxed);
+            return true;
+        }
+        return false;
+    }
+};
+
+TranspositionTable::TranspositionTable(int sizeLog2)
+    : entries(new Entry[size_t(1) << sizeLog2]), mask((quint64(1) << sizeLog2) - 1)
+{
+}
+
+bool TranspositionTable::probe(quint64 key, int depth, float &value) const
+{
+    const Entry& entry = entries[key & mask];
+    const quint64 data = entry.data.load(std::memory_order_relaxed);
+    const quint64 check = entry.check.load(std::memory_order_relaxed);
+    if ((check ^ data) != key || int(data >> 32) < depth) return false;
+
+    const quint32 bits = quint32(data);
+    std::memcpy(&value, &bits, sizeof(value));
+    return true;
+}
+
+void TranspositionTable::store(quint64 key, int depth, float value)
+{
+    Entry& entry = entries[key & mask];
+    // 同一局面只用更深的结果覆盖；不同局面直接替换
+    const quint64 oldData = entry.data.load(std::memory_order_relaxed);
+    const quint64 oldCheck = entry.check.load(std::memory_order_relaxed);
+    if ((oldCheck ^ oldData) == key && int(oldData >> 32) > depth) return;
+
+    const quint64 data = packEntry(depth, value);
+    entry.data.store(data, std::memory_order_relaxed);
+    entry.check.store(key ^ data, std::memory_order_relaxed);
+}
+
+void TranspositionTable::clear()
+{
+    for (quint64 i = 0; i <= mask; ++i) {
+        entries[i].data.store(0, std::memory_order_relaxed);
+        entries[i].check.store(0, std::memory_order_relaxed);
+    }
+}
+
+ExpectimaxSearch::ExpectimaxSearch(int tableSizeLog2)
+    : table(tableSizeLog2)
+{
+}
+
+void ExpectimaxSearch::clear()
+{
+    table.clear();
+}
+
+quint64 ExpectimaxSearch::hash(const BoardPosition &position, int playerToMove)
+{
+    const ZobristKeys& keys = zobrist();
+    quint64 h = keys.player[qBound(0, playerToMove, 4)];
+    for (int i = 0; i < BoardPosition::PLANE_COUNT; ++i) {
+        if (position.tile[i] <= 0) continue;
+        h ^= keys.plane[i][position.isFinished(i + 1) ? 97 : position.tile[i]];
+    }
+    return h;
+}
+
+BotDecision ExpectimaxSearch::chooseMove(const BoardPosition &position, int playerId, int dice,
+                                         const ExpectimaxOptions &options, QThreadPool *helperPool) const
+{
+    BotDecision decision;
+    Move moves[MAX_MOVES];
+    const int moveCount = generateMoves(position, playerId, dice, moves);
+    if (moveCount == 0) return decision;
+
+    decision.planeId = moves[0].planeId;
+    decision.fly = moves[0].fly;
+    if (moveCount == 1) return decision;
+
+    std::atomic<bool> stop{false};
+    const int maxDepth = qMax(1, options.maxDepth);
+
+    // 辅助线程从不同的着法开始搜，结果只用于填充共享置换表
+    auto runHelper = [&](int helperIndex) {
+        Context ctx{playerId, options.budgetMs, options.nodes, QElapsedTimer(), &stop};
+        ctx.timer.start();
+        float value = 0.0f;
+        for (int depth = 1; depth <= maxDepth && !stop.load(std::memory_order_relaxed); ++depth) {
+            searchRoot(ctx, dice, moves, moveCount, depth, helperIndex % moveCount, value);
+        }
+    };
+
+    QSemaphore finished;
+    int helpers = 0;
+    for (int i = 1; i < options.threads && helperPool; ++i) {
+        if (!helperPool->tryStart([&runHelper, &finished, i]() {
+                runHelper(i);
+                finished.release();
+            })) {
+            break;
+        }
+        helpers++;
+    }
+
+    Context ctx{playerId, options.budgetMs, options.nodes, QElapsedTimer(), &stop};
+    ctx.timer.start();
+    int best = 0;
+    for (int depth = 1; depth <= maxDepth; ++depth) {
+        float value = 0.0f;
+        // 上一轮的最佳着法先搜
+        const int result = searchRoot(ctx, dice, moves, moveCount, depth, best, value);
+        if (result < 0) break; // 本轮被时间打断，沿用上一轮的结果
+        best = result;
+        decision.depth = depth;
+        decision.winRate = value;
+        if (options.nodes <= 0 && ctx.timer.hasExpired(options.budgetMs)) break;
+    }
+    stop.store(true);
+    finished.acquire(helpers);
+
+    decision.planeId = moves[best].planeId;
+    decision.fly = moves[best].fly;
+    decision.work = int(qMin<qint64>(ctx.nodes, INT_MAX));
+
+    qDebug() << "ExpectimaxSearch: player" << playerId << "dice" << dice << "chose plane" << decision.planeId
+             << "fly" << decision.fly << "depth" << decision.depth << "nodes" << ctx.nodes
+             << "threads" << helpers + 1 << "elapsed" << ctx.timer.elapsed() << "ms";
+    return decision;
+}
+
+int ExpectimaxSearch::searchRoot(Context &ctx, int dice, const Move *moves, int moveCount,
+                                 int depth, int firstMove, float &bestValue) const
+{
+    int best = -1;
+    bestValue = -1.0f;
+    for (int n = 0; n < moveCount; ++n) {
+        const int i = (firstMove + n) % moveCount;
+        const float value = chanceNode(ctx, moves[i].after, nextPlayer(moves[i].after, ctx.rootPlayer, dice), depth - 1);
+        if (ctx.stop->load(std::memory_order_relaxed)) return -1;
+        if (value > bestValue) {
+            bestValue = value;
+            best = i;
+        }
+    }
+    return best;
+}
+
+float ExpectimaxSearch::chanceNode(Context &ctx, const BoardPosition &position, int player, int depth) const
+{
+    const int won = GameRules::winner(position);
+    if (won != 0) return won == ctx.rootPlayer ? 1.0f : 0.0f;
+    if (depth <= 0) return float(MonteCarloBot::evaluate(position, ctx.rootPlayer));
+    if (ctx.timeUp()) return 0.0f;
+
+    const quint64 key = hash(position, player) ^ zobrist().perspective[ctx.rootPlayer];
+    float value;
+    if (table.probe(key, depth, value)) return value;
+
+    float sum = 0.0f;
+    for (int dice = 1; dice <= 6; ++dice) {
+        sum += decisionNode(ctx, position, player, dice, depth);
+        if (ctx.stop->load(std::memory_order_relaxed)) return 0.0f;
+    }
+    value = sum / 6.0f;
+    table.store(key, depth, value);
+    return value;
+}
+
+float ExpectimaxSearch::decisionNode(Context &ctx, const BoardPosition &position, int player, int dice, int depth) const
+{
+    Move moves[MAX_MOVES];
+    const int moveCount = generateMoves(position, player, dice, moves);
+    if (moveCount == 0) {
+        return chanceNode(ctx, position, nextPlayer(position, player, dice), depth - 1);
+    }
+
+    const bool maximizing = player == ctx.rootPlayer;
+    float best = maximizing ? -1.0f : 2.0f;
+    for (int i = 0; i < moveCount; ++i) {
+        const float value = chanceNode(ctx, moves[i].after, nextPlayer(moves[i].after, player, dice), depth - 1);
+        best = maximizing ? qMax(best, value) : qMin(best, value);
+    }
+    return best;
+}
+
+int ExpectimaxSearch::generateMoves(const BoardPosition &position, int playerId, int dice, Move *moves)
+{
+    int count = 0;
+    for (int planeId = 1; planeId <= 4; ++planeId) {
+        if (!GameRules::canMove(position, playerId, dice, planeId)) continue;
+
+        Move& stay = moves[count++];
+        stay = Move{planeId, false, position};
+        if (GameRules::applyMove(stay.after, playerId, dice, planeId) == GameRules::MoveCanFly) {
+            Move& fly = moves[count++];
+            fly = Move{planeId, true, stay.after};
+            GameRules::applyFly(fly.after, playerId, planeId);
+        }
+    }
+    return count;
+}
+
+int ExpectimaxSearch::nextPlayer(const BoardPosition &position, int playerId, int dice)
+{
+    // 掷出6点继续由自己行动
+    if (dice == 6) return playerId;
+    for (int i = 1; i <= 4; ++i) {
+        const int candidate = (playerId - 1 + i) % 4 + 1;
+        if (position.isActivePlayer(candidate)) return candidate;
+    }
+    return playerId;
+}
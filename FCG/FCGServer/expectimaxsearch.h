@@ -0,0 +1,78 @@
+#ifndef EXPECTIMAXSEARCH_H
+#define EXPECTIMAXSEARCH_H
+
+#include <../FCGClient/model/gamerules.h>
+#include "montecarlobot.h"
+#include <QThread>
+#include <atomic>
+#include <memory>
+
+class QThreadPool;
+
+struct ExpectimaxOptions
+{
+    int budgetMs = 10;                              // 每步思考时间
+    int threads = QThread::idealThreadCount();      // 共享置换表的搜索线程数（含调用线程）
+    int maxDepth = 12;                              // 迭代加深的上限（以掷骰轮次计）
+    int nodes = 0;                                  // 大于 0 时任一线程搜满这么多个节点就停，不看时间
+};
+
+// 固定大小的无锁置换表。每项存 key^data 与 data 两个原子字，读出后异或校验，
+// 并发写入撕裂的项会校验失败而被当作未命中，不需要加锁。
+class TranspositionTable
+{
+public:
+    explicit TranspositionTable(int sizeLog2 = 18);
+
+    bool probe(quint64 key, int depth, float& value) const;
+    void store(quint64 key, int depth, float value);
+    void clear();
+
+private:
+    struct Entry
+    {
+        std::atomic<quint64> check{0};
+        std::atomic<quint64> data{0};
+    };
+
+    std::unique_ptr<Entry[]> entries;
+    quint64 mask;
+};
+
+// 期望极大搜索：掷骰为机会节点（六种点数取平均），轮到自己时取最大、轮到对手时取最小。
+// 迭代加深直到时间（或节点数）用完，返回最后一轮完整搜索的结果。置换表在多次搜索、多个线程间共享。
+class ExpectimaxSearch
+{
+public:
+    explicit ExpectimaxSearch(int tableSizeLog2 = 18);
+
+    // 可在多个线程里同时调用；helperPool 非空时借用空闲线程做并行搜索（lazy SMP）
+    BotDecision chooseMove(const BoardPosition& position, int playerId, int dice,
+                           const ExpectimaxOptions& options = ExpectimaxOptions(),
+                           QThreadPool* helperPool = nullptr) const;
+
+    static quint64 hash(const BoardPosition& position, int playerToMove);
+    //清空置换表，调用时不能有搜索在进行
+    void clear();
+
+private:
+    struct Move
+    {
+        int planeId;
+        bool fly;
+        BoardPosition after;
+    };
+    struct Context;
+
+    static int generateMoves(const BoardPosition& position, int playerId, int dice, Move* moves);
+    static int nextPlayer(const BoardPosition& position, int playerId, int dice);
+    float chanceNode(Context& ctx, const BoardPosition& position, int player, int depth) const;
+    float decisionNode(Context& ctx, const BoardPosition& position, int player, int dice, int depth) const;
+    // 返回最佳着法下标；被时间打断时返回 -1
+    int searchRoot(Context& ctx, int dice, const Move* moves, int moveCount,
+                   int depth, int firstMove, float& bestValue) const;
+
+    mutable TranspositionTable table;
+};
+
+#endif // EXPECTIMAXSEARCH_H
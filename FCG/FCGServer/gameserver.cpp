@@ -1,71 +1,917 @@
-#include "gameserver.h"
-#include <QApplication>
-#include <QHostAddress>
-#include <QTcpSocket>
-#include <QMessageBox>
-
-const quint16 PORT = 12345;
-
-GameServer::GameServer(QWidget *parentWidget, QObject *parent)
-    : QObject(parent), m_parentWidget(parentWidget)
-{
-    tcpServer = new QTcpServer(this);
-    serverController = new ServerController(this);
-}
-
-void GameServer::startServer()
-{
-    // 使用输入对话框获取玩家数量
-    bool ok;
-    int players = QInputDialog::getInt(m_parentWidget,
-                                       tr("游戏设置"),
-                                       tr("请输入玩家数量（1-4）:"),
-                                       2,  // 默认值
-                                       1,  // 最小值
-                                       4,  // 最大值
-                                       1,  // 步进
-                                       &ok);
-
-    if (!ok) {
-        QMessageBox::information(m_parentWidget,
-                                 tr("取消操作"),
-                                 tr("用户取消了服务器启动"));
-        return;
-    }
-
-    desiredPlayers = players;
-    serverController->setDesiredPlayers(desiredPlayers);
-
-    if (!tcpServer->listen(QHostAddress::Any, PORT)) {
-        QMessageBox::critical(m_parentWidget,
-                              tr("服务器错误"),
-                              tr("无法启动服务器:\n%1").arg(tcpServer->errorString()));
-        QCoreApplication::exit(EXIT_FAILURE);
-        return;
-    }
-
-    connect(tcpServer, &QTcpServer::newConnection, this, &GameServer::handleNewConnection);
-    qInfo() << "服务器已在端口" << PORT << "启动，等待" << desiredPlayers << "位玩家连接...";
-    QMessageBox::information(m_parentWidget,
-                             tr("服务器已启动"),
-                             tr("正在监听端口 %1\n等待%2位玩家连接...").arg(PORT).arg(desiredPlayers));
-}
-
-void GameServer::handleNewConnection()
-{
-    while (tcpServer->hasPendingConnections()) {
-        QTcpSocket *clientSocket = tcpServer->nextPendingConnection();
-        if (!clientSocket) {
-            continue;
-        }
-
-        qInfo() << "GameServer: 客户端" << clientIdCounter << "尝试连接:"
-                << clientSocket->peerAddress().toString() << "描述符:" << clientSocket->socketDescriptor();
-
-        // Pass the QTcpSocket pointer directly
-        serverController->addClient(clientSocket, clientIdCounter);
-        clientIdCounter++;
-    }
-}
-
-
+#include "gameserver.h"
+#include <QApplication>
+#include <QHostAddress>
+#include <QTcpSocket>
+#include <QLocalSocket>
+#include <QMessageBox>
+#include <QDataStream>
+#include <QTimer>
+#include <functional>
+#include "handoff.h"
+#if defined(Q_OS_UNIX)
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <unistd.h>
+#endif
+
+const quint16 PORT = 12345;
+// 连接先在大厅等第一条消息（MATCH_MSG、ROOM_MSG，旧版客户端是别的游戏消息）才入座；
+// 一直不发消息的连接（例如连接对话框里的预连接）不占座位，等待这么久后断开
+const int LOBBY_TIMEOUT_MS = 60000;
+// 排队超过这个时间仍未凑满，空位由 AI 补齐
+const int BACKFILL_DELAY_MS = 15000;
+// 凭房间号回来、但没有有效座位凭据的连接按旁观者接入，编号从这里开始，避开座位号 1~4
+const int REJOIN_CLIENT_ID_BASE = 1000;
+// 一条多路复用连接（通常来自网关）上同时打开的会话数上限
+const int MAX_SESSIONS_PER_LINK = 512;
+// ROOM_MSG 只带房间号与座位凭据，超过这个长度按异常连接处理
+const quint32 MAX_ROOM_MSG_BYTES = 4096;
+// 交接消息格式的版本，新旧进程不一致时新进程放弃接管、正常启动
+const qint32 HANDOFF_VERSION = 2;
+
+namespace {
+//TCP、本地套接字与多路复用会话的断开信号各不相同
+void onDisconnected(QIODevice* socket, QObject* context, const std::function<void()>& handler)
+{
+    if (QTcpSocket* tcpSocket = qobject_cast<QTcpSocket*>(socket)) {
+        QObject::connect(tcpSocket, &QTcpSocket::disconnected, context, handler);
+    } else if (QLocalSocket* localSocket = qobject_cast<QLocalSocket*>(socket)) {
+        QObject::connect(localSocket, &QLocalSocket::disconnected, context, handler);
+    } else if (MuxChannel* channel = qobject_cast<MuxChannel*>(socket)) {
+        QObject::connect(channel, &MuxChannel::disconnected, context, handler);
+    }
+}
+
+void closeDevice(QIODevice* socket)
+{
+    if (QTcpSocket* tcpSocket = qobject_cast<QTcpSocket*>(socket)) {
+        tcpSocket->disconnectFromHost();
+    } else if (QLocalSocket* localSocket = qobject_cast<QLocalSocket*>(socket)) {
+        localSocket->disconnectFromServer();
+    } else {
+        socket->close();
+    }
+}
+}
+
+GameServer::GameServer(QWidget *parentWidget, QObject *parent)
+    : QObject(parent), m_parentWidget(parentWidget)
+{
+    //游戏端口与多路复用端口都先过接入控制
+    tcpServer = new AdmissionServer(this);
+    localServer = new QLocalServer(this);
+    muxServer = new AdmissionServer(this);
+    localMuxServer = new QLocalServer(this);
+    forwardServer = new QLocalServer(this);
+    handoffServer = new QLocalServer(this);
+    //交接入口能拿走所有连接，只允许同一用户访问
+    handoffServer->setSocketOptions(QLocalServer::UserAccessOption);
+    serverController = new ServerController(this);
+    instanceEndpoint = QString("fcg-server-%1").arg(QCoreApplication::applicationPid());
+}
+
+GameServer::~GameServer()
+{
+    if (registry) {
+        registry->unregisterEndpoint(instanceEndpoint);
+        delete registry;
+    }
+    matcherThread.quit();
+    matcherThread.wait();
+    delete matchmaker;
+    for (QThread* thread : std::as_const(roomThreads)) {
+        thread->quit();
+        thread->wait();
+        delete thread;
+    }
+}
+
+void GameServer::setReusePort(bool enabled)
+{
+    reusePort = enabled;
+    if (reusePort && !registry) {
+        registry = new RoomRegistry;
+    }
+}
+
+void GameServer::startServer()
+{
+    bool ok;
+    const QStringList modes{tr("单桌"), tr("自动匹配")};
+    const QString mode = QInputDialog::getItem(m_parentWidget,
+                                               tr("游戏设置"),
+                                               tr("服务器模式:"),
+                                               modes,
+                                               0,
+                                               false,
+                                               &ok);
+    if (ok && mode == modes.at(1)) {
+        const int tableSize = QInputDialog::getInt(m_parentWidget,
+                                                   tr("游戏设置"),
+                                                   tr("玩家未指定时的每桌人数（2-4）:"),
+                                                   4,
+                                                   Matchmaker::MIN_TABLE_SIZE,
+                                                   Matchmaker::MAX_TABLE_SIZE,
+                                                   1,
+                                                   &ok);
+        if (ok) {
+            startMatchmaking(tableSize);
+            return;
+        }
+    }
+
+    // 使用输入对话框获取玩家数量
+    int players = QInputDialog::getInt(m_parentWidget,
+                                       tr("游戏设置"),
+                                       tr("请输入玩家数量（1-4）:"),
+                                       2,  // 默认值
+                                       1,  // 最小值
+                                       4,  // 最大值
+                                       1,  // 步进
+                                       &ok);
+
+    if (!ok) {
+        QMessageBox::information(m_parentWidget,
+                                 tr("取消操作"),
+                                 tr("用户取消了服务器启动"));
+        return;
+    }
+
+    // 空座位可以交给 AI，至少留一个座位给真人玩家
+    int bots = 0;
+    if (players > 1) {
+        bots = QInputDialog::getInt(m_parentWidget,
+                                    tr("游戏设置"),
+                                    tr("其中 AI 玩家数量（0-%1）:").arg(players - 1),
+                                    0,
+                                    0,
+                                    players - 1,
+                                    1,
+                                    &ok);
+        if (!ok) bots = 0;
+    }
+
+    desiredPlayers = players;
+    serverController->setDesiredPlayers(desiredPlayers);
+    for (int i = 0; i < bots; ++i) {
+        serverController->addBot();
+    }
+
+    if (!listenTcp(tcpServer, PORT)) {
+        QMessageBox::critical(m_parentWidget,
+                              tr("服务器错误"),
+                              tr("无法启动服务器:\n%1").arg(tcpServer->errorString()));
+        QCoreApplication::exit(EXIT_FAILURE);
+        return;
+    }
+
+    connect(tcpServer, &QTcpServer::newConnection, this, &GameServer::handleNewConnection);
+    listenLocal();
+    listenMux();
+    listenHandoff();
+    qInfo() << "服务器已在端口" << PORT << "启动，等待" << desiredPlayers - bots << "位玩家连接...";
+    QMessageBox::information(m_parentWidget,
+                             tr("服务器已启动"),
+                             tr("正在监听端口 %1\n等待%2位玩家连接...").arg(PORT).arg(desiredPlayers - bots));
+}
+
+void GameServer::handleNewConnection()
+{
+    while (tcpServer->hasPendingConnections()) {
+        QTcpSocket *clientSocket = tcpServer->nextPendingConnection();
+        if (!clientSocket) {
+            continue;
+        }
+
+        qInfo() << "GameServer: 会话" << sessionCounter << "尝试连接:"
+                << clientSocket->peerAddress().toString() << "描述符:" << clientSocket->socketDescriptor();
+
+        acceptClient(clientSocket);
+    }
+}
+
+void GameServer::handleNewLocalConnection()
+{
+    while (localServer->hasPendingConnections()) {
+        QLocalSocket *clientSocket = localServer->nextPendingConnection();
+        if (!clientSocket) {
+            continue;
+        }
+        qInfo() << "GameServer: 会话" << sessionCounter << "通过本地套接字连接";
+        acceptClient(clientSocket);
+    }
+}
+
+void GameServer::acceptClient(QIODevice *clientSocket)
+{
+    if (handedOff) {
+        clientSocket->close();
+        clientSocket->deleteLater();
+        return;
+    }
+    //单桌模式同样先进大厅，收到第一条消息再入座
+    acceptSession(clientSocket);
+}
+
+bool GameServer::listenTcp(QTcpServer *server, quint16 port)
+{
+    if (!reusePort) {
+        return server->listen(QHostAddress::Any, port);
+    }
+#if defined(Q_OS_UNIX) && defined(SO_REUSEPORT)
+    //QTcpServer 不能设置 SO_REUSEPORT，自己建好监听套接字再交给它；
+    //同一端口上的每个进程各有一个接受队列，新连接由内核散列分配
+    const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        qWarning() << "GameServer: socket() failed for port" << port;
+        return false;
+    }
+    const int on = 1;
+    ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    if (::setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) < 0) {
+        qWarning() << "GameServer: SO_REUSEPORT not supported for port" << port;
+        ::close(fd);
+        return false;
+    }
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(port);
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 || ::listen(fd, SOMAXCONN) < 0) {
+        qWarning() << "GameServer: cannot bind shared port" << port;
+        ::close(fd);
+        return false;
+    }
+    if (!server->setSocketDescriptor(fd)) {
+        ::close(fd);
+        return false;
+    }
+    qInfo() << "GameServer: 端口" << port << "以 SO_REUSEPORT 共享监听";
+    return true;
+#else
+    qWarning() << "GameServer: 本平台不支持 SO_REUSEPORT，按独占方式监听端口" << port;
+    return server->listen(QHostAddress::Any, port);
+#endif
+}
+
+bool GameServer::listenLocalName(QLocalServer *server, const QString &name)
+{
+    //上次异常退出可能留下同名的套接字文件；多进程时它也可能属于仍在运行的兄弟进程，先试连一下
+    QLocalSocket probe;
+    probe.connectToServer(name);
+    if (probe.waitForConnected(100)) {
+        probe.abort();
+        qInfo() << "GameServer: 本地套接字" << name << "已由其他服务器进程监听";
+        return false;
+    }
+    QLocalServer::removeServer(name);
+    if (!server->listen(name)) {
+        qWarning() << "GameServer: 无法监听本地套接字" << name << server->errorString();
+        return false;
+    }
+    return true;
+}
+
+void GameServer::listenLocal()
+{
+    if (!listenLocalName(localServer, Protocol::LOCAL_SERVER_NAME)) return;
+    connect(localServer, &QLocalServer::newConnection, this, &GameServer::handleNewLocalConnection);
+    qInfo() << "GameServer: 本地套接字" << localServer->fullServerName() << "已启动";
+}
+
+void GameServer::listenMux()
+{
+    //接管旧进程时监听套接字已经就绪
+    if (muxServer->isListening() || listenTcp(muxServer, Protocol::MUX_PORT)) {
+        connect(muxServer, &QTcpServer::newConnection, this, &GameServer::handleNewMuxLink);
+        qInfo() << "GameServer: 多路复用端口" << Protocol::MUX_PORT << "已启动";
+    } else {
+        qWarning() << "GameServer: 无法监听多路复用端口" << Protocol::MUX_PORT << muxServer->errorString();
+    }
+
+    if (listenLocalName(localMuxServer, Protocol::LOCAL_MUX_NAME)) {
+        connect(localMuxServer, &QLocalServer::newConnection, this, &GameServer::handleNewMuxLink);
+        qInfo() << "GameServer: 多路复用本地套接字" << localMuxServer->fullServerName() << "已启动";
+    }
+}
+
+void GameServer::listenForward()
+{
+    if (!reusePort) return;
+    QLocalServer::removeServer(instanceEndpoint);
+    if (!forwardServer->listen(instanceEndpoint)) {
+        qWarning() << "GameServer: 无法监听转发入口" << instanceEndpoint << forwardServer->errorString();
+        return;
+    }
+    connect(forwardServer, &QLocalServer::newConnection, this, &GameServer::handleForwardedConnection);
+    qInfo() << "GameServer: 转发入口" << forwardServer->fullServerName() << "已启动";
+}
+
+void GameServer::handleForwardedConnection()
+{
+    //转来的连接开头是原样重发的 ROOM_MSG，照常进入大厅即可找到房间
+    while (forwardServer->hasPendingConnections()) {
+        if (QLocalSocket* socket = forwardServer->nextPendingConnection()) {
+            qInfo() << "GameServer: 收到其他服务器进程转来的连接";
+            acceptClient(socket);
+        }
+    }
+}
+
+void GameServer::handleNewMuxLink()
+{
+    while (muxServer->hasPendingConnections()) {
+        if (QTcpSocket* link = muxServer->nextPendingConnection()) addMuxLink(link);
+    }
+    while (localMuxServer->hasPendingConnections()) {
+        if (QLocalSocket* link = localMuxServer->nextPendingConnection()) addMuxLink(link);
+    }
+}
+
+void GameServer::addMuxLink(QIODevice *link)
+{
+    //每个会话像一条普通连接一样入座或进入匹配大厅，ClientHandler 看到的仍是完整的字节流
+    MuxConnection* connection = new MuxConnection(link, this);
+    connection->setChannelLimit(MAX_SESSIONS_PER_LINK);
+    //会话的消息配额计入底层连接的对端 IP；本地套接字没有地址，不计
+    QHostAddress address;
+    if (QTcpSocket* tcpLink = qobject_cast<QTcpSocket*>(link)) address = tcpLink->peerAddress();
+    connect(connection, &MuxConnection::channelOpened, this, [this, address](MuxChannel* channel) {
+        if (!address.isNull()) {
+            channel->setProperty(ClientHandler::PEER_ADDRESS_PROPERTY, QVariant::fromValue(address));
+        }
+        qInfo() << "GameServer: 会话" << sessionCounter << "通过多路复用会话" << channel->sessionId() << "连接";
+        acceptClient(channel);
+    });
+    connect(connection, &MuxConnection::linkClosed, connection, &QObject::deleteLater);
+    qInfo() << "GameServer: 新的多路复用连接";
+}
+
+void GameServer::startMatchmaking(int defaultTableSize)
+{
+    initMatchmaking(defaultTableSize);
+    const int workers = roomThreads.size();
+
+    if (!listenTcp(tcpServer, PORT)) {
+        QMessageBox::critical(m_parentWidget,
+                              tr("服务器错误"),
+                              tr("无法启动服务器:\n%1").arg(tcpServer->errorString()));
+        QCoreApplication::exit(EXIT_FAILURE);
+        return;
+    }
+    connect(tcpServer, &QTcpServer::newConnection, this, &GameServer::handleNewConnection);
+    listenLocal();
+    listenMux();
+    listenForward();
+    listenHandoff();
+    qInfo() << "匹配服务器已在端口" << PORT << "启动，房间线程数:" << workers << "默认每桌人数:" << defaultTableSize;
+    QMessageBox::information(m_parentWidget,
+                             tr("服务器已启动"),
+                             tr("正在监听端口 %1\n自动匹配模式，默认每桌%2人").arg(PORT).arg(defaultTableSize));
+}
+
+void GameServer::initMatchmaking(int defaultTableSize)
+{
+    matchmaking = true;
+    desiredPlayers = defaultTableSize;
+
+    matchmaker = new Matchmaker(BACKFILL_DELAY_MS);
+    matchmaker->moveToThread(&matcherThread);
+    connect(&matcherThread, &QThread::started, matchmaker, &Matchmaker::start);
+    connect(matchmaker, &Matchmaker::matchFormed, this, &GameServer::startRoom);
+    matcherThread.setObjectName("matcher");
+    matcherThread.start();
+
+    //房间按轮转分配到固定数量的工作线程，每个线程可以承载很多房间
+    const int workers = qMax(1, QThread::idealThreadCount());
+    for (int i = 0; i < workers; ++i) {
+        QThread* thread = new QThread;
+        thread->setObjectName(QString("room-%1").arg(i));
+        thread->start();
+        roomThreads.append(thread);
+    }
+}
+
+void GameServer::acceptSession(QIODevice *socket)
+{
+    const int sessionId = sessionCounter++;
+    lobby.insert(sessionId, socket);
+
+    connect(socket, &QIODevice::readyRead, this, [this, sessionId]() { readMatchRequest(sessionId); });
+    onDisconnected(socket, this, [this, sessionId]() { dropSession(sessionId); });
+    QTimer::singleShot(LOBBY_TIMEOUT_MS, this, [this, sessionId]() {
+        QIODevice* socket = lobby.value(sessionId);
+        if (socket && !queuedSessions.contains(sessionId)) {
+            qDebug() << "GameServer: session" << sessionId << "sent nothing, closing it.";
+            closeDevice(socket);
+        }
+    });
+}
+
+void GameServer::readMatchRequest(int sessionId)
+{
+    QIODevice* socket = lobby.value(sessionId);
+    if (!socket) return;
+
+    QDataStream in(socket);
+    in.setVersion(Protocol::STREAM_VERSION);
+    in.startTransaction();
+    quint32 length = 0;
+    QString messageType;
+    in >> length >> messageType;
+    //大厅里也回应心跳：匹配请求之前或排队期间的 PING 不能被当成“没有匹配请求”，往返时延也照常更新
+    while (messageType == "PING_MSG" || messageType == "PONG_MSG") {
+        QVariant payload;
+        in >> payload;
+        if (!in.commitTransaction()) return;
+        if (messageType == "PING_MSG") socket->write(Protocol::encodeFrame("PONG_MSG", payload));
+        in.startTransaction();
+        messageType.clear();
+        in >> length >> messageType;
+    }
+    if (queuedSessions.contains(sessionId)) {
+        //已经在排队，其余消息留给入座后的 ClientHandler
+        in.rollbackTransaction();
+        return;
+    }
+    if (messageType == "ROOM_MSG") {
+        //座位凭据是可选的第二个参数，整帧读出后再解析，才知道它在不在
+        in.rollbackTransaction();
+        in.startTransaction();
+        in >> length;
+        if (length > MAX_ROOM_MSG_BYTES) {
+            qWarning() << "GameServer: session" << sessionId << "sent an oversized ROOM_MSG, closing it.";
+            in.abortTransaction();
+            closeDevice(socket);
+            return;
+        }
+        QByteArray body(int(length), Qt::Uninitialized);
+        if (in.readRawData(body.data(), body.size()) != body.size()) {
+            in.rollbackTransaction();
+            return;
+        }
+        in.commitTransaction();
+        QDataStream frame(body);
+        frame.setVersion(Protocol::STREAM_VERSION);
+        QVariant roomId, seatToken;
+        frame >> messageType >> roomId;
+        if (!frame.atEnd()) frame >> seatToken;
+        joinRoom(sessionId, roomId.toString(), seatToken.toString());
+        return;
+    }
+    if (messageType != "MATCH_MSG") {
+        if (in.status() == QDataStream::ReadPastEnd) {
+            in.rollbackTransaction();
+            return;
+        }
+        //不是匹配请求（例如旧版客户端的 READY_MSG），留给入座后的 ClientHandler 处理
+        in.rollbackTransaction();
+        admitSession(sessionId, desiredPlayers);
+        return;
+    }
+    QVariant tableSize;
+    in >> tableSize;
+    if (!in.commitTransaction()) return;
+
+    const int requested = tableSize.toInt();
+    admitSession(sessionId, requested == 0 ? desiredPlayers : requested);
+}
+
+void GameServer::admitSession(int sessionId, int tableSize)
+{
+    if (matchmaking) {
+        queueSession(sessionId, tableSize);
+        return;
+    }
+    //单桌模式没有匹配器，直接入座；请求的人数以服务器设置为准
+    QIODevice* socket = lobby.take(sessionId);
+    if (!socket) return;
+    disconnect(socket, nullptr, this, nullptr);
+    serverController->addClient(socket, clientIdCounter);
+    clientIdCounter++;
+}
+
+void GameServer::queueSession(int sessionId, int tableSize)
+{
+    queuedSessions.insert(sessionId, tableSize);
+    matchmaker->enqueue(sessionId, tableSize);
+}
+
+void GameServer::dropSession(int sessionId)
+{
+    QIODevice* socket = lobby.take(sessionId);
+    if (!socket) return;
+    if (queuedSessions.remove(sessionId)) {
+        matchmaker->cancel(sessionId);
+    }
+    socket->deleteLater();
+}
+
+void GameServer::joinRoom(int sessionId, const QString &roomId, const QString &seatToken)
+{
+    if (!matchmaking) {
+        //单桌模式只有一个房间；凭据无效时与新连接一样按顺序分配座位号
+        QIODevice* socket = lobby.take(sessionId);
+        disconnect(socket, nullptr, this, nullptr);
+        serverController->rejoinClient(socket, seatToken, clientIdCounter);
+        clientIdCounter++;
+        return;
+    }
+
+    const Room room = rooms.value(roomId);
+    if (room.controller) {
+        //房间在本进程：凭据有效时回到原座位，否则当作旁观者接入，游戏进行中都会立即收到完整局面。
+        //房间可能已经清空、还没从表里移除，这时由房间关闭连接；销毁请求排在这次调用之后，不会丢下连接
+        QIODevice* socket = lobby.take(sessionId);
+        disconnect(socket, nullptr, this, nullptr);
+        socket->setParent(nullptr);
+        socket->moveToThread(room.thread);
+        ServerController* controller = room.controller;
+        const int fallbackId = REJOIN_CLIENT_ID_BASE + sessionId;
+        QMetaObject::invokeMethod(controller, [controller, socket, seatToken, fallbackId]() {
+            controller->rejoinClient(socket, seatToken, fallbackId);
+        }, Qt::QueuedConnection);
+        qInfo() << "GameServer: session" << sessionId << "rejoined room" << roomId;
+        return;
+    }
+
+    const QString owner = registry ? registry->ownerOf(roomId) : QString();
+    if (!owner.isEmpty() && owner != instanceEndpoint) {
+        forwardSession(sessionId, owner, roomId, seatToken);
+        return;
+    }
+
+    qDebug() << "GameServer: room" << roomId << "is gone, session" << sessionId << "admitted with default table size.";
+    admitSession(sessionId, desiredPlayers);
+}
+
+void GameServer::forwardSession(int sessionId, const QString &endpoint, const QString &roomId,
+                                const QString &seatToken)
+{
+    //连接已由内核交给本进程，无法迁走；改为在本地套接字上转发字节流，房间所在进程看到的是一条普通连接
+    QIODevice* socket = lobby.value(sessionId);
+    queuedSessions.insert(sessionId, 0);  // 转发期间不再解析、也不会超时排队
+
+    QLocalSocket* upstream = new QLocalSocket(this);
+    connect(upstream, &QLocalSocket::connected, this, [this, sessionId, socket, upstream, roomId, seatToken]() {
+        lobby.remove(sessionId);
+        queuedSessions.remove(sessionId);
+        disconnect(socket, nullptr, this, nullptr);
+
+        //ROOM_MSG 已在这里读掉，重新发一份让对方进程的大厅认出房间
+        upstream->write(Protocol::encodeFrame("ROOM_MSG", roomId,
+                                              seatToken.isEmpty() ? QVariant() : QVariant(seatToken)));
+        upstream->write(socket->readAll());
+        connect(socket, &QIODevice::readyRead, upstream, [socket, upstream]() {
+            upstream->write(socket->readAll());
+        });
+        connect(upstream, &QIODevice::readyRead, socket, [socket, upstream]() {
+            socket->write(upstream->readAll());
+        });
+        onDisconnected(socket, upstream, [upstream]() { upstream->disconnectFromServer(); });
+        connect(upstream, &QLocalSocket::disconnected, this, [socket, upstream]() {
+            closeDevice(socket);
+            socket->deleteLater();
+            upstream->deleteLater();
+        });
+        qInfo() << "GameServer: session" << sessionId << "forwarded to" << endpoint << "for room" << roomId;
+    });
+    connect(upstream, &QLocalSocket::errorOccurred, this, [this, sessionId, upstream, endpoint](QLocalSocket::LocalSocketError) {
+        if (!lobby.contains(sessionId) || upstream->state() == QLocalSocket::ConnectedState) return;
+        //对方进程已经退出但没来得及清理登记表
+        qWarning() << "GameServer: forward endpoint" << endpoint << "unreachable:" << upstream->errorString();
+        registry->unregisterEndpoint(endpoint);
+        upstream->deleteLater();
+        queuedSessions.remove(sessionId);
+        admitSession(sessionId, desiredPlayers);
+    });
+    upstream->connectToServer(endpoint);
+}
+
+void GameServer::startRoom(const MatchGroup &group)
+{
+    if (handedOff) return;  // 这些连接已经随大厅交给新进程
+    QThread* thread = roomThreads.at(nextRoomThread++ % roomThreads.size());
+
+    //连接在匹配期间可能已经断开，空出的座位同样由 AI 补齐
+    QList<QIODevice*> seats;
+    for (int sessionId : group.sessionIds) {
+        QIODevice* socket = lobby.take(sessionId);
+        queuedSessions.remove(sessionId);
+        if (!socket) continue;
+        disconnect(socket, nullptr, this, nullptr);
+        //只有无父对象才能换线程，入座后由 ClientHandler 接管
+        socket->setParent(nullptr);
+        socket->moveToThread(thread);
+        seats.append(socket);
+    }
+    if (seats.isEmpty()) return;
+
+    const QString roomId = QString("%1-%2").arg(QCoreApplication::applicationPid()).arg(++roomCounter);
+    ServerController* room = createRoom(thread, roomId);
+
+    const int tableSize = group.tableSize;
+    QMetaObject::invokeMethod(room, [room, seats, tableSize]() {
+        room->setDesiredPlayers(tableSize);
+        int seat = 1;
+        for (QIODevice* socket : seats) {
+            room->addClient(socket, seat++);
+        }
+        while (room->addBot() != -1) {}
+    }, Qt::QueuedConnection);
+
+    qInfo() << "GameServer: room" << roomId << "for" << tableSize << "players started on" << thread->objectName()
+            << "with" << seats.size() << "players and" << tableSize - seats.size() << "AI seats.";
+}
+
+ServerController *GameServer::createRoom(QThread *thread, const QString &roomId)
+{
+    ServerController* room = new ServerController;
+    room->setRoomId(roomId);
+    room->setCloseWhenEmpty(true);
+    room->moveToThread(thread);
+    //先移出房间表，之后主线程不会再把连接交给它；此前排队的重连由已关闭的房间自行断开，再在房间线程中销毁
+    connect(room, &ServerController::roomEmpty, this, [this, room, roomId]() {
+        rooms.remove(roomId);
+        if (registry) registry->unregisterRoom(roomId);
+        room->deleteLater();
+    });
+    rooms.insert(roomId, Room{room, thread});
+    if (registry) registry->registerRoom(roomId, instanceEndpoint);
+    return room;
+}
+
+void GameServer::listenHandoff()
+{
+    if (!listenLocalName(handoffServer, Handoff::SERVER_NAME)) return;
+    connect(handoffServer, &QLocalServer::newConnection, this, &GameServer::handleHandoffRequest);
+    qInfo() << "GameServer: 交接入口" << handoffServer->fullServerName() << "已启动";
+}
+
+void GameServer::handleHandoffRequest()
+{
+    QLocalSocket* peer = handoffServer->nextPendingConnection();
+    if (!peer || handedOff) return;
+
+    const int channel = int(peer->socketDescriptor());
+    if (!Handoff::peerIsSameUser(channel)) {
+        qWarning() << "GameServer: 交接请求来自其他用户的进程，已拒绝";
+        peer->abort();
+        peer->deleteLater();
+        return;
+    }
+    //新进程先报上交接格式的版本，不一致时本进程照常运行
+    QByteArray hello;
+    QList<int> unused;
+    qint32 version = 0;
+    if (Handoff::receiveMessage(channel, &hello, &unused)) {
+        QDataStream in(hello);
+        in.setVersion(Protocol::STREAM_VERSION);
+        in >> version;
+    }
+    for (int fd : std::as_const(unused)) Handoff::closeDescriptor(fd);
+    if (version != HANDOFF_VERSION) {
+        qWarning() << "GameServer: 交接请求版本" << version << "与本进程" << HANDOFF_VERSION << "不一致，已拒绝";
+        peer->abort();
+        peer->deleteLater();
+        return;
+    }
+
+    handoffServer->close();
+    if (handOff(peer)) {
+        qInfo() << "GameServer: 交接完成，本进程退出";
+        QCoreApplication::quit();
+    }
+    peer->deleteLater();
+}
+
+bool GameServer::handOff(QLocalSocket *peer)
+{
+    qInfo() << "GameServer: 新进程请求接管，开始交接";
+    handedOff = true;
+    //停止接受新连接；监听套接字交出后，内核中排队的连接由新进程继续接受
+    tcpServer->pauseAccepting();
+    muxServer->pauseAccepting();
+    //本地套接字名由新进程重新监听，其间本机的新连接会短暂被拒绝
+    localServer->close();
+    localMuxServer->close();
+    forwardServer->close();
+    if (matchmaker) disconnect(matchmaker, nullptr, this, nullptr);
+
+    //第一条消息：服务器设置、监听套接字与大厅中的连接
+    QList<int> descriptors;
+    const bool hasGame = tcpServer->isListening();
+    const bool hasMux = muxServer->isListening();
+    if (hasGame) descriptors.append(Handoff::duplicate(tcpServer->socketDescriptor()));
+    if (hasMux) descriptors.append(Handoff::duplicate(muxServer->socketDescriptor()));
+    QList<qint32> lobbyKinds;
+    QList<qint32> lobbySizes;
+    QList<QIODevice*> lobbySockets;
+    for (auto it = lobby.constBegin(); it != lobby.constEnd(); ++it) {
+        if (descriptors.size() >= Handoff::MAX_DESCRIPTORS) break;
+        if (queuedSessions.contains(it.key()) && queuedSessions.value(it.key()) == 0) continue; // 正在转发
+        Handoff::SocketKind kind = Handoff::TcpSocket;
+        const int fd = Handoff::duplicate(it.value(), &kind);
+        if (fd < 0) continue;
+        descriptors.append(fd);
+        lobbyKinds.append(kind);
+        lobbySizes.append(queuedSessions.value(it.key(), 0));
+        lobbySockets.append(it.value());
+    }
+
+    QList<QPair<QString, ServerController*>> exported;
+    if (matchmaking) {
+        for (auto it = rooms.constBegin(); it != rooms.constEnd(); ++it) {
+            exported.append(qMakePair(it.key(), it.value().controller));
+        }
+    } else {
+        exported.append(qMakePair(QString(), serverController));
+    }
+
+    QByteArray header;
+    QDataStream out(&header, QIODevice::WriteOnly);
+    out.setVersion(Protocol::STREAM_VERSION);
+    out << HANDOFF_VERSION << matchmaking << reusePort << qint32(desiredPlayers) << qint32(clientIdCounter)
+        << qint32(roomCounter) << hasGame << hasMux << lobbyKinds << lobbySizes << qint32(exported.size());
+    const int channel = int(peer->socketDescriptor());
+    const bool sent = !descriptors.contains(-1) && Handoff::sendMessage(channel, header, descriptors);
+    for (int fd : std::as_const(descriptors)) Handoff::closeDescriptor(fd);
+    if (!sent) {
+        //房间还没动，恢复监听继续运行
+        qWarning() << "GameServer: 交接失败，继续运行";
+        handedOff = false;
+        tcpServer->resumeAccepting();
+        muxServer->resumeAccepting();
+        listenLocalName(localServer, Protocol::LOCAL_SERVER_NAME);
+        listenLocalName(localMuxServer, Protocol::LOCAL_MUX_NAME);
+        if (reusePort) forwardServer->listen(instanceEndpoint);
+        listenLocalName(handoffServer, Handoff::SERVER_NAME);
+        if (matchmaker) connect(matchmaker, &Matchmaker::matchFormed, this, &GameServer::startRoom);
+        return false;
+    }
+    //已交出的连接立即关闭，避免本进程在退出前又从中读走数据
+    for (QIODevice* socket : std::as_const(lobbySockets)) {
+        disconnect(socket, nullptr, this, nullptr);
+        delete socket;
+    }
+
+    //之后每个房间一条消息，在房间所在线程导出
+    int handedRooms = 0;
+    for (const auto& entry : std::as_const(exported)) {
+        ServerController* controller = entry.second;
+        QList<int> fds;
+        QList<int> kinds;
+        QByteArray state;
+        auto exportRoom = [controller, &fds, &kinds, &state]() { state = controller->exportRoom(&fds, &kinds); };
+        if (controller->thread() == QThread::currentThread()) {
+            exportRoom();
+        } else {
+            QMetaObject::invokeMethod(controller, exportRoom, Qt::BlockingQueuedConnection);
+        }
+
+        QByteArray message;
+        QDataStream roomOut(&message, QIODevice::WriteOnly);
+        roomOut.setVersion(Protocol::STREAM_VERSION);
+        roomOut << entry.first << kinds << state;
+        const bool ok = Handoff::sendMessage(channel, message, fds);
+        for (int fd : std::as_const(fds)) Handoff::closeDescriptor(fd);
+        if (!ok) {
+            qCritical() << "GameServer: room" << entry.first << "could not be handed off, its players are lost.";
+            continue;
+        }
+        handedRooms++;
+    }
+    qInfo() << "GameServer: handed off" << handedRooms << "rooms and" << lobbySockets.size() << "lobby connections.";
+    return true;
+}
+
+bool GameServer::takeOver()
+{
+    const int channel = Handoff::connectToPeer();
+    if (channel < 0) {
+        qWarning() << "GameServer: 没有找到可以接管的服务器进程";
+        return false;
+    }
+    if (!Handoff::peerIsSameUser(channel)) {
+        qWarning() << "GameServer: 交接入口属于其他用户的进程，放弃接管";
+        Handoff::closeDescriptor(channel);
+        return false;
+    }
+    QByteArray hello;
+    QDataStream helloOut(&hello, QIODevice::WriteOnly);
+    helloOut.setVersion(Protocol::STREAM_VERSION);
+    helloOut << HANDOFF_VERSION;
+
+    QByteArray header;
+    QList<int> descriptors;
+    if (!Handoff::sendMessage(channel, hello, {}) || !Handoff::receiveMessage(channel, &header, &descriptors)) {
+        qWarning() << "GameServer: 旧进程拒绝了交接请求";
+        for (int fd : std::as_const(descriptors)) Handoff::closeDescriptor(fd);
+        Handoff::closeDescriptor(channel);
+        return false;
+    }
+
+    QDataStream in(header);
+    in.setVersion(Protocol::STREAM_VERSION);
+    qint32 version = 0;
+    bool matchmakingMode = false, sharedPort = false, hasGame = false, hasMux = false;
+    qint32 players = 0, nextClientId = 1, nextRoom = 0, roomCount = 0;
+    QList<qint32> lobbyKinds, lobbySizes;
+    in >> version >> matchmakingMode >> sharedPort >> players >> nextClientId >> nextRoom
+       >> hasGame >> hasMux >> lobbyKinds >> lobbySizes >> roomCount;
+    if (in.status() != QDataStream::Ok || lobbyKinds.size() != lobbySizes.size()
+        || descriptors.size() != int(hasGame) + int(hasMux) + lobbyKinds.size()) {
+        qCritical() << "GameServer: 交接数据损坏，放弃接管";
+        for (int fd : std::as_const(descriptors)) Handoff::closeDescriptor(fd);
+        Handoff::closeDescriptor(channel);
+        return false;
+    }
+
+    desiredPlayers = players;
+    clientIdCounter = nextClientId;
+    roomCounter = nextRoom;
+    setReusePort(sharedPort);
+    if (matchmakingMode) initMatchmaking(players);
+
+    int next = 0;
+    if (hasGame) {
+        const int fd = descriptors.at(next++);
+        if (tcpServer->setSocketDescriptor(fd)) {
+            connect(tcpServer, &QTcpServer::newConnection, this, &GameServer::handleNewConnection);
+        } else {
+            qCritical() << "GameServer: 无法接管游戏端口" << tcpServer->errorString();
+            Handoff::closeDescriptor(fd);
+        }
+    }
+    if (hasMux) {
+        const int fd = descriptors.at(next++);
+        if (!muxServer->setSocketDescriptor(fd)) {
+            qCritical() << "GameServer: 无法接管多路复用端口" << muxServer->errorString();
+            Handoff::closeDescriptor(fd);
+        }
+    }
+    //大厅中的连接重新进入大厅，已经排队的按原来的人数直接排队
+    for (int i = 0; i < lobbyKinds.size(); ++i) {
+        QIODevice* socket = Handoff::adopt(descriptors.at(next++), Handoff::SocketKind(lobbyKinds.at(i)));
+        if (!socket) continue;
+        socket->setParent(this);
+        const int sessionId = sessionCounter;
+        acceptSession(socket);
+        if (lobbySizes.at(i) > 0) queueSession(sessionId, lobbySizes.at(i));
+    }
+
+    int adopted = 0;
+    for (int i = 0; i < roomCount; ++i) {
+        if (adoptRoom(channel)) adopted++;
+    }
+    Handoff::closeDescriptor(channel);
+
+    listenLocal();
+    listenMux();
+    listenForward();
+    listenHandoff();
+    qInfo() << "GameServer: 已接管旧进程，房间" << adopted << "/" << roomCount << "大厅连接" << lobbyKinds.size()
+            << (matchmaking ? "自动匹配模式" : "单桌模式");
+    return true;
+}
+
+bool GameServer::adoptRoom(int channel)
+{
+    QByteArray message;
+    QList<int> descriptors;
+    if (!Handoff::receiveMessage(channel, &message, &descriptors)) {
+        for (int fd : std::as_const(descriptors)) Handoff::closeDescriptor(fd);
+        return false;
+    }
+
+    QDataStream in(message);
+    in.setVersion(Protocol::STREAM_VERSION);
+    QString roomId;
+    QList<qint32> kinds;
+    QByteArray state;
+    in >> roomId >> kinds >> state;
+    if (in.status() != QDataStream::Ok || kinds.size() != descriptors.size()) {
+        qWarning() << "GameServer: room" << roomId << "handoff data is corrupt.";
+        for (int fd : std::as_const(descriptors)) Handoff::closeDescriptor(fd);
+        return false;
+    }
+
+    QThread* thread = matchmaking ? roomThreads.at(nextRoomThread++ % roomThreads.size()) : this->thread();
+    QList<QIODevice*> sockets;
+    for (int i = 0; i < descriptors.size(); ++i) {
+        QIODevice* socket = Handoff::adopt(descriptors.at(i), Handoff::SocketKind(kinds.at(i)));
+        if (socket) socket->moveToThread(thread);
+        sockets.append(socket);
+    }
+
+    if (!matchmaking) {
+        serverController->importRoom(state, sockets);
+        return true;
+    }
+    ServerController* room = createRoom(thread, roomId);
+    QMetaObject::invokeMethod(room, [room, state, sockets]() {
+        room->importRoom(state, sockets);
+    }, Qt::QueuedConnection);
+    qInfo() << "GameServer: room" << roomId << "adopted on" << thread->objectName() << "with" << sockets.size() << "connections.";
+    return true;
+}
@@ -1,27 +1,99 @@
-#ifndef GAMESERVER_H
-#define GAMESERVER_H
-
-#include <QObject>
-#include <QTcpServer>
-#include <QInputDialog>
-#include "servercontroller.h"
-
-class GameServer : public QObject
-{
-    Q_OBJECT
-public:
-    explicit GameServer(QWidget *parentWidget = nullptr, QObject *parent = nullptr);
-    void startServer();
-
-private slots:
-    void handleNewConnection();
-
-private:
-    QTcpServer *tcpServer;
-    ServerController *serverController;
-    QWidget *m_parentWidget;  // 用于显示对话框的父窗口
-    int clientIdCounter = 1;
-    int desiredPlayers = 0;
-};
-
-#endif // GAMESERVER_H
+#ifndef GAMESERVER_H
+#define GAMESERVER_H
+
+#include <QObject>
+#include <QTcpServer>
+#include <QLocalServer>
+#include <QInputDialog>
+#include <QHash>
+#include <QSet>
+#include <QThread>
+#include "servercontroller.h"
+#include "matchmaker.h"
+#include "roomregistry.h"
+#include "admissionserver.h"
+#include <../FCGClient/controller/muxtransport.h>
+
+class GameServer : public QObject
+{
+    Q_OBJECT
+public:
+    explicit GameServer(QWidget *parentWidget = nullptr, QObject *parent = nullptr);
+    ~GameServer();
+    //多进程共用端口：以 SO_REUSEPORT 监听，由内核在进程间分配连接，房间归属记在本机登记表中。
+    //须在 startServer 之前调用
+    void setReusePort(bool enabled);
+    void startServer();
+    //平滑重启：从正在运行的旧进程接管监听端口、大厅中的连接与所有房间，成功后不再询问服务器模式
+    bool takeOver();
+
+private slots:
+    void handleNewConnection();
+    void handleNewLocalConnection();
+    void handleNewMuxLink();
+    void handleForwardedConnection();
+    void handleHandoffRequest();
+    void startRoom(const MatchGroup& group);
+
+private:
+    QTcpServer *tcpServer;
+    QLocalServer *localServer;
+    //网关等多路复用连接：TCP 与本地套接字各一个入口
+    QTcpServer *muxServer;
+    QLocalServer *localMuxServer;
+    //多进程时本进程的转发入口，其他进程把属于本进程房间的连接转到这里
+    QLocalServer *forwardServer;
+    //新版本进程从这里接管本进程，交接完成后本进程退出
+    QLocalServer *handoffServer;
+    bool handedOff = false;
+    bool reusePort = false;
+    RoomRegistry* registry = nullptr;
+    QString instanceEndpoint;
+    ServerController *serverController;
+    QWidget *m_parentWidget;  // 用于显示对话框的父窗口
+    int clientIdCounter = 1;  // 单桌模式的下一个座位号
+    int sessionCounter = 1;   // 大厅中连接的编号
+    int desiredPlayers = 0;
+
+    //连接先在大厅等待 MATCH_MSG；自动匹配模式再交给匹配线程，凑好的房间分配到工作线程
+    bool matchmaking = false;
+    Matchmaker* matchmaker = nullptr;
+    QThread matcherThread;
+    QList<QThread*> roomThreads;
+    int nextRoomThread = 0;
+    QHash<int, QIODevice*> lobby;    // sessionId -> 尚未入座的连接（TCP 或本地套接字）
+    QHash<int, int> queuedSessions;  // 已经交给匹配器的 sessionId -> 每桌人数（转发中的为 0）
+
+    //房间清空后先在主线程移出房间表，再请求销毁，表中的指针因此始终有效
+    struct Room
+    {
+        ServerController* controller = nullptr;
+        QThread* thread = nullptr;
+    };
+    QHash<QString, Room> rooms;      // 房间号 -> 本进程中的房间
+    int roomCounter = 0;
+
+    void startMatchmaking(int defaultTableSize);
+    void initMatchmaking(int defaultTableSize);
+    ServerController* createRoom(QThread* thread, const QString& roomId);
+    bool listenTcp(QTcpServer* server, quint16 port);
+    bool listenLocalName(QLocalServer* server, const QString& name);
+    void listenLocal();
+    void listenMux();
+    void listenForward();
+    void listenHandoff();
+    bool handOff(QLocalSocket* peer);
+    bool adoptRoom(int channel);
+    void addMuxLink(QIODevice* link);
+    void acceptClient(QIODevice* socket);
+    void acceptSession(QIODevice* socket);
+    void readMatchRequest(int sessionId);
+    //收到第一条消息后：自动匹配模式交给匹配器，单桌模式直接入座
+    void admitSession(int sessionId, int tableSize);
+    void queueSession(int sessionId, int tableSize);
+    void dropSession(int sessionId);
+    void joinRoom(int sessionId, const QString& roomId, const QString& seatToken);
+    void forwardSession(int sessionId, const QString& endpoint, const QString& roomId, const QString& seatToken);
+};
+
+#endif // GAMESERVER_H
@@ -0,0 +1,260 @@
+#include "handoff.h"
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QTcpSocket>
+#include <QLocalSocket>
+#include <QtEndian>
+#include <cstring>
+#if defined(Q_OS_UNIX)
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+namespace {
+#if defined(Q_OS_UNIX)
+void setBlocking(int fd)
+{
+    const int flags = ::fcntl(fd, F_GETFL);
+    if (flags != -1 && (flags & O_NONBLOCK)) {
+        ::fcntl(fd, F_SETFL, flags & ~O_NONBLOCK);
+    }
+    //阻塞读写也有上限，超时后 send/recv 返回 EAGAIN
+    timeval timeout{};
+    timeout.tv_sec = Handoff::TIMEOUT_MS / 1000;
+    timeout.tv_usec = (Handoff::TIMEOUT_MS % 1000) * 1000;
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+}
+
+bool writeAll(int fd, const char* data, size_t size)
+{
+    while (size > 0) {
+        const ssize_t written = ::send(fd, data, size, 0);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += written;
+        size -= size_t(written);
+    }
+    return true;
+}
+
+bool readAll(int fd, char* data, size_t size)
+{
+    while (size > 0) {
+        const ssize_t received = ::recv(fd, data, size, 0);
+        if (received < 0 && errno == EINTR) continue;
+        if (received <= 0) return false;
+        data += received;
+        size -= size_t(received);
+    }
+    return true;
+}
+#endif
+}
+
+int Handoff::duplicate(QIODevice *socket, SocketKind *kind)
+{
+#if defined(Q_OS_UNIX)
+    qintptr descriptor = -1;
+    if (QTcpSocket* tcpSocket = qobject_cast<QTcpSocket*>(socket)) {
+        descriptor = tcpSocket->socketDescriptor();
+        *kind = TcpSocket;
+    } else if (QLocalSocket* localSocket = qobject_cast<QLocalSocket*>(socket)) {
+        descriptor = localSocket->socketDescriptor();
+        *kind = LocalSocket;
+    }
+    return duplicate(descriptor);
+#else
+    Q_UNUSED(socket)
+    Q_UNUSED(kind)
+    return -1;
+#endif
+}
+
+int Handoff::duplicate(qintptr descriptor)
+{
+#if defined(Q_OS_UNIX)
+    if (descriptor < 0) return -1;
+    return ::dup(int(descriptor));
+#else
+    Q_UNUSED(descriptor)
+    return -1;
+#endif
+}
+
+QIODevice *Handoff::adopt(int descriptor, SocketKind kind)
+{
+    if (kind == TcpSocket) {
+        QTcpSocket* socket = new QTcpSocket;
+        if (socket->setSocketDescriptor(descriptor)) return socket;
+        qWarning() << "Handoff: cannot adopt TCP descriptor" << descriptor << socket->errorString();
+        delete socket;
+    } else if (kind == LocalSocket) {
+        QLocalSocket* socket = new QLocalSocket;
+        if (socket->setSocketDescriptor(descriptor)) return socket;
+        qWarning() << "Handoff: cannot adopt local descriptor" << descriptor << socket->errorString();
+        delete socket;
+    }
+    closeDescriptor(descriptor);
+    return nullptr;
+}
+
+void Handoff::closeDescriptor(int descriptor)
+{
+#if defined(Q_OS_UNIX)
+    if (descriptor >= 0) ::close(descriptor);
+#else
+    Q_UNUSED(descriptor)
+#endif
+}
+
+int Handoff::connectToPeer()
+{
+#if defined(Q_OS_UNIX)
+    //与 QLocalServer 在 Unix 上的命名规则一致：相对名字放在临时目录下
+    const QByteArray path = QFile::encodeName(QDir::temp().absoluteFilePath(SERVER_NAME));
+    sockaddr_un address{};
+    if (size_t(path.size()) >= sizeof(address.sun_path)) return -1;
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.constData(), size_t(path.size()));
+
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+#else
+    return -1;
+#endif
+}
+
+bool Handoff::peerIsSameUser(int channel)
+{
+#if defined(Q_OS_LINUX)
+    ucred credentials{};
+    socklen_t size = sizeof(credentials);
+    if (::getsockopt(channel, SOL_SOCKET, SO_PEERCRED, &credentials, &size) < 0) {
+        qWarning() << "Handoff: cannot read peer credentials:" << std::strerror(errno);
+        return false;
+    }
+    return credentials.uid == ::getuid();
+#elif defined(Q_OS_UNIX)
+    uid_t uid = 0;
+    gid_t gid = 0;
+    if (::getpeereid(channel, &uid, &gid) < 0) {
+        qWarning() << "Handoff: cannot read peer credentials:" << std::strerror(errno);
+        return false;
+    }
+    return uid == ::getuid();
+#else
+    Q_UNUSED(channel)
+    return false;
+#endif
+}
+
+bool Handoff::sendMessage(int channel, const QByteArray &data, const QList<int> &descriptors)
+{
+#if defined(Q_OS_UNIX)
+    if (descriptors.size() > MAX_DESCRIPTORS) return false;
+    setBlocking(channel);
+
+    const quint32 length = qToBigEndian(quint32(data.size()));
+    iovec vector{};
+    vector.iov_base = const_cast<quint32*>(&length);
+    vector.iov_len = sizeof(length);
+
+    msghdr message{};
+    message.msg_iov = &vector;
+    message.msg_iovlen = 1;
+    //描述符挂在长度字段上，对方读到长度时一并收到
+    QByteArray control;
+    if (!descriptors.isEmpty()) {
+        const size_t payloadSize = descriptors.size() * sizeof(int);
+        control.fill('\0', int(CMSG_SPACE(payloadSize)));
+        message.msg_control = control.data();
+        message.msg_controllen = control.size();
+        cmsghdr* header = CMSG_FIRSTHDR(&message);
+        header->cmsg_level = SOL_SOCKET;
+        header->cmsg_type = SCM_RIGHTS;
+        header->cmsg_len = CMSG_LEN(payloadSize);
+        std::memcpy(CMSG_DATA(header), descriptors.constData(), payloadSize);
+    }
+
+    ssize_t sent;
+    do {
+        sent = ::sendmsg(channel, &message, 0);
+    } while (sent < 0 && errno == EINTR);
+    if (sent != ssize_t(sizeof(length))) {
+        qWarning() << "Handoff: sendmsg failed:" << std::strerror(errno);
+        return false;
+    }
+    return writeAll(channel, data.constData(), size_t(data.size()));
+#else
+    Q_UNUSED(channel)
+    Q_UNUSED(data)
+    Q_UNUSED(descriptors)
+    return false;
+#endif
+}
+
+bool Handoff::receiveMessage(int channel, QByteArray *data, QList<int> *descriptors)
+{
+#if defined(Q_OS_UNIX)
+    setBlocking(channel);
+
+    quint32 length = 0;
+    iovec vector{};
+    vector.iov_base = &length;
+    vector.iov_len = sizeof(length);
+
+    QByteArray control(int(CMSG_SPACE(MAX_DESCRIPTORS * sizeof(int))), '\0');
+    msghdr message{};
+    message.msg_iov = &vector;
+    message.msg_iovlen = 1;
+    message.msg_control = control.data();
+    message.msg_controllen = control.size();
+
+    ssize_t received;
+    do {
+        received = ::recvmsg(channel, &message, MSG_WAITALL);
+    } while (received < 0 && errno == EINTR);
+    //描述符先收下来，之后任何一步失败都由调用方关闭
+    for (cmsghdr* header = received >= 0 ? CMSG_FIRSTHDR(&message) : nullptr; header;
+         header = CMSG_NXTHDR(&message, header)) {
+        if (header->cmsg_level != SOL_SOCKET || header->cmsg_type != SCM_RIGHTS) continue;
+        const int count = int((header->cmsg_len - CMSG_LEN(0)) / sizeof(int));
+        const int* fds = reinterpret_cast<const int*>(CMSG_DATA(header));
+        for (int i = 0; i < count; ++i) descriptors->append(fds[i]);
+    }
+    if (received != ssize_t(sizeof(length))) {
+        if (received < 0) qWarning() << "Handoff: recvmsg failed:" << std::strerror(errno);
+        return false;
+    }
+    if (message.msg_flags & MSG_CTRUNC) {
+        qWarning() << "Handoff: descriptors truncated";
+        return false;
+    }
+
+    length = qFromBigEndian(length);
+    if (length > quint32(MAX_MESSAGE_BYTES)) {
+        qWarning() << "Handoff: message of" << length << "bytes exceeds the limit";
+        return false;
+    }
+    data->resize(int(length));
+    return readAll(channel, data->data(), size_t(data->size()));
+#else
+    Q_UNUSED(channel)
+    Q_UNUSED(data)
+    Q_UNUSED(descriptors)
+    return false;
+#endif
+}
@@ -0,0 +1,48 @@
+#ifndef HANDOFF_H
+#define HANDOFF_H
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+
+class QIODevice;
+
+// 平滑重启：旧进程通过 Unix 域套接字（SCM_RIGHTS）把监听端口与客户端连接的描述符交给新进程。
+// 消息格式：[quint32 长度][数据]，描述符作为附属数据随同一条消息发送。
+// 只有 Unix 平台支持，其他平台上各函数直接返回失败。
+class Handoff
+{
+public:
+    enum SocketKind : qint32 {
+        TcpSocket = 0,
+        LocalSocket
+    };
+
+    // 旧进程在这个本地套接字名上等待新进程
+    static constexpr char SERVER_NAME[] = "fcg-server-handoff";
+    // 一条消息最多附带的描述符数，超出的连接不转交
+    static constexpr int MAX_DESCRIPTORS = 250;
+    // 一条消息的数据上限，长度字段超出时按损坏处理
+    static constexpr int MAX_MESSAGE_BYTES = 16 * 1024 * 1024;
+    // 收发超时，对端停住时不让调用方（主线程）一直阻塞
+    static constexpr int TIMEOUT_MS = 3000;
+
+    // 复制连接的描述符，原设备关闭后连接仍然保持；内存管道、多路复用会话等无法转交，返回 -1
+    static int duplicate(QIODevice* socket, SocketKind* kind);
+    // 监听套接字等只有描述符的情况
+    static int duplicate(qintptr descriptor);
+    // 用收到的描述符重建连接，失败时关闭描述符并返回 nullptr
+    static QIODevice* adopt(int descriptor, SocketKind kind);
+    static void closeDescriptor(int descriptor);
+
+    // 新进程一侧：连接旧进程的交接入口，失败返回 -1
+    static int connectToPeer();
+    // 对端进程与本进程属于同一用户；其他平台或取不到凭据时返回 false
+    static bool peerIsSameUser(int channel);
+    // 阻塞收发，最多等待 TIMEOUT_MS；descriptors 中的描述符发送后仍归调用方所有，
+    // 接收失败时已经收到的描述符同样放在 descriptors 中，由调用方关闭
+    static bool sendMessage(int channel, const QByteArray& data, const QList<int>& descriptors);
+    static bool receiveMessage(int channel, QByteArray* data, QList<int>* descriptors);
+};
+
+#endif // HANDOFF_H
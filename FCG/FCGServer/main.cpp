@@ -1,28 +1,42 @@
-#include "gameserver.h"
-#include <QApplication>
-#include <QBoxLayout>
-#include <QTextEdit>
-
-int main(int argc, char *argv[])
-{
-    QApplication a(argc, argv);
-
-    QWidget widget;
-    widget.setWindowTitle("飞行棋服务器");
-    widget.show();
-    /*QTextEdit *logView = new QTextEdit(&widget);
-    logView->setReadOnly(true);
-    QVBoxLayout *layout = new QVBoxLayout(&widget);
-    layout->addWidget(logView);
-
-    // 重定向qInfo输出到界面
-    qInstallMessageHandler([](QtMsgType type, const QMessageLogContext &context, const QString &msg){
-        Q_UNUSED(context)
-        logView->append(QString("[%1] %2").arg(QTime::currentTime().toString()).arg(msg));
-    });
-*/
-    GameServer server(&widget);
-    server.startServer();
-
-    return a.exec();
-}
+#include "gameserver.h"
+#include <QApplication>
+#include <QBoxLayout>
+#include <QTextEdit>
+#include <QCommandLineParser>
+
+int main(int argc, char *argv[])
+{
+    QApplication a(argc, argv);
+
+    //同一台机器上可以启动多个服务器进程共用端口，由内核在进程间分配连接
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption reusePortOption("reuse-port", "Share the game ports with other server processes (SO_REUSEPORT).");
+    parser.addOption(reusePortOption);
+    //平滑重启：新版本进程带这个参数启动，从正在运行的旧进程接管端口和所有对局，旧进程随后退出
+    QCommandLineOption takeoverOption("takeover", "Take over listening sockets and live rooms from a running server.");
+    parser.addOption(takeoverOption);
+    parser.process(a);
+
+    QWidget widget;
+    widget.setWindowTitle("飞行棋服务器");
+    widget.show();
+    /*QTextEdit *logView = new QTextEdit(&widget);
+    logView->setReadOnly(true);
+    QVBoxLayout *layout = new QVBoxLayout(&widget);
+    layout->addWidget(logView);
+
+    // 重定向qInfo输出到界面
+    qInstallMessageHandler([](QtMsgType type, const QMessageLogContext &context, const QString &msg){
+        Q_UNUSED(context)
+        logView->append(QString("[%1] %2").arg(QTime::currentTime().toString()).arg(msg));
+    });
+*/
+    GameServer server(&widget);
+    server.setReusePort(parser.isSet(reusePortOption));
+    if (!parser.isSet(takeoverOption) || !server.takeOver()) {
+        server.startServer();
+    }
+
+    return a.exec();
+}
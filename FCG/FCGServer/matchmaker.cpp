@@ -0,0 +1,158 @@
+#include "matchmaker.h"
+#include <QDebug>
+#include <QTimer>
+#include <algorithm>
+#include <../FCGClient/controller/gameclock.h>
+
+namespace {
+// 检查等待超时的间隔，最长等待时间 = 补位延迟 + 这个间隔
+const int BACKFILL_CHECK_MS = 100;
+const int METRICS_INTERVAL_MS = 5000;
+// 单个统计周期最多保留的样本数，超出后不再记录
+const int MAX_WAIT_SAMPLES = 1 << 16;
+
+int percentile(const QList<int>& sorted, int p)
+{
+    if (sorted.isEmpty()) return 0;
+    const int index = qMin(int(sorted.size()) - 1, int(sorted.size()) * p / 100);
+    return sorted.at(index);
+}
+}
+
+Matchmaker::Matchmaker(int delayMs, QObject *parent)
+    : QObject(parent), backfillDelayMs(qMax(0, delayMs))
+{
+    qRegisterMetaType<MatchGroup>("MatchGroup");
+}
+
+void Matchmaker::start()
+{
+    lastReportMs = GameClock::system()->nowMs();
+
+    backfillTimer = new QTimer(this);
+    connect(backfillTimer, &QTimer::timeout, this, &Matchmaker::checkBackfill);
+    backfillTimer->start(BACKFILL_CHECK_MS);
+
+    metricsTimer = new QTimer(this);
+    connect(metricsTimer, &QTimer::timeout, this, &Matchmaker::reportMetrics);
+    metricsTimer->start(METRICS_INTERVAL_MS);
+
+    qInfo() << "Matchmaker started. AI backfill after" << backfillDelayMs << "ms.";
+}
+
+void Matchmaker::enqueue(int sessionId, int tableSize)
+{
+    Arrival arrival;
+    arrival.sessionId = sessionId;
+    arrival.tableSize = qBound(MIN_TABLE_SIZE, tableSize, MAX_TABLE_SIZE);
+    arrival.arrivedMs = GameClock::system()->nowMs();
+    arrivals.push(arrival);
+    postDrain();
+}
+
+void Matchmaker::cancel(int sessionId)
+{
+    Arrival arrival;
+    arrival.sessionId = sessionId;
+    arrivals.push(arrival);
+    postDrain();
+}
+
+void Matchmaker::postDrain()
+{
+    //队列非空期间最多挂一个 drain，突发到达时不会塞满事件队列
+    if (!drainPosted.exchange(true, std::memory_order_acq_rel)) {
+        QMetaObject::invokeMethod(this, &Matchmaker::drain, Qt::QueuedConnection);
+    }
+}
+
+void Matchmaker::drain()
+{
+    //先清标志再取：清之后入队的元素一定会再触发一次 drain
+    drainPosted.store(false, std::memory_order_release);
+
+    Arrival arrival;
+    while (arrivals.tryPop(arrival)) {
+        if (arrival.tableSize == 0) {
+            const int tableSize = waitingTable.take(arrival.sessionId);
+            if (tableSize == 0) continue;
+            QList<Arrival>& bucket = waiting[tableSize];
+            for (int i = 0; i < bucket.size(); ++i) {
+                if (bucket.at(i).sessionId == arrival.sessionId) {
+                    bucket.removeAt(i);
+                    break;
+                }
+            }
+            continue;
+        }
+
+        QList<Arrival>& bucket = waiting[arrival.tableSize];
+        bucket.append(arrival);
+        waitingTable.insert(arrival.sessionId, arrival.tableSize);
+        if (bucket.size() >= arrival.tableSize) {
+            formGroup(arrival.tableSize, arrival.tableSize);
+        }
+    }
+}
+
+void Matchmaker::checkBackfill()
+{
+    const qint64 now = GameClock::system()->nowMs();
+    for (int tableSize = MIN_TABLE_SIZE; tableSize <= MAX_TABLE_SIZE; ++tableSize) {
+        QList<Arrival>& bucket = waiting[tableSize];
+        //队列按到达时间排列，只需看队首
+        while (!bucket.isEmpty() && now - bucket.first().arrivedMs >= backfillDelayMs) {
+            formGroup(tableSize, qMin(int(bucket.size()), tableSize));
+        }
+    }
+}
+
+void Matchmaker::formGroup(int tableSize, int humans)
+{
+    QList<Arrival>& bucket = waiting[tableSize];
+    const qint64 now = GameClock::system()->nowMs();
+
+    MatchGroup group;
+    group.tableSize = tableSize;
+    group.bots = tableSize - humans;
+    group.sessionIds.reserve(humans);
+    for (int i = 0; i < humans; ++i) {
+        const Arrival arrival = bucket.takeFirst();
+        waitingTable.remove(arrival.sessionId);
+        group.sessionIds.append(arrival.sessionId);
+        if (waitSamples.size() < MAX_WAIT_SAMPLES) {
+            waitSamples.append(int(now - arrival.arrivedMs));
+        }
+    }
+
+    ++matchesSinceReport;
+    botsSinceReport += group.bots;
+    qDebug() << "Matchmaker: formed" << tableSize << "player table with sessions" << group.sessionIds
+             << "and" << group.bots << "AI seats.";
+    emit matchFormed(group);
+}
+
+void Matchmaker::reportMetrics()
+{
+    const qint64 now = GameClock::system()->nowMs();
+    const double seconds = qMax<qint64>(1, now - lastReportMs) / 1000.0;
+    lastReportMs = now;
+
+    std::sort(waitSamples.begin(), waitSamples.end());
+    //固定格式，便于日志采集
+    qInfo().noquote() << QString("matchmaking matches_per_sec=%1 ai_seats=%2 wait_ms_p50=%3 wait_ms_p90=%4 "
+                                 "wait_ms_p99=%5 wait_ms_max=%6 queued_2=%7 queued_3=%8 queued_4=%9")
+                             .arg(matchesSinceReport / seconds, 0, 'f', 1)
+                             .arg(botsSinceReport)
+                             .arg(percentile(waitSamples, 50))
+                             .arg(percentile(waitSamples, 90))
+                             .arg(percentile(waitSamples, 99))
+                             .arg(waitSamples.isEmpty() ? 0 : waitSamples.last())
+                             .arg(waiting[2].size())
+                             .arg(waiting[3].size())
+                             .arg(waiting[4].size());
+
+    waitSamples.clear();
+    matchesSinceReport = 0;
+    botsSinceReport = 0;
+}
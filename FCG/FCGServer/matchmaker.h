@@ -0,0 +1,76 @@
+#ifndef MATCHMAKER_H
+#define MATCHMAKER_H
+
+#include <QObject>
+#include <QList>
+#include <QHash>
+#include <QMetaType>
+#include <atomic>
+#include "mpscqueue.h"
+
+class QTimer;
+
+// 一个凑好的房间：sessionIds 按到达顺序排列，bots 为需要 AI 补齐的座位数
+struct MatchGroup
+{
+    int tableSize = 0;
+    QList<int> sessionIds;
+    int bots = 0;
+};
+Q_DECLARE_METATYPE(MatchGroup)
+
+// 匹配器：连接到达后进入无锁队列，匹配线程按要求的桌面人数（2~4）分组，
+// 凑满或等待超时（由 AI 补位）后发出 matchFormed。
+// 本对象应移到单独的线程中运行，enqueue/cancel 可以在任意线程调用。
+class Matchmaker : public QObject
+{
+    Q_OBJECT
+public:
+    static constexpr int MIN_TABLE_SIZE = 2;
+    static constexpr int MAX_TABLE_SIZE = 4;
+
+    explicit Matchmaker(int backfillDelayMs, QObject *parent = nullptr);
+
+    void enqueue(int sessionId, int tableSize);
+    //连接在匹配前断开
+    void cancel(int sessionId);
+
+public slots:
+    //在匹配线程中调用，创建定时器
+    void start();
+
+signals:
+    void matchFormed(const MatchGroup& group);
+
+private slots:
+    void drain();
+    void checkBackfill();
+    void reportMetrics();
+
+private:
+    struct Arrival
+    {
+        int sessionId = 0;
+        int tableSize = 0;    // 0 表示取消
+        qint64 arrivedMs = 0;
+    };
+
+    void postDrain();
+    void formGroup(int tableSize, int humans);
+
+    MpscQueue<Arrival> arrivals;
+    std::atomic<bool> drainPosted{false};
+
+    //以下只在匹配线程中访问
+    const int backfillDelayMs;
+    QList<Arrival> waiting[MAX_TABLE_SIZE + 1];
+    QHash<int, int> waitingTable;   // sessionId -> 桌面人数
+    QList<int> waitSamples;         // 本统计周期内的等待时间（毫秒）
+    int matchesSinceReport = 0;
+    int botsSinceReport = 0;
+    qint64 lastReportMs = 0;
+    QTimer* backfillTimer = nullptr;
+    QTimer* metricsTimer = nullptr;
+};
+
+#endif // MATCHMAKER_H
@@ -0,0 +1,192 @@
+#include "montecarlobot.h"
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QSemaphore>
+#include <QThreadPool>
+#include <QVector>
+#include <cmath>
+
+namespace {
+// 每个模拟线程各自累计，结束后再合并，避免线程间争用
+struct WorkerStats
+{
+    QVector<double> score;
+    QVector<int> visits;
+};
+}
+
+BotDecision MonteCarloBot::chooseMove(const BoardPosition &position, int playerId, int dice,
+                                      const MonteCarloOptions &options, QThreadPool *helperPool)
+{
+    BotDecision decision;
+    const QList<Candidate> moves = candidates(position, playerId, dice);
+    if (moves.isEmpty()) {
+        // 没有可走的飞机，交给服务器按原流程处理（提示无法起飞后换人）
+        return decision;
+    }
+    decision.planeId = moves.first().planeId;
+    decision.fly = moves.first().fly;
+    if (moves.size() == 1) {
+        return decision;
+    }
+
+    // 掷出6点继续由自己行动
+    const int following = dice == 6 ? playerId : nextActivePlayer(position, playerId);
+    const int moveCount = int(moves.size());
+    const quint64 seed = options.seed != 0 ? options.seed : QRandomGenerator::global()->generate64();
+    QElapsedTimer timer;
+    timer.start();
+
+    auto runWorker = [&, seed](int workerIndex, WorkerStats &stats) {
+        QRandomGenerator rng(quint32(seed + quint64(workerIndex) * 0x9E3779B97F4A7C15ull));
+        stats.score.fill(0.0, moveCount);
+        stats.visits.fill(0, moveCount);
+        int total = 0;
+        // UCB1：在时间预算（或固定局数）内把模拟次数更多地分给有希望的着法
+        while (options.playouts > 0 ? total < options.playouts : !timer.hasExpired(options.budgetMs)) {
+            int pick = total < moveCount ? total : 0;
+            if (total >= moveCount) {
+                double best = -1.0;
+                const double logTotal = std::log(double(total));
+                for (int i = 0; i < moveCount; ++i) {
+                    const double ucb = stats.score[i] / stats.visits[i]
+                                       + std::sqrt(2.0 * logTotal / stats.visits[i]);
+                    if (ucb > best) {
+                        best = ucb;
+                        pick = i;
+                    }
+                }
+            }
+            stats.score[pick] += playout(moves[pick].after, playerId, following, options.maxPlies, rng);
+            stats.visits[pick]++;
+            total++;
+        }
+    };
+
+    const int threads = qMax(1, options.threads);
+    QVector<WorkerStats> stats(threads);
+    QSemaphore finished;
+    int helpers = 0;
+    for (int i = 1; i < threads && helperPool; ++i) {
+        WorkerStats *slot = &stats[i];
+        if (!helperPool->tryStart([&runWorker, &finished, i, slot]() {
+                runWorker(i, *slot);
+                finished.release();
+            })) {
+            break;
+        }
+        helpers++;
+    }
+    runWorker(0, stats[0]);
+    finished.acquire(helpers);
+
+    QVector<double> score(moveCount, 0.0);
+    QVector<int> visits(moveCount, 0);
+    for (int w = 0; w <= helpers; ++w) {
+        for (int i = 0; i < moveCount; ++i) {
+            score[i] += stats[w].score[i];
+            visits[i] += stats[w].visits[i];
+        }
+    }
+
+    double bestRate = -1.0;
+    for (int i = 0; i < moveCount; ++i) {
+        decision.work += visits[i];
+        if (visits[i] == 0) continue;
+        const double rate = score[i] / visits[i];
+        if (rate > bestRate) {
+            bestRate = rate;
+            decision.planeId = moves[i].planeId;
+            decision.fly = moves[i].fly;
+        }
+    }
+    decision.winRate = qMax(0.0, bestRate);
+
+    qDebug() << "MonteCarloBot: player" << playerId << "dice" << dice << "chose plane" << decision.planeId
+             << "fly" << decision.fly << "playouts" << decision.work << "threads" << helpers + 1
+             << "elapsed" << timer.elapsed() << "ms";
+    return decision;
+}
+
+QList<MonteCarloBot::Candidate> MonteCarloBot::candidates(const BoardPosition &position, int playerId, int dice)
+{
+    QList<Candidate> result;
+    for (int planeId = 1; planeId <= 4; ++planeId) {
+        if (!GameRules::canMove(position, playerId, dice, planeId)) continue;
+
+        Candidate stay{planeId, false, position};
+        if (GameRules::applyMove(stay.after, playerId, dice, planeId) == GameRules::MoveCanFly) {
+            Candidate fly{planeId, true, stay.after};
+            GameRules::applyFly(fly.after, playerId, planeId);
+            result.append(fly);
+        }
+        result.append(stay);
+    }
+    return result;
+}
+
+double MonteCarloBot::playout(BoardPosition position, int botId, int nextPlayer, int maxPlies, QRandomGenerator &rng)
+{
+    int player = nextPlayer;
+    for (int ply = 0; ply < maxPlies; ++ply) {
+        const int won = GameRules::winner(position);
+        if (won != 0) return won == botId ? 1.0 : 0.0;
+
+        const int dice = int(rng.bounded(6)) + 1;
+        int movable[4];
+        int movableCount = 0;
+        for (int planeId = 1; planeId <= 4; ++planeId) {
+            if (GameRules::canMove(position, player, dice, planeId)) movable[movableCount++] = planeId;
+        }
+        if (movableCount > 0) {
+            // 模拟策略：随机选一架能动的飞机，能飞就飞
+            const int planeId = movable[rng.bounded(movableCount)];
+            if (GameRules::applyMove(position, player, dice, planeId) == GameRules::MoveCanFly) {
+                GameRules::applyFly(position, player, planeId);
+            }
+        }
+        if (dice != 6) player = nextActivePlayer(position, player);
+    }
+
+    const int won = GameRules::winner(position);
+    if (won != 0) return won == botId ? 1.0 : 0.0;
+    return evaluate(position, botId);
+}
+
+double MonteCarloBot::evaluate(const BoardPosition &position, int botId)
+{
+    // 未分胜负时按剩余总步数估计胜率：自己剩得越少得分越高
+    double own = 0.0;
+    double others = 0.0;
+    int opponents = 0;
+    for (int playerId = 1; playerId <= 4; ++playerId) {
+        if (!position.isActivePlayer(playerId)) continue;
+        int remaining = 0;
+        for (int planeId = 1; planeId <= 4; ++planeId) {
+            const int globalPlaneId = (playerId - 1) * 4 + planeId;
+            if (!position.isFinished(globalPlaneId)) {
+                remaining += GameRules::distanceToGoal(playerId, position.tile[globalPlaneId - 1]);
+            }
+        }
+        if (playerId == botId) {
+            own = remaining;
+        } else {
+            others += remaining;
+            opponents++;
+        }
+    }
+    if (opponents == 0) return 1.0;
+    const double averageOthers = others / opponents;
+    if (own + averageOthers <= 0.0) return 0.5;
+    return averageOthers / (own + averageOthers);
+}
+
+int MonteCarloBot::nextActivePlayer(const BoardPosition &position, int playerId)
+{
+    for (int i = 1; i <= 4; ++i) {
+        const int candidate = (playerId - 1 + i) % 4 + 1;
+        if (position.isActivePlayer(candidate)) return candidate;
+    }
+    return playerId;
+}
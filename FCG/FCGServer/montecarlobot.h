@@ -0,0 +1,54 @@
+#ifndef MONTECARLOBOT_H
+#define MONTECARLOBOT_H
+
+#include <../FCGClient/model/gamerules.h>
+#include <QThread>
+
+class QThreadPool;
+class QRandomGenerator;
+
+struct MonteCarloOptions
+{
+    int budgetMs = 5;                               // 每步思考时间
+    int threads = QThread::idealThreadCount();      // 并行模拟的线程数（含调用线程）
+    int maxPlies = 120;                             // 单次模拟的最大步数，超出后按剩余步数估值
+    int playouts = 0;                               // 大于 0 时每个线程模拟这么多局就停，不看时间
+    quint64 seed = 0;                               // 非 0 时用它做随机种子，同样的输入得到同样的结果
+};
+
+struct BotDecision
+{
+    int planeId = 1;
+    bool fly = true;        // 落在同色格时是否飞跃
+    int work = 0;           // 本次搜索量：蒙特卡洛为模拟局数，期望搜索为搜索节点数
+    int depth = 0;          // 期望搜索完成的深度
+    double winRate = 0.0;   // 所选着法的平均得分
+};
+
+// 蒙特卡洛 AI：对每个可选着法（飞机 × 是否飞跃）做大量随机对局，取平均得分最高者。
+// 纯计算，不持有状态，可在任意线程调用。
+class MonteCarloBot
+{
+public:
+    // helperPool 非空时尽量借用其中的空闲线程并行模拟；线程不够时只在调用线程里跑，不会互相等待
+    static BotDecision chooseMove(const BoardPosition& position, int playerId, int dice,
+                                  const MonteCarloOptions& options = MonteCarloOptions(),
+                                  QThreadPool* helperPool = nullptr);
+
+    // 按剩余步数估计 botId 的胜率，范围 0~1，期望搜索的叶子节点也用它估值
+    static double evaluate(const BoardPosition& position, int botId);
+
+private:
+    struct Candidate
+    {
+        int planeId;
+        bool fly;
+        BoardPosition after;
+    };
+
+    static QList<Candidate> candidates(const BoardPosition& position, int playerId, int dice);
+    static double playout(BoardPosition position, int botId, int nextPlayer, int maxPlies, QRandomGenerator& rng);
+    static int nextActivePlayer(const BoardPosition& position, int playerId);
+};
+
+#endif // MONTECARLOBOT_H
@@ -0,0 +1,62 @@
+#ifndef MPSCQUEUE_H
+#define MPSCQUEUE_H
+
+#include <atomic>
+#include <utility>
+
+// 多生产者、单消费者的无锁队列（侵入式链表，Vyukov 算法）。
+// push 可以在任意线程调用；tryPop 只能由同一个消费者线程调用。
+// T 需要可默认构造、可移动。
+template <typename T>
+class MpscQueue
+{
+public:
+    MpscQueue()
+    {
+        Node* stub = new Node;
+        head.store(stub, std::memory_order_relaxed);
+        tail = stub;
+    }
+
+    ~MpscQueue()
+    {
+        T discard;
+        while (tryPop(discard)) {}
+        delete tail;
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    void push(T value)
+    {
+        Node* node = new Node;
+        node->value = std::move(value);
+        //先抢占队头，再把前一个节点接上；两步之间消费者只会看到队列暂时“变短”
+        Node* prev = head.exchange(node, std::memory_order_acq_rel);
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    bool tryPop(T& out)
+    {
+        Node* next = tail->next.load(std::memory_order_acquire);
+        if (!next) return false;
+        out = std::move(next->value);
+        //next 成为新的哨兵节点
+        delete tail;
+        tail = next;
+        return true;
+    }
+
+private:
+    struct Node
+    {
+        std::atomic<Node*> next{nullptr};
+        T value;
+    };
+
+    std::atomic<Node*> head;  // 生产者写入端
+    Node* tail;               // 消费者读取端（哨兵）
+};
+
+#endif // MPSCQUEUE_H
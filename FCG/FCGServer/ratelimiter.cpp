@@ -0,0 +1,109 @@
+#include "ratelimiter.h"
+#include <QDebug>
+#include <QElapsedTimer>
+
+namespace {
+// 整个进程每秒最多接受的新连接，短时间内允许攒到 ACCEPT_BURST
+const double ACCEPTS_PER_SEC = 200;
+const double ACCEPT_BURST = 400;
+// 同一 IP 同时保持的连接数（网关的多路复用连接、同一 NAT 后的多个玩家都算在内）
+const int MAX_CONNECTIONS_PER_IP = 32;
+// 同一 IP 所有连接合计的消息与字节配额
+const double IP_FRAMES_PER_SEC = 200;
+const double IP_FRAME_BURST = 400;
+const double IP_BYTES_PER_SEC = 256 * 1024;
+const double IP_BYTE_BURST = 512 * 1024;
+// 拒绝的连接每攒这么多条打印一次，攻击时不刷屏
+const qint64 REJECT_LOG_INTERVAL = 100;
+}
+
+TokenBucket::TokenBucket(double r, double b)
+    : rate(r), burst(b), tokens(b)
+{
+}
+
+void TokenBucket::refill(qint64 nowMs)
+{
+    if (lastMs >= 0 && nowMs > lastMs) {
+        tokens = qMin(burst, tokens + rate * double(nowMs - lastMs) / 1000.0);
+    }
+    lastMs = nowMs;
+}
+
+int TokenBucket::waitMs(double amount, qint64 nowMs)
+{
+    refill(nowMs);
+    amount = qMin(amount, burst);
+    if (tokens >= amount) return 0;
+    if (rate <= 0) return 1000;
+    return qMax(1, int((amount - tokens) * 1000.0 / rate + 0.5));
+}
+
+int TokenBucket::take(double amount, qint64 nowMs)
+{
+    const int wait = waitMs(amount, nowMs);
+    if (wait == 0) tokens -= qMin(amount, burst);
+    return wait;
+}
+
+RateLimiter::RateLimiter()
+    : accepts(ACCEPTS_PER_SEC, ACCEPT_BURST)
+{
+}
+
+RateLimiter *RateLimiter::shared()
+{
+    static RateLimiter limiter;
+    return &limiter;
+}
+
+qint64 RateLimiter::nowMs()
+{
+    static QElapsedTimer timer = [] { QElapsedTimer t; t.start(); return t; }();
+    return timer.elapsed();
+}
+
+bool RateLimiter::admitConnection(const QHostAddress &address)
+{
+    QMutexLocker locker(&mutex);
+    const qint64 now = nowMs();
+    const auto it = peers.constFind(address);
+    const bool full = it != peers.constEnd() && it->connections >= MAX_CONNECTIONS_PER_IP;
+    if (full || accepts.take(1, now) != 0) {
+        if (++rejectedConnections % REJECT_LOG_INTERVAL == 1) {
+            qWarning() << "RateLimiter: rejecting connection from" << address.toString()
+                       << (full ? "(too many connections from this address)" : "(accept rate exceeded)")
+                       << "total rejected:" << rejectedConnections;
+        }
+        return false;
+    }
+    Peer& peer = peers[address];
+    if (peer.connections == 0) {
+        peer.frames = TokenBucket(IP_FRAMES_PER_SEC, IP_FRAME_BURST);
+        peer.bytes = TokenBucket(IP_BYTES_PER_SEC, IP_BYTE_BURST);
+    }
+    peer.connections++;
+    return true;
+}
+
+void RateLimiter::releaseConnection(const QHostAddress &address)
+{
+    QMutexLocker locker(&mutex);
+    auto it = peers.find(address);
+    if (it == peers.end()) return;
+    if (--it->connections <= 0) peers.erase(it);
+}
+
+int RateLimiter::admitFrame(const QHostAddress &address, qint64 bytes)
+{
+    QMutexLocker locker(&mutex);
+    auto it = peers.find(address);
+    if (it == peers.end()) return 0;
+    const qint64 now = nowMs();
+    //两个桶都够时才一起扣，避免只扣了一半
+    const int wait = qMax(it->frames.waitMs(1, now), it->bytes.waitMs(double(bytes), now));
+    if (wait != 0) return wait;
+    it->frames.take(1, now);
+    it->bytes.take(double(bytes), now);
+    return 0;
+}
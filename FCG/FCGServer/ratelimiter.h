@@ -0,0 +1,57 @@
+#ifndef RATELIMITER_H
+#define RATELIMITER_H
+
+#include <QHash>
+#include <QHostAddress>
+#include <QMutex>
+
+// 令牌桶：每秒补充 rate 个令牌，最多攒 burst 个。不加锁，由使用方保证单线程访问
+class TokenBucket
+{
+public:
+    TokenBucket(double rate = 0, double burst = 0);
+
+    // 令牌足够时取走并返回 0，否则不取，返回还要等待的毫秒数；超过 burst 的请求按 burst 计
+    int take(double amount, qint64 nowMs);
+    int waitMs(double amount, qint64 nowMs);
+
+private:
+    void refill(qint64 nowMs);
+
+    double rate;
+    double burst;
+    double tokens;
+    qint64 lastMs = -1;
+};
+
+// 进程内共享的接入控制与单 IP 配额，房间线程与主线程都会访问，内部加锁
+class RateLimiter
+{
+public:
+    static RateLimiter* shared();
+    // 单调时钟，所有令牌桶共用
+    static qint64 nowMs();
+
+    // 在创建任何连接对象之前调用：全局接入速率与单 IP 连接数都满足时放行，并计入该 IP 的连接数
+    bool admitConnection(const QHostAddress& address);
+    void releaseConnection(const QHostAddress& address);
+    // 单 IP 的消息数与字节数配额，返回需要等待的毫秒数，0 表示放行
+    int admitFrame(const QHostAddress& address, qint64 bytes);
+
+private:
+    RateLimiter();
+
+    struct Peer
+    {
+        int connections = 0;
+        TokenBucket frames;
+        TokenBucket bytes;
+    };
+
+    QMutex mutex;
+    TokenBucket accepts;
+    QHash<QHostAddress, Peer> peers;
+    qint64 rejectedConnections = 0;
+};
+
+#endif // RATELIMITER_H
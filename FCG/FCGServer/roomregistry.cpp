@@ -0,0 +1,92 @@
+#include "roomregistry.h"
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QJsonDocument>
+#include <QLockFile>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+namespace {
+// 登记表很小，拿不到锁说明另一个进程卡住了，放弃本次操作
+const int LOCK_TIMEOUT_MS = 500;
+}
+
+RoomRegistry::RoomRegistry(const QString &registryPath)
+    : path(registryPath)
+{
+}
+
+QString RoomRegistry::defaultPath()
+{
+    return QDir(QStandardPaths::writableLocation(QStandardPaths::TempLocation)).filePath("fcg-rooms.json");
+}
+
+bool RoomRegistry::registerRoom(const QString &roomId, const QString &endpoint)
+{
+    QLockFile lock(path + ".lock");
+    if (!lock.tryLock(LOCK_TIMEOUT_MS)) {
+        qWarning() << "RoomRegistry: cannot lock" << path << "to register" << roomId;
+        return false;
+    }
+    QJsonObject rooms = load();
+    QJsonObject entry;
+    entry.insert("endpoint", endpoint);
+    entry.insert("pid", QCoreApplication::applicationPid());
+    rooms.insert(roomId, entry);
+    return save(rooms);
+}
+
+void RoomRegistry::unregisterRoom(const QString &roomId)
+{
+    QLockFile lock(path + ".lock");
+    if (!lock.tryLock(LOCK_TIMEOUT_MS)) {
+        qWarning() << "RoomRegistry: cannot lock" << path << "to unregister" << roomId;
+        return;
+    }
+    QJsonObject rooms = load();
+    rooms.remove(roomId);
+    save(rooms);
+}
+
+void RoomRegistry::unregisterEndpoint(const QString &endpoint)
+{
+    QLockFile lock(path + ".lock");
+    if (!lock.tryLock(LOCK_TIMEOUT_MS)) return;
+    QJsonObject rooms = load();
+    for (auto it = rooms.begin(); it != rooms.end();) {
+        if (it.value().toObject().value("endpoint").toString() == endpoint) {
+            it = rooms.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    save(rooms);
+}
+
+QString RoomRegistry::ownerOf(const QString &roomId) const
+{
+    QLockFile lock(path + ".lock");
+    if (!lock.tryLock(LOCK_TIMEOUT_MS)) return QString();
+    return load().value(roomId).toObject().value("endpoint").toString();
+}
+
+QJsonObject RoomRegistry::load() const
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) return QJsonObject();
+    return QJsonDocument::fromJson(file.readAll()).object();
+}
+
+bool RoomRegistry::save(const QJsonObject &rooms) const
+{
+    //先写临时文件再替换，读者不会看到写了一半的内容
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "RoomRegistry: cannot write" << path << file.errorString();
+        return false;
+    }
+    file.write(QJsonDocument(rooms).toJson(QJsonDocument::Compact));
+    return file.commit();
+}
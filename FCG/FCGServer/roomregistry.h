@@ -0,0 +1,30 @@
+#ifndef ROOMREGISTRY_H
+#define ROOMREGISTRY_H
+
+#include <QString>
+#include <QJsonObject>
+
+// 同机多个服务器进程共用的房间登记表：房间号 -> 所属进程的转发入口（本地套接字名）。
+// 存为一个 JSON 文件，每次读改写都持有 QLockFile，进程之间不需要常驻的协调者。
+class RoomRegistry
+{
+public:
+    explicit RoomRegistry(const QString& path = defaultPath());
+
+    static QString defaultPath();
+
+    bool registerRoom(const QString& roomId, const QString& endpoint);
+    void unregisterRoom(const QString& roomId);
+    // 进程退出时清除自己登记的所有房间
+    void unregisterEndpoint(const QString& endpoint);
+    // 未登记时返回空字符串
+    QString ownerOf(const QString& roomId) const;
+
+private:
+    QJsonObject load() const;
+    bool save(const QJsonObject& rooms) const;
+
+    QString path;
+};
+
+#endif // ROOMREGISTRY_H
@@ -1,1046 +1,1723 @@
-#include "servercontroller.h"
-#include <QTcpSocket>
-#include <QDataStream>
-#include <QThread>
-#include <QDebug>
-#include <QVariant>
-#include <QThreadPool>
-
-ServerController::ServerController(QObject *parent) : QObject(parent),gameHasEnded(false)
-{
-    qRegisterMetaType<QMap<int, QList<int>>>("QMap<int,QList<int>>");
-    qRegisterMetaType<GameState>("GameState");
-
-    qDebug() << "ServerController created in thread" << QThread::currentThreadId();
-}
-
-ServerController::~ServerController()
-{
-    qDebug() << "ServerController shutting down...";
-    fflush(stdout);
-    // Ensure all client handlers are deleted before clients map is cleared.
-    // qDeleteAll will call destructors.
-    qDeleteAll(clients.values()); // Pass the values (ClientHandler*) to qDeleteAll
-    clients.clear();
-}
-
-void ServerController::setDesiredPlayers(int desiredPlayers)
-{
-    QMutexLocker lock(&gameLogicMutex);
-    this->desiredPlayers = desiredPlayers;
-    qDebug() << "ServerController::setDesiredPlayers - Attempting to init model for" << desiredPlayers << "players.";
-    fflush(stdout);
-    model.initGame(desiredPlayers);
-    qInfo() << "Server desired players set to:" << desiredPlayers;
-    fflush(stdout);
-}
-
-// 客户端管理
-void ServerController::addClient(QTcpSocket* clientSocket, int clientId)
-{
-    qDebug() << "ServerController::addClient for client" << clientId << "in thread" << QThread::currentThreadId();
-    fflush(stdout);
-
-    ClientHandler* handler = nullptr;
-    QString newClientColor;
-    int currentClientCount = 0;
-    int currentDesiredPlayers = 0; // Local copy to use outside lock
-
-    { // Scope for QMutexLocker to ensure it's released before calling other locking functions
-        QMutexLocker locker(&clientsMutex);
-        currentDesiredPlayers = this->desiredPlayers; // Copy within lock
-
-        if(currentDesiredPlayers > 0 && clients.size() >= currentDesiredPlayers){
-            qWarning() << "Server is full. Rejecting new client connection for ID" << clientId;
-            fflush(stdout);
-            // Locker unlocks automatically
-            clientSocket->disconnectFromHost();
-            clientSocket->deleteLater();
-            return;
-        }
-
-        handler = new ClientHandler(clientSocket, clientId, this);
-        handler->setParent(this);
-
-        connect(handler, &ClientHandler::parsedMessage, this, &ServerController::handleClientAction);
-        connect(handler, &ClientHandler::clientDisconnected, this, &ServerController::removeClientSlot);
-
-        clients.insert(clientId, handler);
-        newClientColor = getPlayerColor(clientId);
-        playerColors[clientId] = newClientColor;
-        currentClientCount = clients.size();
-
-        qDebug() << "ServerController::addClient - Client" << clientId << "added to map. Map size:" << currentClientCount;
-        fflush(stdout);
-        // Mutex is released here when 'locker' goes out of scope
-    }
-
-    // Operations after releasing clientsMutex
-    if (handler) {
-        qInfo() << "Client" << clientId << "(" << newClientColor << ") connected. Total clients:" << currentClientCount;
-        fflush(stdout);
-
-        // broadcastMessage will acquire its own lock on clientsMutex
-        broadcastMessage(QString("玩家 %1 (%2) 加入了游戏. (%3/%4)")
-                             .arg(clientId).arg(newClientColor).arg(currentClientCount).arg(currentDesiredPlayers));
-
-        // handler->sendMessage does not lock clientsMutex itself
-        handler->sendMessage(QString("WELCOME:Connected as player %1 (%2). Waiting for game to start...")
-                                 .arg(clientId).arg(newClientColor));
-    } else {
-        qWarning() << "ServerController::addClient - Handler was not created for client" << clientId << "(should have been rejected if server full)";
-        fflush(stdout);
-    }
-}
-
-void ServerController::removeClientSlot(int clientId)
-{
-    qDebug() << "ServerController::removeClientSlot - Attempting to remove client" << clientId;
-    fflush(stdout);
-    QMutexLocker locker(&clientsMutex);
-    qDebug() << "ServerController::removeClientSlot - Mutex acquired for client" << clientId;
-    fflush(stdout);
-
-    if (clients.contains(clientId)) {
-        ClientHandler* handler = clients.take(clientId);
-        qDebug() << "ServerController::removeClientSlot - Client" << clientId << "taken from map. Handler ptr:" << handler;
-        fflush(stdout);
-
-        if (handler) {
-            // Disconnect signals to prevent further interaction with a dying object
-            disconnect(handler, &ClientHandler::parsedMessage, this, &ServerController::handleClientAction);
-            disconnect(handler, &ClientHandler::clientDisconnected, this, &ServerController::removeClientSlot);
-            delete handler; // Deletes the handler
-            qDebug() << "ServerController::removeClientSlot - ClientHandler for" << clientId << "deleted.";
-            fflush(stdout);
-        } else {
-            qWarning() << "ServerController::removeClientSlot - Handler for client" << clientId << "was null in map!";
-            fflush(stdout);
-        }
-
-        QString color = playerColors.take(clientId);
-        qInfo() << "Client" << clientId << "(" << color << ") disconnected and removed. Total clients:" << clients.size();
-
-        gameLogicMutex.lock();
-        if (playerReadyStatus.remove(clientId)) {
-            readyPlayers--;
-        }
-
-        if (clients.isEmpty() && (readyPlayers > 0 || currentPlayerId != 0)) {
-            qInfo() << "Last player disconnected. Resetting game.";
-            readyPlayers = 0;
-            currentPlayerId = 0;
-            playerReadyStatus.clear();
-            model.initGame(desiredPlayers); // Or some other reset logic
-        } else if (!clients.isEmpty() && currentPlayerId != 0) { // Game in progress
-            broadcastMessage(QString("玩家 %1 (%2) 离开了游戏.").arg(clientId).arg(color));
-            if (clientId == currentPlayerId) {
-                gameLogicMutex.unlock();
-                nextTurn();
-                return;
-            }
-        } else if (!clients.isEmpty() && readyPlayers < desiredPlayers) { // In ready phase
-            broadcastMessage(QString("玩家 %1 (%2) 离开了. 等待 %3 位玩家.")
-                                 .arg(clientId)
-                                 .arg(color)
-                                 .arg(desiredPlayers - clients.size()));
-        }
-        gameLogicMutex.unlock();
-    }
-    else {
-        qWarning() << "ServerController::removeClientSlot - Client" << clientId << "not found in map.";
-        fflush(stdout);
-    }
-    qDebug() << "ServerController::removeClientSlot - Exiting for client" << clientId;
-    fflush(stdout);
-}
-
-void ServerController::sendToClient(int clientId, const QString &messageType, const QVariant &payload1, const QVariant &payload2)
-{
-    //QMutexLocker locker(&clientsMutex);
-    if (clients.contains(clientId)) {
-        ClientHandler* handler = clients.value(clientId);
-        if(handler) {
-            qDebug() << "ServerController: Sending message" << messageType << "to client" << clientId;
-            handler->sendTypedMessage(messageType, payload1, payload2);
-        } else {
-            qWarning() << "ServerController: Attempted to send message to null handler for client" << clientId;
-        }
-    } else {
-        qWarning() << "ServerController: Client" << clientId << "not found for sending message" << messageType;
-    }
-}
-
-QString ServerController::getPlayerColor(int clientId)
-{
-    switch(clientId) {
-    case 1: return "黄";
-    case 2: return "蓝";
-    case 3: return "绿";
-    case 4: return "红";
-    default: return "未知";
-    }
-}
-
-// ClientHandler 实现
-ClientHandler::ClientHandler(QTcpSocket* clientSock, int cId, ServerController *ctrl, QObject* parent)
-    : QObject(parent),
-    clientId(cId),
-    controller(ctrl),
-    socket(clientSock),
-    inStream(nullptr),
-    expectedBytes(0)
-{
-    qDebug() << "ClientHandler for client" << clientId << "created in thread" << QThread::currentThreadId();
-    if (socket) {
-        socket->setParent(this);
-        inStream = new QDataStream(socket);
-        inStream->setVersion(QDataStream::Qt_6_5);
-
-        connect(socket, &QTcpSocket::readyRead, this, &ClientHandler::readData);
-        connect(socket, &QTcpSocket::disconnected, this, &ClientHandler::handleDisconnected);
-    } else {
-        qCritical() << "ClientHandler for client" << clientId << "received a null socket!";
-    }
-}
-ClientHandler::~ClientHandler()
-{
-    qDebug() << "ClientHandler for client" << clientId << "destroying...";
-    fflush(stdout);
-    // Socket is parented, will be deleted.
-    // QDataStream should be deleted if new'd.
-    delete inStream; // Delete the QDataStream object
-    inStream = nullptr;
-    qDebug() << "ClientHandler for client" << clientId << "destroyed.";
-    fflush(stdout);
-}
-
-void ClientHandler::sendTypedMessage(const QString &messageType, const QVariant &payload1, const QVariant &payload2)
-{
-    if (!socket || socket->state() != QTcpSocket::ConnectedState) {
-        qWarning() << "Client" << clientId << ": Socket not connected. Cannot send" << messageType;
-        return;
-    }
-
-    qDebug() << "ClientHandler" << clientId << ": Preparing to send" << messageType << ". Payload1 valid:" << payload1.isValid() << "UserType:" << payload1.userType() << payload1.typeName() << "Payload2 valid:" << payload2.isValid();
-    fflush(stdout);
-
-    QByteArray block;
-    QDataStream out(&block, QIODevice::WriteOnly);
-    out.setVersion(QDataStream::Qt_6_5);
-
-
-    if (messageType == "GAME_STATE_MSG" && payload1.isValid()) {
-        qDebug() << "ClientHandler" << clientId << ": GAME_STATE_MSG payload typeName:" << payload1.typeName() << "userType:" << payload1.userType();
-        if (!payload1.canConvert<GameState>()) {
-            qWarning() << "ClientHandler" << clientId << ": FATAL - GAME_STATE_MSG payload QVariant CANNOT be converted to GameState! Check Q_DECLARE_METATYPE and qRegisterMetaType.";
-            return; // Don't attempt to send if conversion is impossible
-        } else {
-            // Test actual conversion and access
-            GameState tempStateForTest = payload1.value<GameState>();
-            qDebug() << "ClientHandler" << clientId << ": GAME_STATE_MSG payload QVariant successfully TEST-converted to GameState. Tile count:" << tempStateForTest.getTileStates().size();
-        }
-    }
-
-    out << quint32(0);
-    out << messageType;
-    if (out.status() != QDataStream::Ok) {
-        qWarning() << "ClientHandler" << clientId << ": QDataStream error after writing messageType for" << messageType << "Status:" << out.status();
-        socket->reset(); return;
-    }
-
-
-    if (payload1.isValid()) {
-        qDebug() << "ClientHandler" << clientId << ": Attempting to write payload1 for" << messageType;
-        out << payload1; // Serialize QVariant
-        if (out.status() != QDataStream::Ok) {
-            qWarning() << "ClientHandler" << clientId << ": QDataStream error after writing payload1 for" << messageType << "Status:" << out.status();
-            socket->reset();
-            return;
-        }
-        qDebug() << "ClientHandler" << clientId << ": Successfully wrote payload1 for" << messageType;
-    }
-
-    if (payload2.isValid()) {
-        qDebug() << "ClientHandler" << clientId << ": Attempting to write payload2 for" << messageType;
-        out << payload2;
-        if (out.status() != QDataStream::Ok) {
-            qWarning() << "ClientHandler" << clientId << ": QDataStream error after writing payload2 for" << messageType << "Status:" << out.status();
-            socket->reset();
-            return;
-        }
-        qDebug() << "ClientHandler" << clientId << ": Successfully wrote payload2 for" << messageType;
-    }
-
-    out.device()->seek(0);
-    out << quint32(block.size() - sizeof(quint32)); // Write actual size
-
-    qDebug() << "ClientHandler" << clientId << ": Final block size for" << messageType << "is" << block.size();
-    fflush(stdout);
-
-    qDebug() << "ClientHandler" << clientId << ": Attempting socket->write() for" << messageType << "block size:" << block.size();
-    fflush(stdout);
-
-    qint64 written = socket->write(block);
-    if (written == -1) {
-        qWarning() << "ClientHandler" << clientId << "socket->write() failed for" << messageType << ". Error:" << socket->errorString();
-        fflush(stdout);
-    } else if (written < block.size()) {
-        qWarning() << "ClientHandler" << clientId << "failed to write complete message for" << messageType << ". Wrote" << written << "of" << block.size() << "Error:" << socket->errorString();
-        fflush(stdout);
-    } else {
-        bool flushed = socket->flush();
-        qDebug() << "ClientHandler: Server sent [" << messageType << "] to client" << clientId << "size:" << block.size() << "(flushed:" << flushed << ")";
-        fflush(stdout);
-    }
-}
-
-void ClientHandler::sendMessage(const QString &message)
-{
-    sendTypedMessage("TEXT_MSG", QVariant(message));
-}
-
-void ClientHandler::sendGameState(const GameState& gameState)
-{
-    qCritical() << "ClientHandler" << getClientId() << ": sendGameState - ENTERED. GameState tile count:" << gameState.getTileStates().size();
-    fflush(stdout);
-
-    QVariant gameStateVariant;
-    qCritical() << "ClientHandler" << getClientId() << ": sendGameState - Attempting QVariant::fromValue(gameState)...";
-    fflush(stdout);
-
-    gameStateVariant = QVariant::fromValue(gameState);
-
-    if (!gameStateVariant.isValid()) {
-        qWarning() << "ClientHandler" << getClientId() << ": sendGameState - FAILED to create a valid QVariant from GameState! TypeName after attempt:" << gameStateVariant.typeName();
-        fflush(stdout);
-        return;
-    }
-
-    qCritical() << "ClientHandler" << getClientId() << ": sendGameState - QVariant CREATED successfully. TypeName:" << gameStateVariant.typeName() << "UserType:" << gameStateVariant.userType();
-    fflush(stdout);
-
-    sendTypedMessage("GAME_STATE_MSG", gameStateVariant);
-
-    qCritical() << "ClientHandler" << getClientId() << ": sendGameState - EXITED (called sendTypedMessage).";
-    fflush(stdout);
-}
-
-int ClientHandler::getClientId()
-{
-    return clientId;
-}
-
-void ClientHandler::readData()
-{
-    if (!socket || !inStream) return;
-    inStream->setVersion(QDataStream::Qt_6_5);
-
-    forever{
-        if (expectedBytes == 0) {
-            if (socket->bytesAvailable() < sizeof(quint32)) {
-                return;
-            }
-            *inStream >> expectedBytes;
-            //qDebug() << "Server: Client" << clientId << "expecting" << expectedBytes << "bytes for next message.";
-        }
-        if (socket->bytesAvailable() < expectedBytes) {
-            //qDebug() << "Server: Client" << clientId << "not enough data yet. Have" << socket->bytesAvailable() << "need" << expectedBytes;
-            return;
-        }
-
-        QString messageType;
-        *inStream >> messageType;
-
-        if (inStream->status() != QDataStream::Ok) {
-            qWarning() << "Server: Client" << clientId << "stream error reading messageType.";
-            socket->abort();
-            expectedBytes = 0;
-            return;
-        }
-        //qDebug() << "Server: Client" << clientId << "received message type:" << messageType;
-
-        QVariant payload1, payload2;
-
-        if (messageType == "READY_MSG") {
-            // No payload
-        }
-        else if (messageType == "PLANE_OP_MSG") {
-            *inStream >> payload1 >> payload2; // Read as QVariants
-            if (inStream->status() != QDataStream::Ok) {
-                qWarning() << "Server: Client" << clientId << "stream error reading PLANE_OP_MSG payload.";
-                socket->abort();
-                expectedBytes = 0;
-                return;
-            }
-        }
-        else if (messageType == "FLY_OVER_MSG") {
-            *inStream >> payload1;
-            if (inStream->status() != QDataStream::Ok) {
-                qWarning() << "Server: Client" << clientId << "stream error reading FLY_OVER_MSG payload.";
-                socket->abort();
-                expectedBytes = 0;
-                return;
-            }
-        }
-        else {
-            qWarning() << "Server: Client" << clientId << "received unknown message type:" << messageType;
-            QByteArray dummyLoad;
-            dummyLoad.resize(expectedBytes - (sizeof(quint32) + messageType.toUtf8().size())); // Approximate
-            if (socket->bytesAvailable() >= dummyLoad.size()) {
-                inStream->readRawData(dummyLoad.data(), dummyLoad.size());
-                qDebug() << "Server: Discarded approx" << dummyLoad.size() << "bytes of unknown payload from client" << clientId;
-            } else {
-                qWarning() << "Server: Not enough data to fully discard unknown payload from client" << clientId << ". Stream may be corrupted.";
-                socket->abort();
-            }
-            expectedBytes = 0;
-            return;
-        }
-        emit parsedMessage(clientId, messageType, payload1, payload2);
-        expectedBytes = 0;
-
-        if (inStream->status() != QDataStream::Ok && socket->state() == QAbstractSocket::ConnectedState) {
-            qWarning() << "Server: Client" << clientId << "QDataStream status not OK after processing message. Aborting.";
-            socket->abort();
-            return;
-        }
-        if (socket->bytesAvailable() == 0) break;
-    }
-
-}
-
-void ClientHandler::handleDisconnected()
-{
-    qInfo() << "Client" << clientId << "socket disconnected signal received by ClientHandler.";
-    emit clientDisconnected(clientId);
-}
-
-QString ClientHandler::getPlayerColor(int cId)
-{
-    switch(cId) {
-    case 1: return "黄";
-    case 2: return "蓝";
-    case 3: return "绿";
-    case 4: return "红";
-    default: return "未知";
-    }
-}
-
-// 游戏逻辑处理
-void ServerController::handleClientAction(int clientId, const QString &messageType, const QVariant &payload1, const QVariant &payload2)
-{
-    QMutexLocker locker(&gameLogicMutex); // Protect game logic and state
-    qDebug() << "Server received action from client" << clientId << "(" << getPlayerColor(clientId) << "):" << messageType;
-    fflush(stdout);
-
-    if (this->gameHasEnded) {
-        if (messageType != "READY_MSG") {
-            sendToClient(clientId, "TEXT_MSG", QVariant("游戏已结束."));
-            qDebug() << "Game has ended. Action" << messageType << "from client" << clientId << "ignored.";
-            return;
-        }
-    }
-    if (messageType == "READY_MSG") {
-        if (!playerReadyStatus.value(clientId, false)) {
-            playerReadyStatus[clientId] = true;
-            readyPlayers++;
-            QString msg = QString("玩家 %1 (%2) 已准备. (%3/%4)")
-                              .arg(clientId).arg(getPlayerColor(clientId))
-                              .arg(readyPlayers).arg(desiredPlayers);
-            broadcastMessage(msg);
-            qInfo() << msg;
-
-            if (readyPlayers == desiredPlayers && desiredPlayers > 0) { // Check clients.size() as well?
-                QMutexLocker clientListLocker(&clientsMutex);
-                if (clients.size() == desiredPlayers) {
-                    initGameAndStart();
-                } else {
-                    broadcastMessage(QString("所有已连接玩家已准备，但等待 %1 位玩家加入...")
-                                         .arg(desiredPlayers - clients.size()));
-                }
-            } else if (clients.size() < desiredPlayers) {
-                QMutexLocker clientListLocker(&clientsMutex); // Accessing clients.size()
-                broadcastMessage(QString("等待其他 %1 位玩家加入...").arg(desiredPlayers - clients.size()));
-            }
-        } else {
-            qDebug() << "Player" << clientId << "sent READY_MSG again.";
-        }
-        return;
-    }
-
-    if (readyPlayers < desiredPlayers || currentPlayerId == 0) {
-        sendToClient(clientId, "TEXT_MSG", "ERROR:游戏尚未开始或未集齐玩家.");
-        return;
-    }
-    if (clientId != currentPlayerId) {
-        sendToClient(clientId, "TEXT_MSG", "ERROR:不是你的回合!");
-        return;
-    }
-
-    try {
-        if (messageType == "PLANE_OP_MSG") {
-            bool diceOk, planeIdOk;
-            int dice = payload1.toInt(&diceOk);
-            int planeId = payload2.toInt(&planeIdOk);
-
-            if (!diceOk || !planeIdOk) {
-                qWarning() << "Server: Invalid payload for PLANE_OP_MSG from client" << clientId;
-                sendToClient(clientId, "TEXT_MSG", QVariant("ERROR:无效的飞机操作参数."));
-                return;
-            }
-            qInfo() << "玩家" << getPlayerColor(clientId) << "选择了飞机" << planeId << "，骰子点数" << dice;
-
-            QMap<int, QList<int>> currentTileStates = model.getBoardState();
-
-            int result = do_plan_OP(clientId,dice,planeId,currentTileStates);
-            lastDice = dice;
-            lastPlaneId = planeId;
-
-            model.setBoardState(currentTileStates);
-            GameState gameStateToBroadcast(currentTileStates);
-            broadcastGameState(gameStateToBroadcast);
-
-            if(result == 1){
-                sendToClient(clientId, "TEXT_MSG", QVariant("YOUR_TURN_CHOOSE_FLY"));
-            }
-            else{
-                check_is_win(gameStateToBroadcast);
-                nextTurn();
-            }
-        }
-        else if (messageType == "FLY_OVER_MSG") {
-            bool flyYes = payload1.toBool();
-            QString choiceStr = flyYes ? "YES" : "NO";
-            qInfo() << "玩家" <<clientId << "选择飞跃？"<< choiceStr;
-
-            QMap<int, QList<int>> currentTileStates = model.getBoardState();
-
-            do_fly(lastPlaneId, clientId, choiceStr, currentTileStates);
-
-            model.setBoardState(currentTileStates);
-            GameState gameStateToBroadcast(currentTileStates); // Create with the final currentTileStates
-            broadcastGameState(gameStateToBroadcast);
-            check_is_win(gameStateToBroadcast);
-            nextTurn();
-        }
-        else {
-            qWarning() << "Client" << clientId << "sent unknown or unhandled message type:" << messageType;
-            sendToClient(clientId, "TEXT_MSG", QVariant(QString("ERROR:未知操作! %1").arg(messageType)));
-        }
-    } catch (const std::exception& e) {
-        qCritical() << "Exception during client action:" << e.what();
-        sendToClient(clientId, "TEXT_MSG", QVariant(QString("ERROR:处理操作时发生错误: %1").arg(e.what())));
-    } catch (...) {
-        qCritical() << "Unknown exception during client action for client" << clientId;
-        sendToClient(clientId, "TEXT_MSG", QVariant("ERROR:处理操作时发生未知错误."));
-    }
-}
-
-void ServerController::broadcastMessage(const QString &msg)
-{
-    //QMutexLocker locker(&clientsMutex);
-    qDebug() << "Server broadcasting TEXT_MSG:" << msg;
-    for(ClientHandler* handler : qAsConst(clients)){
-        if (handler) {
-            handler->sendMessage(msg);
-        }
-    }
-}
-
-void ServerController::broadcastGameState(const GameState& state)
-{
-    qCritical() << "[BGS_ENTER] broadcastGameState - ENTERED.";
-    fflush(stdout);
-
-    qCritical() << "[BGS_TEST_THIS] 'this->desiredPlayers' (pre-access):" << this->desiredPlayers;
-    fflush(stdout);
-
-    qCritical() << "[BGS_TEST_STATE_PARAM] 'state.getTileStates().size()' (pre-access):" << state.getTileStates().size();
-    fflush(stdout);
-
-    qCritical() << "[BGS_TEST_CLIENTS_SIZE] 'clients.size()' (pre-access):" << this->clients.size();
-    fflush(stdout);
-
-    qCritical() << "[BGS_BEFORE_LOCKER_ATTEMPT] All initial accesses OK. About to TRY to lock clientsMutex.";
-    fflush(stdout);
-
-    try {
-        qCritical() << "[BGS_TRY_LOCK] Attempting QMutexLocker locker(&clientsMutex)...";
-        fflush(stdout);
-        //QMutexLocker locker(&clientsMutex); // This is the critical point
-        qCritical() << "[BGS_LOCKER_ACQUIRED] clientsMutex Acquired by QMutexLocker. Client map size (again):" << this->clients.size();
-        fflush(stdout);
-
-        if (clients.isEmpty()) {
-            qWarning() << "[BGS_WARN] No clients to broadcast GameState to!"; fflush(stdout);
-            // Locker releases when function returns
-            return;
-        }
-
-        qDebug() << "[BGS_INFO] Broadcasting GameState object. Actual state tile count:" << state.getTileStates().size(); fflush(stdout);
-        int handler_count = 0;
-        for (ClientHandler* handler : clients.values()) {
-            handler_count++;
-            if (handler) {
-                qCritical() << "[BGS_LOOP] Loop" << handler_count << ": PREP to call sendGameState for client" << handler->getClientId(); fflush(stdout);
-                handler->sendGameState(state);
-                qCritical() << "[BGS_LOOP] Loop" << handler_count << ": RET from sendGameState for client" << handler->getClientId(); fflush(stdout);
-            } else {
-                qWarning() << "[BGS_WARN_LOOP] Loop" << handler_count << ": Found null handler."; fflush(stdout);
-            }
-        }
-
-        qCritical() << "[BGS_LOOP_FINISHED] Loop finished. QMutexLocker will release."; fflush(stdout);
-
-    } catch (const std::exception& e) {
-        qCritical() << "[BGS_EXCEPTION_LOCK_OR_LOOP] std::exception caught: " << e.what();
-        fflush(stdout);
-    } catch (...) {
-        qCritical() << "[BGS_EXCEPTION_LOCK_OR_LOOP] Unknown exception caught around mutex lock or loop.";
-        fflush(stdout);
-    }
-
-    qCritical() << "[BGS_EXIT] broadcastGameState EXITED.";
-    fflush(stdout);
-}
-
-void ServerController::initGameAndStart()
-{
-    qInfo() << "所有玩家已准备，初始化游戏..."; // This is the last log seen from server
-
-    qDebug() << "[Debug] initGameAndStart: Step 1 - Initializing model.initGame(" << desiredPlayers << ")";
-    model.initGame(desiredPlayers);
-    qDebug() << "[Debug] initGameAndStart: Step 2 - Model initialized.";
-
-    currentPlayerId = 1; // Start with player 1
-    qDebug() << "[Debug] initGameAndStart: Step 3 - CurrentPlayerId set to" << currentPlayerId;
-
-    qDebug() << "[Debug] initGameAndStart: Step 4 - Attempting to get board state from model.";
-    GameState initialState(model.getBoardState());
-    qDebug() << "[Debug] initGameAndStart: Step 5 - Initial GameState created. Tile count (example):" << initialState.getTileStates().size();
-
-    qDebug() << "[Debug] initGameAndStart: Step 6 - Broadcasting initial game state.";
-    broadcastGameState(initialState);
-    qDebug() << "[Debug] initGameAndStart: Step 7 - Initial game state broadcasted.";
-
-    QString gameStartMsg = QString("游戏开始! 轮到玩家 %1 (%2).")
-                               .arg(currentPlayerId).arg(getPlayerColor(currentPlayerId));
-    qDebug() << "[Debug] initGameAndStart: Step 8 - Broadcasting game start message:" << gameStartMsg;
-    broadcastMessage(gameStartMsg);
-    qDebug() << "[Debug] initGameAndStart: Step 9 - Game start message broadcasted.";
-
-    QString turnMsg = "YOUR_TURN_ROLL_AND_CHOOSE_PLANE";
-    qDebug() << "[Debug] initGameAndStart: Step 10 - Sending turn message to player" << currentPlayerId << ":" << turnMsg;
-    sendToClient(currentPlayerId, "TEXT_MSG", QVariant(turnMsg));
-    qDebug() << "[Debug] initGameAndStart: Step 11 - Turn message sent. initGameAndStart complete.";
-}
-
-void ServerController::do_fly(int lastPlaneId, int currentPlayerId, const QString &choice, QMap<int, QList<int>>& tileStates)
-{
-    qDebug() << "[Debug] do_fly called for plane" << lastPlaneId << "client" << currentPlayerId << "choice" << choice;
-
-    if (choice.toUpper() != "YES") {
-        qDebug() << "Player" << currentPlayerId << "chose not to fly.";
-        // model.setBoardState(state.getTileStates()); // Ensure model is up-to-date if state was modified before this call
-        return;
-    }
-
-    //计算全局飞机编号
-    int globalPlaneId = (currentPlayerId - 1) * 4 + lastPlaneId;
-
-    if(tileStates.isEmpty()){
-        qWarning() << "tileStates 为空，无法执行飞跃操作";
-        return;
-    }
-
-    //找到该飞机当前所在的格子
-    int currentTile = findPlaneCurrentTile(globalPlaneId,tileStates);
-    if(currentTile == -1){
-        qWarning() << "未能找到飞机 globalPlaneId=" << globalPlaneId << "所在的格子";
-        return;
-    }
-
-    //从当前所在的格子移除该飞机
-    removePlaneFromTile(globalPlaneId ,currentTile ,tileStates);
-
-    //检查是否在特殊跳跃位置
-    int specialJumpTarget = getSpecialJumpTarget(currentPlayerId , currentTile);
-    if(specialJumpTarget != -1){
-        //执行特殊跳跃
-        addPlaneToTile(globalPlaneId,specialJumpTarget,tileStates);
-
-        //处理飞跃时是否发生碰撞
-        collisionDuringFly(currentPlayerId,tileStates);
-
-        //处理可能的碰撞
-        handleCollision(globalPlaneId,specialJumpTarget,tileStates);
-
-
-        return ;
-    }
-    qInfo() << "Player" << currentPlayerId << "plane" << globalPlaneId << "performs fly/4-step move from" << currentTile;
-    //执行常规飞跃
-    int steps = 4;
-    int currentPos = currentTile;
-    for(int i=0 ;i<steps; i++){
-        if(isExitRingPosition(currentPlayerId,currentPos)){
-            currentPos = getNextOnExitPath(currentPlayerId,currentPos);
-        }else{
-            currentPos = getNextPosition(currentPlayerId ,currentPos);
-        }
-    }
-
-    // 将飞机放到最终位置
-    addPlaneToTile(globalPlaneId ,currentPos,tileStates);
-
-    //处理撞机
-    handleCollision(globalPlaneId ,currentPos,tileStates);
-
-}
-
-void ServerController::check_is_win(GameState& state)
-{
-    qDebug() << "[Debug] check_is_win called.";
-    QMap<int, QList<int>> playerAirports = {
-        {1, {1, 2, 3, 4}},    // 黄
-        {2, {5, 6, 7, 8}},    // 蓝
-        {3, {9, 10, 11, 12}}, // 绿
-        {4, {13, 14, 15, 16}} // 红
-    };
-
-    for (auto it = playerAirports.begin(); it != playerAirports.end(); ++it) {
-        int playerId = it.key();
-        QList<int> airportTiles = it.value();
-
-        bool hasWon = true;
-        for (int tileId : airportTiles) {
-            QList<int> planes = state.getTileStates().value(tileId);
-            if (!planes.contains(100)) {
-                hasWon = false;
-                break;
-            }
-        }
-
-        if (hasWon) {
-            QString playerColor = getPlayerColor(playerId);
-            QString winMessage = QString("玩家 %1 已赢得游戏！").arg(playerColor);
-            broadcastMessage(winMessage);
-            qDebug() << winMessage;
-            return;
-        }
-    }
-}
-
-int ServerController::getSpecialJumpTarget(int clientId, int currentPos) {
-    switch (clientId) {
-    case 1: if (currentPos == 38) return 50; break; // Yellow
-    case 2: if (currentPos == 51) return 63; break; // Blue
-    case 3: if (currentPos == 25) return 37; break; // Green
-    case 4: if (currentPos == 64) return 24; break; // Red
-    }
-    return -1;
-}
-
-int ServerController::do_plan_OP(int clientId, int dice, int planeId,  QMap<int, QList<int>>& tileStates)
-{
-    qDebug() << "[Debug] do_plan_OP called for client" << clientId << "dice" << dice << "plane" << planeId;
-    //QMutexLocker locker(&clientsMutex);
-
-    const int globalPlaneId = (clientId - 1)*4 + planeId;
-    bool backwardFlag = false;
-
-    //QMap<int ,QList<int>> tileStates = state.getTileStates();
-    if(tileStates.isEmpty()){
-        qCritical() << "tileStates 为空，无法执行操作";
-        return 0;
-    }
-
-    //查找当前飞机位置
-    int currentTile = findPlaneCurrentTile(globalPlaneId,tileStates);
-    if(currentTile == -1){
-        qCritical() << "未能找到飞机 globalPlaneId=" << globalPlaneId;
-        return 0;
-    }
-
-    //机场处理逻辑
-    if(isInAirport(currentTile)){
-        if(dice == 5 || dice == 6){
-            removePlaneFromTile(globalPlaneId,currentTile,tileStates);
-            const int startTile = getStartTile(clientId);
-            addPlaneToTile(globalPlaneId,startTile,tileStates);
-            qInfo() << "Player" << clientId << "plane" << planeId << "takes off to tile" << startTile;
-            return 0;
-        }
-        else {
-            qInfo() << "Player" << clientId << "plane" << planeId << "is in airport but rolled" << dice << ". Cannot take off.";
-            sendToClient(clientId, "TEXT_MSG", QVariant("点数不足以起飞"));
-            return 0; // 不能起飞，操作无效或不完整
-        }
-    }
-
-    //移动逻辑
-    int steps = dice;
-    int currentPosition = currentTile;
-    while(steps-- >0){
-        QThread::msleep(200);
-
-        removePlaneFromTile(globalPlaneId,currentPosition,tileStates);
-        int nextPos = isExitRingPosition(clientId ,currentPosition)
-                    ? getNextOnExitPath(clientId,currentPosition)
-                          : getNextPosition(clientId,currentPosition);
-        if(backwardFlag) nextPos = currentPosition-1;
-
-        addPlaneToTile(globalPlaneId ,nextPos,tileStates);
-        //broadcastGameState(state);
-        currentPosition = nextPos;
-
-        GameState intermediateState(tileStates);
-        broadcastGameState(intermediateState);
-
-        //终点检测
-        if(isFinalEnd(clientId , currentPosition)){
-            if(steps > 0){
-                backwardFlag = true;
-            }else{
-                removePlaneFromTile(globalPlaneId,currentPosition,tileStates);
-                const int airporTile = getAirportTile(clientId ,planeId);
-                addPlaneToTile(100+globalPlaneId,airporTile,tileStates);
-                //broadcastGameState(state);
-            }
-        }
-    }
-    //model.setBoardState(tileStates);
-    //state.setTileStates(tileStates);
-
-    //碰撞处理
-    handleCollision(globalPlaneId ,currentPosition,tileStates);
-
-    return isTileColorMatchesClient(clientId , currentPosition)
-                   && !isExitRingPosition(clientId , currentPosition) ? 1 : 0;
-
-}
-
-int ServerController::findPlaneCurrentTile(int globalPlaneId, QMap<int, QList<int> > &tileStates)
-{
-    for(auto it = tileStates.begin();it != tileStates.end();it++){
-        if(it.value().contains(globalPlaneId)){
-            return it.key();
-        }
-    }
-    qWarning() << "findPlaneCurrentTile: Plane" << globalPlaneId << "not found on any tile.";
-    return -1;
-}
-
-void ServerController::removePlaneFromTile(int planeId, int tileId, QMap<int, QList<int> > &tileStates)
-{
-    if(!tileStates.contains(tileId)) {
-        qWarning() << "removePlaneFromTile: Tile" << tileId << "not found in board state.";
-        return;
-    }
-    bool removed = tileStates[tileId].removeAll(planeId);
-    if (!removed) {
-        qWarning() << "removePlaneFromTile: Plane" << planeId << "was not found on tile" << tileId << "to remove.";
-    }
-}
-
-void ServerController::addPlaneToTile(int planeId, int tileId, QMap<int, QList<int> > &tileStates)
-{
-    if (!tileStates.contains(tileId)) {
-        qWarning() << "addPlaneToTile: Attempting to add plane" << planeId << "to non-existent tile" << tileId << ". Creating tile entry.";
-    }
-    tileStates[tileId].append(planeId);
-}
-
-bool ServerController::isInAirport(int tileId)
-{
-    return tileId >= 1 && tileId <= 16;
-}
-
-int ServerController::getStartTile(int clientId)
-{
-    switch(clientId) {
-    case 1: return 17;
-    case 2: return 18;
-    case 3: return 20;
-    case 4: return 19;
-    default: throw std::invalid_argument("无效的clientId");
-    }
-}
-
-int ServerController::getAirportTile(int clientId, int planeId)
-{
-    return (clientId - 1) * 4 + planeId;
-}
-
-int ServerController::getNextPosition(int clientId, int currentPos)
-{
-    const int RING_START = 21;
-    const int RING_END = 72;
-
-    if (currentPos >= RING_START && currentPos < RING_END)
-        return currentPos + 1;
-    if (currentPos == RING_END)
-        return RING_START;
-
-    // 起点特殊处理
-    switch(clientId) {
-    case 1: return (currentPos == 17) ? 21 : currentPos+1;
-    case 2: return (currentPos == 18) ? 34 : currentPos+1;
-    case 3: return (currentPos == 20) ? 60 : currentPos+1;
-    case 4: return (currentPos == 19) ? 47 : currentPos+1;
-    default: return currentPos+1;
-    }
-}
-
-bool ServerController::isExitRingPosition(int clientId, int pos)
-{
-    static QMap<int, int> exitPositions{{1,70}, {2,31}, {3,57}, {4,44}};
-    return pos == exitPositions.value(clientId, -1);
-}
-
-int ServerController::getNextOnExitPath(int clientId, int currentPos)
-{
-    static QMap<int, int> exitPaths{{1,73}, {2,79}, {3,91}, {4,85}};
-    return exitPaths.value(clientId, currentPos);
-}
-
-bool ServerController::isFinalEnd(int clientId, int pos)
-{
-    static QMap<int, int> endPositions{{1,78}, {2,84}, {3,96}, {4,90}};
-    return pos == endPositions.value(clientId, -1);
-}
-
-void ServerController::handleCollision(int selfPlaneId, int tileId, QMap<int, QList<int> > &tileStates)
-{
-    if (!tileStates.contains(tileId)) return;
-
-    QList<int> &planes = tileStates[tileId];
-    if(planes.size() <= 1)return ;
-
-    QList<int> toRemove;
-    foreach (int pid, planes) {
-        if(pid != selfPlaneId && !isSameColor(pid , selfPlaneId)){
-            toRemove.append(pid);
-        }
-    }
-    foreach (int pid, toRemove) {
-        planes.removeAll(pid);
-        const int otherClient = (pid - 1)/4 + 1;
-        const int otherPlane = (pid - 1)%4 + 1;
-        const int airportTile = getAirportTile(otherClient,otherPlane);
-        addPlaneToTile(pid ,airportTile,tileStates);
-    }
-}
-
-bool ServerController::isSameColor(int planeId1, int planeId2)
-{
-    return ((planeId1 - 1)/4) == ((planeId2 - 1)/4);
-}
-
-bool ServerController::isTileColorMatchesClient(int clientId, int tileId)
-{
-    if (tileId < 21 || tileId > 72) return false;
-    const int offset = (tileId - 21) % 4;
-    const QMap<int, int> colorMap{{0,3}, {1,1}, {2,2}, {3,4}};
-    return colorMap.value(offset, 0) == clientId;
-}
-
-void ServerController::collisionDuringFly(int clientId, QMap<int, QList<int> > &tileStates)
-{
-    static QMap<int, int> flyTiles{{1,87}, {2,93}, {3,81}, {4,75}};
-    const int tileId = flyTiles.value(clientId, 0);
-
-    QList<int> &planes = tileStates[tileId];
-    if (planes.size() <= 1) return;
-
-    QList<int> toRemove;
-    foreach (int pid, planes) {
-        if (pid != clientId && !isSameColor(pid, clientId)) {
-            toRemove.append(pid);
-        }
-    }
-
-    foreach (int pid, toRemove) {
-        planes.removeAll(pid);
-        const int otherClient = (pid - 1)/4 + 1;
-        const int otherPlane = (pid - 1)%4 + 1;
-        const int airportTile = getAirportTile(otherClient, otherPlane);
-        addPlaneToTile(pid, airportTile, tileStates);
-    }
-
-}
-
-void ServerController::nextTurn()
-{
-    qDebug() << "[Debug] nextTurn: Entered nextTurn method.";
-
-    if (clients.isEmpty()) {
-        qDebug() << "[Debug] nextTurn: No clients connected, resetting currentPlayerId and returning.";
-        currentPlayerId = 0;
-        return;
-    }
-
-    bool currentPlayerStillConnected = false;
-    {
-        QMutexLocker clientListLocker(&clientsMutex);
-        if(clients.contains(currentPlayerId)){
-            currentPlayerStillConnected = true;
-        }
-    }
-
-    qDebug() << "[Debug] nextTurn: Last dice roll was" << lastDice << ". Current player" << currentPlayerId << "is" << (currentPlayerStillConnected ? "connected." : "not connected.");
-
-    if(lastDice != 6 || !currentPlayerStillConnected){
-        qDebug() << "[Debug] nextTurn: Advancing to next player.";
-        QMutexLocker clientListLocker(&clientsMutex);
-        if (clients.isEmpty()) {
-            qDebug() << "[Debug] nextTurn: No clients connected after trying to advance. Resetting and returning.";
-            currentPlayerId = 0;
-            return;
-        }
-        int initialPlayerId = currentPlayerId;
-        if (desiredPlayers > 0) {
-            int attempts = 0;
-            do {
-                currentPlayerId = (currentPlayerId % desiredPlayers) + 1;
-                attempts++;
-                if (attempts > desiredPlayers + 1) {
-                    qWarning() << "[Debug] nextTurn: Could not find a connected next player after multiple attempts. Breaking loop.";
-                    currentPlayerId = 0;
-                    broadcastMessage("错误：无法找到有效的下一位玩家。");
-                    return;
-                }
-            } while (!clients.contains(currentPlayerId) && currentPlayerId != initialPlayerId);
-        } else {
-            qWarning() << "[Debug] nextTurn: desiredPlayers is 0, cannot advance turn.";
-            currentPlayerId = 0;
-            return;
-        }
-
-        if (!clients.contains(currentPlayerId)) {
-            qInfo() << "No valid next player found. Game might be over or waiting.";
-            currentPlayerId = 0;
-            broadcastMessage("没有有效的下一位玩家，游戏可能已结束或等待中。");
-            return;
-        }
-    }
-    qInfo() << "Next turn: Player" << currentPlayerId << "(" << getPlayerColor(currentPlayerId) << ")";
-
-    const QString currentColor = getPlayerColor(currentPlayerId);
-    qDebug() << "[Debug] nextTurn: Sending YOUR_TURN_ROLL_AND_CHOOSE_PLANE to player" << currentPlayerId;
-    sendToClient(currentPlayerId, "TEXT_MSG", QVariant("YOUR_TURN_ROLL_AND_CHOOSE_PLANE"));
-
-    qDebug() << "[Debug] nextTurn: Notifying other players about current turn.";
-    for(auto it = clients.begin();it !=clients.end();it++){
-        const int clientId = it.key();
-        if(clientId != currentPlayerId){
-            sendToClient(clientId, "TEXT_MSG", QVariant(QString("轮到玩家 %1 (%2) 操作").arg(currentPlayerId).arg(currentColor)));
-        }
-    }
-    qDebug() << "[Debug] nextTurn: nextTurn method complete.";
-}
-
-
-
-
+#include "servercontroller.h"
+#include <QTcpSocket>
+#include <QLocalSocket>
+#include <QDataStream>
+#include <QThread>
+#include <QDebug>
+#include <QVariant>
+#include <QThreadPool>
+#include <QRandomGenerator>
+#include <QWaitCondition>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QPointer>
+#include "handoff.h"
+
+// 单桌观众上限，超出后直接拒绝
+const int MAX_SPECTATORS = 4096;
+// 观众由房间自己编号，从这里开始，不会与座位号、AI 座位或大厅转交来的编号重合
+const int SPECTATOR_ID_BASE = 1 << 20;
+// 观众连接的写缓冲超过这个大小就视为跟不上，丢掉排队中的旧帧
+const qint64 SPECTATOR_BACKLOG_BYTES = 64 * 1024;
+// 没有新局面可替换时，队列最多攒这么多帧
+const int SPECTATOR_MAX_QUEUED = 64;
+// 单条连接的消息与字节配额（令牌桶）。超出时暂停读取，剩下的数据留在缓冲里，读缓冲满后由 TCP 反压
+const double CLIENT_FRAMES_PER_SEC = 20;
+const double CLIENT_FRAME_BURST = 40;
+const double CLIENT_BYTES_PER_SEC = 16 * 1024;
+const double CLIENT_BYTE_BURST = 32 * 1024;
+const qint64 CLIENT_READ_BUFFER_BYTES = 64 * 1024;
+// 客户端消息都很小，声明的长度超过这个值直接断开
+const quint32 MAX_CLIENT_FRAME_BYTES = 64 * 1024;
+// 持续超出配额、积压一直清不空这么久就断开
+const qint64 THROTTLE_EVICT_MS = 10000;
+// 心跳统计每隔这么多个周期打印一次
+const int HEARTBEAT_STATS_TICKS = 12;
+// 交接时每条连接最多等这么久，让半截消息收全、写缓冲发完
+const int HANDOFF_SETTLE_MS = 200;
+// 房间导出格式的版本，新旧进程不一致时拒绝恢复
+const qint32 ROOM_STATE_VERSION = 2;
+
+namespace {
+// 所有房间共用的搜索资源：置换表只与局面有关，可以跨房间复用；线程总数不随房间数增长
+struct SearchResources
+{
+    ExpectimaxSearch searcher;
+    QThreadPool pool;   // 后声明先析构：进程退出时先等搜索线程结束，置换表仍然有效
+};
+
+SearchResources& searchResources()
+{
+    static SearchResources resources;
+    return resources;
+}
+}
+
+struct ServerController::SearchTracker
+{
+    QMutex mutex;
+    QWaitCondition finished;
+    int running = 0;
+    bool closing = false;
+};
+
+ServerController::ServerController(QObject *parent) : QObject(parent),gameHasEnded(false),
+    searches(std::make_shared<SearchTracker>())
+{
+    qRegisterMetaType<QMap<int, QList<int>>>("QMap<int,QList<int>>");
+    qRegisterMetaType<GameState>("GameState");
+
+    //随本对象一起换线程，第一条网络连接接入时才启动
+    heartbeatTimer = new QTimer(this);
+    heartbeatTimer->setInterval(Heartbeat::INTERVAL_MS);
+    connect(heartbeatTimer, &QTimer::timeout, this, &ServerController::heartbeatTick);
+
+    qDebug() << "ServerController created in thread" << QThread::currentThreadId();
+}
+
+ServerController::~ServerController()
+{
+    qDebug() << "ServerController shutting down...";
+    fflush(stdout);
+    // 等待本房间还在进行的 AI 搜索结束，它们的结果会随本对象一起被丢弃；还在排队的不再执行
+    {
+        QMutexLocker locker(&searches->mutex);
+        searches->closing = true;
+        while (searches->running > 0) searches->finished.wait(&searches->mutex);
+    }
+    // Ensure all client handlers are deleted before clients map is cleared.
+    // qDeleteAll will call destructors.
+    qDeleteAll(clients.values()); // Pass the values (ClientHandler*) to qDeleteAll
+    clients.clear();
+    qDeleteAll(spectators.values());
+    spectators.clear();
+}
+
+void ServerController::setDesiredPlayers(int desiredPlayers)
+{
+    QMutexLocker lock(&gameLogicMutex);
+    this->desiredPlayers = desiredPlayers;
+    qDebug() << "ServerController::setDesiredPlayers - Attempting to init model for" << desiredPlayers << "players.";
+    fflush(stdout);
+    model.initGame(desiredPlayers);
+    qInfo() << "Server desired players set to:" << desiredPlayers;
+    fflush(stdout);
+}
+
+void ServerController::setClock(GameClock *c)
+{
+    clock = c ? c : GameClock::system();
+}
+
+void ServerController::setBotBudget(int ms)
+{
+    QMutexLocker lock(&gameLogicMutex);
+    botOptions.budgetMs = qMax(1, ms);
+    searchOptions.budgetMs = qMax(1, ms);
+    botOptions.threads = searchOptions.threads = QThread::idealThreadCount();
+    botOptions.playouts = searchOptions.nodes = 0;
+    seededBots = false;
+}
+
+void ServerController::setBotFixedWork(int playouts, int nodes, quint32 seed)
+{
+    //多线程时各线程分到的工作量取决于调度，只有单线程才能复现
+    QMutexLocker lock(&gameLogicMutex);
+    botOptions.playouts = qMax(1, playouts);
+    searchOptions.nodes = qMax(1, nodes);
+    botOptions.threads = searchOptions.threads = 1;
+    botRandom.seed(seed);
+    seededBots = true;
+}
+
+void ServerController::clearSearchCache()
+{
+    searchResources().searcher.clear();
+}
+
+void ServerController::setBotEngine(BotEngine engine)
+{
+    QMutexLocker lock(&gameLogicMutex);
+    botEngine = engine;
+}
+
+void ServerController::setRoomId(const QString &id)
+{
+    QMutexLocker lock(&gameLogicMutex);
+    roomId = id;
+}
+
+QString ServerController::getRoomId() const
+{
+    return roomId;
+}
+
+QByteArray ServerController::exportRoom(QList<int> *descriptors, QList<int> *kinds)
+{
+    //先把已经在路上的消息按正常流程处理完，局面在此之后才定下来
+    //等待期间断开的连接留在表里，导出时取不到描述符，在新进程中按离开处理
+    QList<ClientHandler*> handlers;
+    {
+        QMutexLocker clientListLocker(&clientsMutex);
+        for (ClientHandler* handler : std::as_const(clients)) handlers.append(handler);
+        for (ClientHandler* handler : std::as_const(spectators)) handlers.append(handler);
+    }
+    for (ClientHandler* handler : std::as_const(handlers)) {
+        disconnect(handler, &ClientHandler::clientDisconnected, this, &ServerController::removeClientSlot);
+    }
+    for (ClientHandler* handler : std::as_const(handlers)) {
+        if (!handler->settle(HANDOFF_SETTLE_MS)) {
+            qWarning() << "ServerController::exportRoom - client" << handler->getClientId()
+                       << "has a partial message, it will be lost.";
+        }
+    }
+
+    QMutexLocker lock(&gameLogicMutex);
+    QMutexLocker clientListLocker(&clientsMutex);
+    ++turnSerial; // 丢弃还在进行的 AI 搜索与提示
+
+    //每条连接记为 [编号, 描述符序号]，无法转交的序号为 -1
+    auto exportHandlers = [descriptors, kinds](const QMap<int, ClientHandler*>& handlers) {
+        QList<qint32> ids;
+        QList<qint32> indexes;
+        for (auto it = handlers.constBegin(); it != handlers.constEnd(); ++it) {
+            Handoff::SocketKind kind = Handoff::TcpSocket;
+            int fd = -1;
+            if (descriptors->size() < Handoff::MAX_DESCRIPTORS) {
+                fd = Handoff::duplicate(it.value()->getSocket(), &kind);
+            }
+            ids.append(it.key());
+            if (fd < 0) {
+                qInfo() << "ServerController::exportRoom - connection" << it.key() << "cannot be handed off.";
+                indexes.append(-1);
+                continue;
+            }
+            indexes.append(descriptors->size());
+            descriptors->append(fd);
+            kinds->append(kind);
+        }
+        return qMakePair(ids, indexes);
+    };
+    const auto seats = exportHandlers(clients);
+    const auto watchers = exportHandlers(spectators);
+
+    QByteArray state;
+    QDataStream out(&state, QIODevice::WriteOnly);
+    out.setVersion(Protocol::STREAM_VERSION);
+    out << ROOM_STATE_VERSION << roomId << qint32(desiredPlayers) << gameHasEnded << qint32(currentPlayerId)
+        << qint32(lastDice) << qint32(lastPlaneId) << playerReadyStatus << botSeats << model.getBoardState()
+        << seats.first << seats.second << watchers.first << watchers.second << seatTokens;
+
+    //原连接就地关闭，描述符副本使连接保持打开，不会向客户端发出 FIN
+    for (ClientHandler* handler : std::as_const(clients)) {
+        disconnect(handler, nullptr, this, nullptr);
+        delete handler;
+    }
+    for (ClientHandler* handler : std::as_const(spectators)) {
+        disconnect(handler, nullptr, this, nullptr);
+        delete handler;
+    }
+    clients.clear();
+    spectators.clear();
+    qInfo() << "Room" << roomId << "exported:" << seats.first.size() << "players," << watchers.first.size()
+            << "spectators," << descriptors->size() << "connections handed off.";
+    return state;
+}
+
+void ServerController::importRoom(const QByteArray &state, const QList<QIODevice*> &sockets)
+{
+    QDataStream in(state);
+    in.setVersion(Protocol::STREAM_VERSION);
+    qint32 version = 0;
+    QString id;
+    qint32 players = 0, current = 0, dice = 0, planeId = -1;
+    bool ended = false;
+    QMap<int, bool> readyStatus;
+    QSet<int> bots;
+    QMap<int, QList<int>> board;
+    QList<qint32> seatIds, seatSlots, watcherIds, watcherSlots;
+    QHash<QString, int> tokens;
+    in >> version;
+    if (version == ROOM_STATE_VERSION) {
+        in >> id >> players >> ended >> current >> dice >> planeId >> readyStatus >> bots >> board
+           >> seatIds >> seatSlots >> watcherIds >> watcherSlots >> tokens;
+    }
+    if (version != ROOM_STATE_VERSION || in.status() != QDataStream::Ok
+        || seatIds.size() != seatSlots.size() || watcherIds.size() != watcherSlots.size()) {
+        qWarning() << "ServerController::importRoom - invalid room state, version" << version;
+        for (QIODevice* socket : sockets) {
+            if (!socket) continue;
+            socket->close();
+            socket->deleteLater();
+        }
+        return;
+    }
+
+    QMutexLocker lock(&gameLogicMutex);
+    QList<int> lostSeats;
+    {
+        QMutexLocker clientListLocker(&clientsMutex);
+        roomId = id;
+        desiredPlayers = players;
+        gameHasEnded = ended;
+        currentPlayerId = current;
+        lastDice = dice;
+        lastPlaneId = planeId;
+        botSeats = bots;
+        seatTokens = tokens;
+        model.setBoardState(board);
+        for (int botId : std::as_const(botSeats)) playerColors[botId] = getPlayerColor(botId);
+
+        for (int i = 0; i < seatIds.size(); ++i) {
+            QIODevice* socket = sockets.value(seatSlots.at(i));
+            if (!socket) {
+                lostSeats.append(seatIds.at(i));
+                readyStatus.remove(seatIds.at(i));
+                continue;
+            }
+            clients.insert(seatIds.at(i), attachHandler(socket, seatIds.at(i)));
+            playerColors[seatIds.at(i)] = getPlayerColor(seatIds.at(i));
+        }
+        //观众编号只在房间内部使用，恢复时重新分配
+        for (int i = 0; i < watcherIds.size(); ++i) {
+            if (QIODevice* socket = sockets.value(watcherSlots.at(i))) {
+                const int spectatorId = SPECTATOR_ID_BASE + spectatorSerial++;
+                spectators.insert(spectatorId, attachHandler(socket, spectatorId));
+            }
+        }
+        playerReadyStatus = readyStatus;
+        readyPlayers = 0;
+        for (bool ready : std::as_const(playerReadyStatus)) {
+            if (ready) readyPlayers++;
+        }
+        closed = closeWhenEmpty && clients.isEmpty();
+    }
+    qInfo() << "Room" << roomId << "imported:" << clients.size() << "players," << spectators.size()
+            << "spectators, current player" << currentPlayerId << "lost seats" << lostSeats;
+
+    if (clients.isEmpty()) {
+        emit roomEmpty();
+        return;
+    }
+    if (currentPlayerId == 0 || gameHasEnded) return;
+    for (int seat : std::as_const(lostSeats)) {
+        broadcastEvent(ServerEvent::PlayerLeft, {seat});
+    }
+    //轮到的座位没能转交时直接换人；轮到 AI 时旧进程的搜索已经作废，重新掷骰
+    if (lostSeats.contains(currentPlayerId)) {
+        nextTurn();
+    } else if (botSeats.contains(currentPlayerId)) {
+        ++turnSerial;
+        scheduleBotTurn();
+    }
+}
+
+int ServerController::addBot()
+{
+    QMutexLocker locker(&gameLogicMutex);
+    int botId = -1;
+    int seated = 0;
+    {
+        QMutexLocker clientListLocker(&clientsMutex);
+        //从编号最大的座位开始占，真人玩家按连接顺序从 1 号开始分配
+        for (int seat = desiredPlayers; seat >= 1; --seat) {
+            if (!isSeatTaken(seat)) {
+                botId = seat;
+                break;
+            }
+        }
+        if (botId == -1) {
+            qWarning() << "ServerController::addBot - No free seat for an AI player.";
+            return -1;
+        }
+        botSeats.insert(botId);
+        playerColors[botId] = getPlayerColor(botId);
+        seated = clients.size() + botSeats.size();
+    }
+
+    //AI 总是处于准备状态
+    playerReadyStatus[botId] = true;
+    readyPlayers++;
+    qInfo() << "AI player" << botId << "(" << getPlayerColor(botId) << ") takes a seat.";
+    broadcastEvent(ServerEvent::BotJoined, {botId, seated, desiredPlayers});
+
+    if (readyPlayers == desiredPlayers && seated == desiredPlayers && currentPlayerId == 0) {
+        initGameAndStart();
+    }
+    return botId;
+}
+
+bool ServerController::isSeatTaken(int clientId) const
+{
+    return clients.contains(clientId) || botSeats.contains(clientId);
+}
+
+// 客户端管理
+void ServerController::addClient(QIODevice* clientSocket, int clientId)
+{
+    qDebug() << "ServerController::addClient for client" << clientId << "in thread" << QThread::currentThreadId();
+    fflush(stdout);
+
+    ClientHandler* handler = nullptr;
+    QString newClientColor;
+    QString seatToken;
+    int currentClientCount = 0;
+    int currentDesiredPlayers = 0; // Local copy to use outside lock
+    bool spectatorSeat = false;
+
+    { // Scope for QMutexLocker to ensure it's released before calling other locking functions
+        QMutexLocker locker(&clientsMutex);
+        currentDesiredPlayers = this->desiredPlayers; // Copy within lock
+
+        //编号不是空座位（座位已满、被占或是转交来的观众编号）的连接只能观战，观众另行编号
+        if((currentDesiredPlayers > 0 && clients.size() + botSeats.size() >= currentDesiredPlayers)
+            || isSeatTaken(clientId) || (currentDesiredPlayers > 0 && clientId > currentDesiredPlayers)){
+            qInfo() << "No free seat" << clientId << "- client joins as a spectator.";
+            fflush(stdout);
+            spectatorSeat = true;
+        } else {
+            handler = attachHandler(clientSocket, clientId);
+            clients.insert(clientId, handler);
+            newClientColor = getPlayerColor(clientId);
+            playerColors[clientId] = newClientColor;
+            currentClientCount = clients.size() + botSeats.size();
+            //每次入座换一个新凭据，这个座位以前的凭据作废
+            for (auto it = seatTokens.begin(); it != seatTokens.end();) {
+                it = it.value() == clientId ? seatTokens.erase(it) : std::next(it);
+            }
+            seatToken = QString::number(QRandomGenerator::system()->generate64(), 16);
+            seatTokens.insert(seatToken, clientId);
+
+            qDebug() << "ServerController::addClient - Client" << clientId << "added to map. Map size:" << currentClientCount;
+            fflush(stdout);
+        }
+        // Mutex is released here when 'locker' goes out of scope
+    }
+    if (spectatorSeat) {
+        addSpectator(clientSocket);
+        return;
+    }
+
+    // Operations after releasing clientsMutex
+    if (handler) {
+        qInfo() << "Client" << clientId << "(" << newClientColor << ") connected. Total clients:" << currentClientCount;
+        fflush(stdout);
+
+        broadcastEvent(ServerEvent::PlayerJoined, {clientId, currentClientCount, currentDesiredPlayers});
+
+        // handler->sendEvent does not lock clientsMutex itself
+        handler->sendEvent(ServerEvent::Welcome, {clientId, roomId, seatToken});
+
+        //游戏进行中入座只可能是凭座位凭据重连：照常参与轮转，并补发当前局面
+        GameState snapshot;
+        int turnPlayer = 0;
+        {
+            QMutexLocker lock(&gameLogicMutex);
+            turnPlayer = currentPlayerId;
+            if (turnPlayer != 0) {
+                snapshot.setTileStates(model.getBoardState());
+                if (!playerReadyStatus.value(clientId)) {
+                    playerReadyStatus[clientId] = true;
+                    readyPlayers++;
+                }
+            }
+        }
+        if (turnPlayer != 0) {
+            handler->sendGameState(snapshot);
+            handler->sendEvent(ServerEvent::TurnChanged, {turnPlayer});
+        }
+    } else {
+        qWarning() << "ServerController::addClient - Handler was not created for client" << clientId << "(should have been rejected if server full)";
+        fflush(stdout);
+    }
+}
+
+void ServerController::rejoinClient(QIODevice *clientSocket, const QString &seatToken, int fallbackClientId)
+{
+    int seat = 0;
+    {
+        QMutexLocker locker(&clientsMutex);
+        if (closed) {
+            //服务器已经在销毁本房间，客户端重连时会找不到房间，重新匹配
+            qInfo() << "Room" << roomId << "is closing, rejecting a rejoining connection.";
+            clientSocket->close();
+            clientSocket->deleteLater();
+            return;
+        }
+        if (!seatToken.isEmpty()) seat = seatTokens.value(seatToken, 0);
+    }
+    if (seat != 0) {
+        qInfo() << "Room" << roomId << ": seat" << seat << "reclaimed with its seat token.";
+    }
+    addClient(clientSocket, seat != 0 ? seat : fallbackClientId);
+}
+
+void ServerController::setCloseWhenEmpty(bool enabled)
+{
+    QMutexLocker locker(&clientsMutex);
+    closeWhenEmpty = enabled;
+}
+
+void ServerController::addSpectator(QIODevice *clientSocket)
+{
+    ClientHandler* handler = nullptr;
+    int seated = 0;
+    {
+        QMutexLocker locker(&clientsMutex);
+        if (spectators.size() >= MAX_SPECTATORS) {
+            qWarning() << "Spectator limit reached. Rejecting connection.";
+            fflush(stdout);
+            clientSocket->close();
+            clientSocket->deleteLater();
+            return;
+        }
+        //座位编号可能与 AI 座位重合，观众一律使用自己的编号段，操作才不会与 AI 的混淆
+        const int clientId = SPECTATOR_ID_BASE + spectatorSerial++;
+        //观众发来的操作一律拒绝，但仍要解析以便回复错误
+        handler = attachHandler(clientSocket, clientId);
+        spectators.insert(clientId, handler);
+        seated = clients.size() + botSeats.size();
+        qInfo() << "Spectator" << clientId << "connected. Total spectators:" << spectators.size();
+    }
+
+    //补发当前局面，之后的更新走观众队列
+    GameState snapshot;
+    int turnPlayer = 0;
+    {
+        QMutexLocker lock(&gameLogicMutex);
+        snapshot.setTileStates(model.getBoardState());
+        turnPlayer = currentPlayerId;
+    }
+    handler->sendEvent(ServerEvent::Spectating, {seated, desiredPlayers, roomId});
+    if (turnPlayer != 0) {
+        handler->sendGameState(snapshot);
+        handler->sendEvent(ServerEvent::TurnChanged, {turnPlayer});
+    }
+}
+
+ClientHandler *ServerController::attachHandler(QIODevice *clientSocket, int clientId)
+{
+    ClientHandler* handler = new ClientHandler(clientSocket, clientId, this);
+    handler->setParent(this);
+    connect(handler, &ClientHandler::parsedMessage, this, &ServerController::handleClientAction);
+    connect(handler, &ClientHandler::clientDisconnected, this, &ServerController::removeClientSlot);
+    if (handler->isNetworked() && !heartbeatTimer->isActive()) heartbeatTimer->start();
+    return handler;
+}
+
+void ServerController::heartbeatTick()
+{
+    QList<QPointer<ClientHandler>> handlers;
+    {
+        QMutexLocker clientListLocker(&clientsMutex);
+        for (ClientHandler* handler : std::as_const(clients)) handlers.append(handler);
+        for (ClientHandler* handler : std::as_const(spectators)) handlers.append(handler);
+    }
+    if (handlers.isEmpty()) {
+        heartbeatTimer->stop();
+        return;
+    }
+
+    //写出 PING 时可能发现连接已断并立即触发移除，这里只持有弱引用
+    QList<QPointer<ClientHandler>> dead;
+    int measured = 0;
+    qint64 rttSum = 0, jitterSum = 0;
+    int rttMax = 0;
+    for (const QPointer<ClientHandler>& handler : std::as_const(handlers)) {
+        if (!handler || !handler->isNetworked()) continue;
+        if (!handler->sendHeartbeat()) {
+            dead.append(handler);
+            continue;
+        }
+        if (handler && handler->heartbeatStats().samples() > 0) {
+            const int rtt = handler->heartbeatStats().smoothedRttMs();
+            measured++;
+            rttSum += rtt;
+            jitterSum += handler->heartbeatStats().jitterMs();
+            rttMax = qMax(rttMax, rtt);
+        }
+    }
+    for (const QPointer<ClientHandler>& handler : std::as_const(dead)) {
+        if (!handler) continue;
+        evictedPeers++;
+        handler->evict();
+    }
+
+    if (++heartbeatTicks % HEARTBEAT_STATS_TICKS == 0) {
+        //固定格式，便于日志采集
+        qInfo().noquote() << QString("heartbeat room=%1 peers=%2 measured=%3 srtt_ms_avg=%4 srtt_ms_max=%5 "
+                                     "jitter_ms_avg=%6 evicted=%7")
+                                 .arg(roomId.isEmpty() ? QString("-") : roomId)
+                                 .arg(handlers.size())
+                                 .arg(measured)
+                                 .arg(measured > 0 ? rttSum / measured : -1)
+                                 .arg(measured > 0 ? rttMax : -1)
+                                 .arg(measured > 0 ? jitterSum / measured : -1)
+                                 .arg(evictedPeers);
+    }
+}
+
+void ServerController::removeSpectator(int clientId)
+{
+    QMutexLocker locker(&clientsMutex);
+    ClientHandler* handler = spectators.take(clientId);
+    if (!handler) return;
+    disconnect(handler, nullptr, this, nullptr);
+    //可能正从自身的信号里调用，延迟删除
+    handler->deleteLater();
+    qInfo() << "Spectator" << clientId << "disconnected. Total spectators:" << spectators.size();
+}
+
+void ServerController::removeClientSlot(int clientId)
+{
+    if (spectators.contains(clientId)) {
+        removeSpectator(clientId);
+        return;
+    }
+    qDebug() << "ServerController::removeClientSlot - Attempting to remove client" << clientId;
+    fflush(stdout);
+
+    //只在摘除连接时持有 clientsMutex；游戏逻辑按 gameLogicMutex -> clientsMutex 的顺序另外加锁，
+    //nextTurn 和 roomEmpty 的接收方都可能再去拿 clientsMutex
+    bool roomNowEmpty = false;
+    int remainingClients = 0;
+    {
+        QMutexLocker locker(&clientsMutex);
+        qDebug() << "ServerController::removeClientSlot - Mutex acquired for client" << clientId;
+        fflush(stdout);
+
+        if (!clients.contains(clientId)) {
+            qWarning() << "ServerController::removeClientSlot - Client" << clientId << "not found in map.";
+            fflush(stdout);
+            return;
+        }
+        ClientHandler* handler = clients.take(clientId);
+        qDebug() << "ServerController::removeClientSlot - Client" << clientId << "taken from map. Handler ptr:" << handler;
+        fflush(stdout);
+
+        if (handler) {
+            // Disconnect signals to prevent further interaction with a dying object
+            disconnect(handler, &ClientHandler::parsedMessage, this, &ServerController::handleClientAction);
+            disconnect(handler, &ClientHandler::clientDisconnected, this, &ServerController::removeClientSlot);
+            //常常是在 socket->abort() 发出的断开信号里同步调用的（心跳超时、读循环出错），延迟删除
+            handler->deleteLater();
+            qDebug() << "ServerController::removeClientSlot - ClientHandler for" << clientId << "scheduled for deletion.";
+            fflush(stdout);
+        } else {
+            qWarning() << "ServerController::removeClientSlot - Handler for client" << clientId << "was null in map!";
+            fflush(stdout);
+        }
+
+        QString color = playerColors.take(clientId);
+        remainingClients = clients.size();
+        roomNowEmpty = clients.isEmpty();
+        if (roomNowEmpty && closeWhenEmpty) closed = true;
+        qInfo() << "Client" << clientId << "(" << color << ") disconnected and removed. Total clients:" << remainingClients;
+    }
+    if (roomNowEmpty) emit roomEmpty();
+
+    QMutexLocker gameLock(&gameLogicMutex);
+    if (playerReadyStatus.remove(clientId)) {
+        readyPlayers--;
+    }
+
+    if (roomNowEmpty && (readyPlayers > 0 || currentPlayerId != 0)) {
+        qInfo() << "Last player disconnected. Resetting game.";
+        currentPlayerId = 0;
+        ++turnSerial;
+        playerReadyStatus.clear();
+        //AI 留在座位上，等待新的玩家加入
+        for (int botId : std::as_const(botSeats)) {
+            playerReadyStatus[botId] = true;
+        }
+        readyPlayers = botSeats.size();
+        model.initGame(desiredPlayers); // Or some other reset logic
+    } else if (!roomNowEmpty && currentPlayerId != 0) { // Game in progress
+        broadcastEvent(ServerEvent::PlayerLeft, {clientId});
+        if (clientId == currentPlayerId) {
+            nextTurn();
+        }
+    } else if (!roomNowEmpty && readyPlayers < desiredPlayers) { // In ready phase
+        broadcastEvent(ServerEvent::PlayerLeftWaiting,
+                       {clientId, desiredPlayers - remainingClients - int(botSeats.size())});
+    }
+    qDebug() << "ServerController::removeClientSlot - Exiting for client" << clientId;
+    fflush(stdout);
+}
+
+void ServerController::sendToClient(int clientId, const QString &messageType, const QVariant &payload1, const QVariant &payload2)
+{
+    //QMutexLocker locker(&clientsMutex);
+    if (clients.contains(clientId)) {
+        ClientHandler* handler = clients.value(clientId);
+        if(handler) {
+            qDebug() << "ServerController: Sending message" << messageType << "to client" << clientId;
+            handler->sendTypedMessage(messageType, payload1, payload2);
+        } else {
+            qWarning() << "ServerController: Attempted to send message to null handler for client" << clientId;
+        }
+    } else {
+        qWarning() << "ServerController: Client" << clientId << "not found for sending message" << messageType;
+    }
+}
+
+QString ServerController::getPlayerColor(int clientId)
+{
+    switch(clientId) {
+    case 1: return "黄";
+    case 2: return "蓝";
+    case 3: return "绿";
+    case 4: return "红";
+    default: return "未知";
+    }
+}
+
+// ClientHandler 实现
+ClientHandler::ClientHandler(QIODevice* clientSock, int cId, ServerController *ctrl, QObject* parent)
+    : QObject(parent),
+    clientId(cId),
+    controller(ctrl),
+    socket(clientSock),
+    inStream(nullptr),
+    expectedBytes(0),
+    frameBucket(CLIENT_FRAMES_PER_SEC, CLIENT_FRAME_BURST),
+    byteBucket(CLIENT_BYTES_PER_SEC, CLIENT_BYTE_BURST)
+{
+    qDebug() << "ClientHandler for client" << clientId << "created in thread" << QThread::currentThreadId();
+    if (socket) {
+        socket->setParent(this);
+        inStream = new QDataStream(socket);
+        inStream->setVersion(QDataStream::Qt_6_5);
+
+        connect(socket, &QIODevice::readyRead, this, &ClientHandler::readData);
+        //观众队列在写缓冲腾出空间后继续写；玩家连接的队列始终为空
+        connect(socket, &QIODevice::bytesWritten, this, [this]() {
+            if (!pendingFrames.isEmpty() && !flushScheduled) flushQueue();
+        });
+        // QTcpSocket、QLocalSocket 与内存管道都提供 disconnected()，这里按名字连接
+        connect(socket, SIGNAL(disconnected()), this, SLOT(handleDisconnected()));
+        if (QAbstractSocket* tcpSocket = qobject_cast<QAbstractSocket*>(socket)) {
+            tcpSocket->setReadBufferSize(CLIENT_READ_BUFFER_BYTES);
+            peerAddress = tcpSocket->peerAddress();
+        } else {
+            //多路复用会话合计到底层连接的对端 IP 上
+            peerAddress = socket->property(PEER_ADDRESS_PROPERTY).value<QHostAddress>();
+        }
+        //网关转来的多路复用会话按类名判断，服务器以外的目标不链接 muxtransport
+        networked = qobject_cast<QAbstractSocket*>(socket) || qobject_cast<QLocalSocket*>(socket)
+                    || socket->inherits("MuxChannel");
+        //匹配大厅转交过来的连接可能已经缓冲了数据，不会再触发 readyRead
+        if (socket->bytesAvailable() > 0) {
+            QMetaObject::invokeMethod(this, &ClientHandler::readData, Qt::QueuedConnection);
+        }
+    } else {
+        qCritical() << "ClientHandler for client" << clientId << "received a null socket!";
+    }
+}
+ClientHandler::~ClientHandler()
+{
+    qDebug() << "ClientHandler for client" << clientId << "destroying...";
+    fflush(stdout);
+    // Socket is parented, will be deleted.
+    // QDataStream should be deleted if new'd.
+    delete inStream; // Delete the QDataStream object
+    inStream = nullptr;
+    qDebug() << "ClientHandler for client" << clientId << "destroyed.";
+    fflush(stdout);
+}
+
+void ClientHandler::sendTypedMessage(const QString &messageType, const QVariant &payload1, const QVariant &payload2)
+{
+    if (!isSocketConnected()) {
+        qWarning() << "Client" << clientId << ": Socket not connected. Cannot send" << messageType;
+        return;
+    }
+
+    qDebug() << "ClientHandler" << clientId << ": Preparing to send" << messageType << ". Payload1 valid:" << payload1.isValid() << "UserType:" << payload1.userType() << payload1.typeName() << "Payload2 valid:" << payload2.isValid();
+    fflush(stdout);
+
+    if (messageType == "GAME_STATE_MSG" && payload1.isValid()) {
+        qDebug() << "ClientHandler" << clientId << ": GAME_STATE_MSG payload typeName:" << payload1.typeName() << "userType:" << payload1.userType();
+        if (!payload1.canConvert<GameState>()) {
+            qWarning() << "ClientHandler" << clientId << ": FATAL - GAME_STATE_MSG payload QVariant CANNOT be converted to GameState! Check Q_DECLARE_METATYPE and qRegisterMetaType.";
+            return; // Don't attempt to send if conversion is impossible
+        }
+    }
+
+    QByteArray block = Protocol::encodeFrame(messageType, payload1, payload2);
+    if (block.isEmpty()) {
+        qWarning() << "ClientHandler" << clientId << ": failed to encode frame for" << messageType;
+        socket->reset();
+        return;
+    }
+
+    qDebug() << "ClientHandler" << clientId << ": Final block size for" << messageType << "is" << block.size();
+    fflush(stdout);
+    sendFrame(messageType, block);
+}
+
+void ClientHandler::sendFrame(const QString &messageType, const QByteArray &block)
+{
+    if (!isSocketConnected()) {
+        qWarning() << "Client" << clientId << ": Socket not connected. Cannot send" << messageType;
+        return;
+    }
+
+    qDebug() << "ClientHandler" << clientId << ": Attempting socket->write() for" << messageType << "block size:" << block.size();
+    fflush(stdout);
+
+    qint64 written = socket->write(block);
+    if (written == -1) {
+        qWarning() << "ClientHandler" << clientId << "socket->write() failed for" << messageType << ". Error:" << socket->errorString();
+        fflush(stdout);
+    } else if (written < block.size()) {
+        qWarning() << "ClientHandler" << clientId << "failed to write complete message for" << messageType << ". Wrote" << written << "of" << block.size() << "Error:" << socket->errorString();
+        fflush(stdout);
+    } else {
+        bool flushed = true;
+        if (QAbstractSocket* tcpSocket = qobject_cast<QAbstractSocket*>(socket)) {
+            flushed = tcpSocket->flush();
+        } else if (QLocalSocket* localSocket = qobject_cast<QLocalSocket*>(socket)) {
+            flushed = localSocket->flush();
+        }
+        qDebug() << "ClientHandler: Server sent [" << messageType << "] to client" << clientId << "size:" << block.size() << "(flushed:" << flushed << ")";
+        fflush(stdout);
+    }
+}
+
+void ClientHandler::queueFrame(const QByteArray &frame, bool snapshot)
+{
+    if (!isSocketConnected()) return;
+
+    //新的完整局面可以替代之前所有没写出去的帧
+    if (snapshot && socket->bytesToWrite() > SPECTATOR_BACKLOG_BYTES) {
+        droppedFrames += pendingFrames.size();
+        pendingFrames.clear();
+    } else if (pendingFrames.size() >= SPECTATOR_MAX_QUEUED) {
+        pendingFrames.removeFirst();
+        ++droppedFrames;
+    }
+    pendingFrames.append(frame);
+
+    if (!flushScheduled) {
+        flushScheduled = true;
+        QMetaObject::invokeMethod(this, &ClientHandler::flushQueue, Qt::QueuedConnection);
+    }
+}
+
+void ClientHandler::flushQueue()
+{
+    flushScheduled = false;
+    if (!isSocketConnected()) {
+        pendingFrames.clear();
+        return;
+    }
+    //只在写缓冲有空间时写，剩下的等 bytesWritten 再继续
+    while (!pendingFrames.isEmpty() && socket->bytesToWrite() < SPECTATOR_BACKLOG_BYTES) {
+        socket->write(pendingFrames.takeFirst());
+    }
+    if (droppedFrames > 0) {
+        qDebug() << "ClientHandler" << clientId << ": spectator is lagging, dropped" << droppedFrames << "frames so far.";
+    }
+}
+
+void ClientHandler::sendEvent(ServerEvent event, const QVariantList &args)
+{
+    sendTypedMessage("EVENT_MSG", int(event), QVariant(args));
+}
+
+void ClientHandler::sendGameState(const GameState& gameState)
+{
+    qCritical() << "ClientHandler" << getClientId() << ": sendGameState - ENTERED. GameState tile count:" << gameState.getTileStates().size();
+    fflush(stdout);
+
+    QVariant gameStateVariant;
+    qCritical() << "ClientHandler" << getClientId() << ": sendGameState - Attempting QVariant::fromValue(gameState)...";
+    fflush(stdout);
+
+    gameStateVariant = QVariant::fromValue(gameState);
+
+    if (!gameStateVariant.isValid()) {
+        qWarning() << "ClientHandler" << getClientId() << ": sendGameState - FAILED to create a valid QVariant from GameState! TypeName after attempt:" << gameStateVariant.typeName();
+        fflush(stdout);
+        return;
+    }
+
+    qCritical() << "ClientHandler" << getClientId() << ": sendGameState - QVariant CREATED successfully. TypeName:" << gameStateVariant.typeName() << "UserType:" << gameStateVariant.userType();
+    fflush(stdout);
+
+    sendTypedMessage("GAME_STATE_MSG", gameStateVariant);
+
+    qCritical() << "ClientHandler" << getClientId() << ": sendGameState - EXITED (called sendTypedMessage).";
+    fflush(stdout);
+}
+
+int ClientHandler::getClientId()
+{
+    return clientId;
+}
+
+QIODevice *ClientHandler::getSocket() const
+{
+    return socket;
+}
+
+bool ClientHandler::isNetworked() const
+{
+    return networked;
+}
+
+bool ClientHandler::sendHeartbeat()
+{
+    if (!isSocketConnected()) return true; // 断开信号随后就到
+    if (!heartbeat.beginInterval()) return false;
+    sendTypedMessage("PING_MSG", QVariant(Heartbeat::nowMs()));
+    return true;
+}
+
+void ClientHandler::evict()
+{
+    qWarning() << "ClientHandler" << clientId << ": no heartbeat for" << Heartbeat::MAX_MISSED
+               << "intervals (srtt" << heartbeat.smoothedRttMs() << "ms). Disconnecting.";
+    abortSocket();
+}
+
+const Heartbeat &ClientHandler::heartbeatStats() const
+{
+    return heartbeat;
+}
+
+bool ClientHandler::settle(int timeoutMs)
+{
+    if (!isSocketConnected()) return true;
+    QElapsedTimer timer;
+    timer.start();
+    //观众队列里还没写出的帧也一起发掉
+    if (!pendingFrames.isEmpty()) flushQueue();
+    while (socket->bytesToWrite() > 0 && timer.elapsed() < timeoutMs) {
+        if (!socket->waitForBytesWritten(int(timeoutMs - timer.elapsed()))) break;
+    }
+    //readyRead 照常触发 readData，收全的消息按正常流程处理
+    while ((expectedBytes != 0 || socket->bytesAvailable() > 0) && timer.elapsed() < timeoutMs) {
+        if (!socket->waitForReadyRead(int(timeoutMs - timer.elapsed()))) break;
+    }
+    return expectedBytes == 0 && socket->bytesAvailable() == 0;
+}
+
+bool ClientHandler::isSocketConnected() const
+{
+    if (!socket || !socket->isOpen()) return false;
+    if (QAbstractSocket* tcpSocket = qobject_cast<QAbstractSocket*>(socket)) {
+        return tcpSocket->state() == QAbstractSocket::ConnectedState;
+    }
+    if (QLocalSocket* localSocket = qobject_cast<QLocalSocket*>(socket)) {
+        return localSocket->state() == QLocalSocket::ConnectedState;
+    }
+    return true;
+}
+
+void ClientHandler::abortSocket()
+{
+    if (QAbstractSocket* tcpSocket = qobject_cast<QAbstractSocket*>(socket)) {
+        tcpSocket->abort();
+    } else if (QLocalSocket* localSocket = qobject_cast<QLocalSocket*>(socket)) {
+        localSocket->abort();
+    } else if (socket) {
+        socket->close();
+    }
+}
+
+void ClientHandler::readData()
+{
+    if (!socket || !inStream || evicting) return;
+    inStream->setVersion(QDataStream::Qt_6_5);
+
+    forever{
+        if (expectedBytes == 0) {
+            if (socket->bytesAvailable() < sizeof(quint32)) {
+                return;
+            }
+            *inStream >> expectedBytes;
+            //qDebug() << "Server: Client" << clientId << "expecting" << expectedBytes << "bytes for next message.";
+            if (expectedBytes > MAX_CLIENT_FRAME_BYTES) {
+                qWarning() << "Server: Client" << clientId << "announced an oversized message of" << expectedBytes << "bytes. Aborting.";
+                expectedBytes = 0;
+                abortSocket();
+                return;
+            }
+        }
+        if (socket->bytesAvailable() < expectedBytes) {
+            //qDebug() << "Server: Client" << clientId << "not enough data yet. Have" << socket->bytesAvailable() << "need" << expectedBytes;
+            return;
+        }
+        if (networked && !admitFrame(qint64(expectedBytes) + qint64(sizeof(quint32)))) {
+            return;
+        }
+
+        //本帧结束时缓冲里应剩下的字节数，用来判断可选的第二个参数是否存在
+        const qint64 frameEnd = socket->bytesAvailable() - qint64(expectedBytes);
+        QString messageType;
+        *inStream >> messageType;
+
+        if (inStream->status() != QDataStream::Ok) {
+            qWarning() << "Server: Client" << clientId << "stream error reading messageType.";
+            abortSocket();
+            expectedBytes = 0;
+            return;
+        }
+        //qDebug() << "Server: Client" << clientId << "received message type:" << messageType;
+
+        QVariant payload1, payload2;
+
+        if (messageType == "READY_MSG") {
+            // No payload
+        }
+        else if (messageType == "PLANE_OP_MSG") {
+            *inStream >> payload1 >> payload2; // Read as QVariants
+            if (inStream->status() != QDataStream::Ok) {
+                qWarning() << "Server: Client" << clientId << "stream error reading PLANE_OP_MSG payload.";
+                abortSocket();
+                expectedBytes = 0;
+                return;
+            }
+        }
+        else if (messageType == "FLY_OVER_MSG" || messageType == "HINT_MSG" || messageType == "MATCH_MSG"
+                 || messageType == "ROOM_MSG" || messageType == "PING_MSG" || messageType == "PONG_MSG") {
+            *inStream >> payload1;
+            if (messageType == "ROOM_MSG" && socket->bytesAvailable() > frameEnd) {
+                *inStream >> payload2; // 座位凭据
+            }
+            if (inStream->status() != QDataStream::Ok) {
+                qWarning() << "Server: Client" << clientId << "stream error reading" << messageType << "payload.";
+                abortSocket();
+                expectedBytes = 0;
+                return;
+            }
+        }
+        else {
+            qWarning() << "Server: Client" << clientId << "received unknown message type:" << messageType;
+            QByteArray dummyLoad;
+            dummyLoad.resize(expectedBytes - (sizeof(quint32) + messageType.toUtf8().size())); // Approximate
+            if (socket->bytesAvailable() >= dummyLoad.size()) {
+                inStream->readRawData(dummyLoad.data(), dummyLoad.size());
+                qDebug() << "Server: Discarded approx" << dummyLoad.size() << "bytes of unknown payload from client" << clientId;
+            } else {
+                qWarning() << "Server: Not enough data to fully discard unknown payload from client" << clientId << ". Stream may be corrupted.";
+                abortSocket();
+            }
+            expectedBytes = 0;
+            return;
+        }
+        expectedBytes = 0;
+        heartbeat.peerAlive();
+        if (messageType == "PING_MSG") {
+            //心跳在连接层直接应答，不经过游戏逻辑和锁
+            sendTypedMessage("PONG_MSG", payload1);
+        } else if (messageType == "PONG_MSG") {
+            heartbeat.pongReceived(payload1.toLongLong());
+        } else {
+            emit parsedMessage(clientId, messageType, payload1, payload2);
+        }
+
+        if (inStream->status() != QDataStream::Ok && isSocketConnected()) {
+            qWarning() << "Server: Client" << clientId << "QDataStream status not OK after processing message. Aborting.";
+            abortSocket();
+            return;
+        }
+        if (socket->bytesAvailable() == 0) {
+            throttledSinceMs = -1;
+            break;
+        }
+    }
+
+}
+
+bool ClientHandler::admitFrame(qint64 bytes)
+{
+    const qint64 now = RateLimiter::nowMs();
+    int wait = qMax(frameBucket.waitMs(1, now), byteBucket.waitMs(double(bytes), now));
+    if (wait == 0 && !peerAddress.isNull()) {
+        wait = RateLimiter::shared()->admitFrame(peerAddress, bytes);
+    }
+    if (wait == 0) {
+        frameBucket.take(1, now);
+        byteBucket.take(double(bytes), now);
+        return true;
+    }
+
+    if (throttledSinceMs < 0) {
+        throttledSinceMs = now;
+        qDebug() << "ClientHandler" << clientId << ": rate limit reached, pausing reads for" << wait << "ms.";
+    } else if (now - throttledSinceMs > THROTTLE_EVICT_MS) {
+        qWarning() << "ClientHandler" << clientId << ": exceeded its rate limit for" << now - throttledSinceMs
+                   << "ms. Disconnecting.";
+        //这里在 readData 的读循环里：同步 abort 会立即发出断开信号、移除本对象，推迟到回到事件循环之后
+        evicting = true;
+        QMetaObject::invokeMethod(this, &ClientHandler::abortSocket, Qt::QueuedConnection);
+        return false;
+    }
+    //数据留在缓冲里，等令牌补足再继续读
+    if (!resumeScheduled) {
+        resumeScheduled = true;
+        QTimer::singleShot(wait, this, [this]() {
+            resumeScheduled = false;
+            readData();
+        });
+    }
+    return false;
+}
+
+void ClientHandler::handleDisconnected()
+{
+    qInfo() << "Client" << clientId << "socket disconnected signal received by ClientHandler.";
+    emit clientDisconnected(clientId);
+}
+
+QString ClientHandler::getPlayerColor(int cId)
+{
+    switch(cId) {
+    case 1: return "黄";
+    case 2: return "蓝";
+    case 3: return "绿";
+    case 4: return "红";
+    default: return "未知";
+    }
+}
+
+// 游戏逻辑处理
+void ServerController::handleClientAction(int clientId, const QString &messageType, const QVariant &payload1, const QVariant &payload2)
+{
+    if (messageType == "MATCH_MSG" || messageType == "ROOM_MSG") {
+        //已经入座（单桌模式或匹配完成），匹配/找房间请求不再有意义
+        qDebug() << "Client" << clientId << "sent" << messageType << "after being seated - ignored.";
+        return;
+    }
+    if (ClientHandler* spectator = spectators.value(clientId)) {
+        qDebug() << "Spectator" << clientId << "sent" << messageType << "- ignored.";
+        spectator->sendEvent(ServerEvent::Error, {int(ServerError::Spectating)});
+        return;
+    }
+
+    QMutexLocker locker(&gameLogicMutex); // Protect game logic and state
+    qDebug() << "Server received action from client" << clientId << "(" << getPlayerColor(clientId) << "):" << messageType;
+    fflush(stdout);
+
+    if (this->gameHasEnded) {
+        if (messageType != "READY_MSG") {
+            sendEvent(clientId, ServerEvent::GameAlreadyEnded);
+            qDebug() << "Game has ended. Action" << messageType << "from client" << clientId << "ignored.";
+            return;
+        }
+    }
+    if (messageType == "READY_MSG") {
+        if (!playerReadyStatus.value(clientId, false)) {
+            playerReadyStatus[clientId] = true;
+            readyPlayers++;
+            broadcastEvent(ServerEvent::PlayerReady, {clientId, readyPlayers, desiredPlayers});
+            qInfo() << "Player" << clientId << "(" << getPlayerColor(clientId) << ") is ready."
+                    << readyPlayers << "/" << desiredPlayers;
+
+            if (readyPlayers == desiredPlayers && desiredPlayers > 0) { // Check clients.size() as well?
+                QMutexLocker clientListLocker(&clientsMutex);
+                if (clients.size() + botSeats.size() == desiredPlayers) {
+                    initGameAndStart();
+                } else {
+                    broadcastEvent(ServerEvent::AllReadyWaiting,
+                                   {desiredPlayers - int(clients.size()) - int(botSeats.size())});
+                }
+            } else if (clients.size() + botSeats.size() < desiredPlayers) {
+                QMutexLocker clientListLocker(&clientsMutex); // Accessing clients.size()
+                broadcastEvent(ServerEvent::WaitingForPlayers,
+                               {desiredPlayers - int(clients.size()) - int(botSeats.size())});
+            }
+        } else {
+            qDebug() << "Player" << clientId << "sent READY_MSG again.";
+        }
+        return;
+    }
+
+    if (readyPlayers < desiredPlayers || currentPlayerId == 0) {
+        sendEvent(clientId, ServerEvent::Error, {int(ServerError::GameNotStarted)});
+        return;
+    }
+    if (clientId != currentPlayerId) {
+        sendEvent(clientId, ServerEvent::Error, {int(ServerError::NotYourTurn)});
+        return;
+    }
+
+    try {
+        if (messageType == "PLANE_OP_MSG") {
+            bool diceOk, planeIdOk;
+            int dice = payload1.toInt(&diceOk);
+            int planeId = 0;
+            FlyPolicy flyPolicy = FlyPolicy::Ask;
+            if (payload2.typeId() == QMetaType::QVariantList) {
+                const QVariantList op = payload2.toList();
+                planeId = op.value(0).toInt(&planeIdOk);
+                const int policy = op.value(1).toInt();
+                if (policy >= int(FlyPolicy::Ask) && policy <= int(FlyPolicy::Never)) flyPolicy = FlyPolicy(policy);
+            } else {
+                planeId = payload2.toInt(&planeIdOk);
+            }
+
+            //点数由客户端给出，超出 1~6 的会让规则引擎把飞机走出棋盘，与提示请求一样直接拒绝
+            if (!diceOk || !planeIdOk || dice < 1 || dice > 6) {
+                qWarning() << "Server: Invalid payload for PLANE_OP_MSG from client" << clientId;
+                sendEvent(clientId, ServerEvent::Error, {int(ServerError::InvalidPlaneOp)});
+                return;
+            }
+            qInfo() << "玩家" << getPlayerColor(clientId) << "选择了飞机" << planeId << "，骰子点数" << dice;
+
+            QMap<int, QList<int>> currentTileStates = model.getBoardState();
+
+            PlaneMove move;
+            int result = do_plan_OP(clientId,dice,planeId,currentTileStates,&move);
+            lastDice = dice;
+            lastPlaneId = planeId;
+
+            if (!move.path.isEmpty()) broadcastPlaneMove(move);
+            model.setBoardState(currentTileStates);
+            GameState gameStateToBroadcast(currentTileStates);
+            broadcastGameState(gameStateToBroadcast);
+
+            if(result == 1){
+                //事先声明过策略就直接执行，否则再问一次
+                if (flyPolicy == FlyPolicy::Ask) {
+                    sendEvent(clientId, ServerEvent::YourTurnChooseFly);
+                } else {
+                    applyFlyChoice(clientId, flyPolicy == FlyPolicy::Always);
+                }
+            }
+            else if (!check_is_win(gameStateToBroadcast)) {
+                nextTurn();
+            }
+        }
+        else if (messageType == "FLY_OVER_MSG") {
+            applyFlyChoice(clientId, payload1.toBool());
+        }
+        else if (messageType == "HINT_MSG") {
+            bool diceOk;
+            int dice = payload1.toInt(&diceOk);
+            if (!diceOk || dice < 1 || dice > 6) {
+                sendEvent(clientId, ServerEvent::Error, {int(ServerError::InvalidHint)});
+                return;
+            }
+            requestHint(clientId, dice);
+        }
+        else {
+            qWarning() << "Client" << clientId << "sent unknown or unhandled message type:" << messageType;
+            sendEvent(clientId, ServerEvent::Error, {int(ServerError::UnknownAction), messageType});
+        }
+    } catch (const std::exception& e) {
+        qCritical() << "Exception during client action:" << e.what();
+        sendEvent(clientId, ServerEvent::Error, {int(ServerError::Internal), QString::fromLocal8Bit(e.what())});
+    } catch (...) {
+        qCritical() << "Unknown exception during client action for client" << clientId;
+        sendEvent(clientId, ServerEvent::Error, {int(ServerError::Internal)});
+    }
+}
+
+void ServerController::applyFlyChoice(int clientId, bool flyYes)
+{
+    QString choiceStr = flyYes ? "YES" : "NO";
+    qInfo() << "玩家" <<clientId << "选择飞跃？"<< choiceStr;
+
+    QMap<int, QList<int>> currentTileStates = model.getBoardState();
+
+    PlaneMove move;
+    do_fly(lastPlaneId, clientId, choiceStr, currentTileStates, &move);
+
+    if (!move.path.isEmpty()) broadcastPlaneMove(move);
+    model.setBoardState(currentTileStates);
+    GameState gameStateToBroadcast(currentTileStates); // Create with the final currentTileStates
+    broadcastGameState(gameStateToBroadcast);
+    if (!check_is_win(gameStateToBroadcast)) {
+        nextTurn();
+    }
+}
+
+void ServerController::startSearch(std::function<void()> task)
+{
+    {
+        QMutexLocker locker(&searches->mutex);
+        if (searches->closing) return;
+        searches->running++;
+    }
+    //任务持有计数器的引用，房间析构后最后一个任务仍能安全地减计数
+    std::shared_ptr<SearchTracker> tracker = searches;
+    searchResources().pool.start([tracker, task]() {
+        bool skip = false;
+        {
+            QMutexLocker locker(&tracker->mutex);
+            skip = tracker->closing;
+        }
+        if (!skip) task();
+        QMutexLocker locker(&tracker->mutex);
+        if (--tracker->running == 0) tracker->finished.wakeAll();
+    });
+}
+
+void ServerController::scheduleBotTurn()
+{
+    //调用方持有 gameLogicMutex。骰子由服务器代掷，搜索在线程池里进行
+    const int botId = currentPlayerId;
+    const int serial = turnSerial;
+    QRandomGenerator* random = seededBots ? &botRandom : QRandomGenerator::global();
+    const int dice = random->bounded(6) + 1;
+    const BoardPosition position = BoardPosition::fromTileStates(model.getBoardState());
+    MonteCarloOptions options = botOptions;
+    if (seededBots) options.seed = botRandom.generate64();
+    const ExpectimaxOptions expectimaxOptions = searchOptions;
+    const BotEngine engine = botEngine;
+
+    broadcastEvent(ServerEvent::BotRolled, {botId, dice});
+
+    startSearch([this, botId, serial, dice, position, options, expectimaxOptions, engine]() {
+        SearchResources& shared = searchResources();
+        const BotDecision decision = engine == ExpectimaxEngine
+                                         ? shared.searcher.chooseMove(position, botId, dice, expectimaxOptions, &shared.pool)
+                                         : MonteCarloBot::chooseMove(position, botId, dice, options, &shared.pool);
+        QMetaObject::invokeMethod(this, [this, botId, serial, dice, decision]() {
+            applyBotTurn(botId, serial, dice, decision);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void ServerController::requestHint(int clientId, int dice)
+{
+    //调用方持有 gameLogicMutex。与 AI 座位共用搜索器，结果排队回到本线程再发送
+    const BoardPosition position = BoardPosition::fromTileStates(model.getBoardState());
+    const ExpectimaxOptions options = searchOptions;
+    const int serial = turnSerial;
+
+    startSearch([this, clientId, dice, position, options, serial]() {
+        SearchResources& shared = searchResources();
+        const BotDecision decision = shared.searcher.chooseMove(position, clientId, dice, options, &shared.pool);
+        QMetaObject::invokeMethod(this, [this, clientId, serial, decision]() {
+            QMutexLocker locker(&gameLogicMutex);
+            if (serial != turnSerial || currentPlayerId != clientId) return; // 回合已经结束
+            sendToClient(clientId, "HINT_MSG", QVariant(decision.planeId), QVariant(decision.fly));
+        }, Qt::QueuedConnection);
+    });
+}
+
+void ServerController::applyBotTurn(int botId, int serial, int dice, const BotDecision &decision)
+{
+    {
+        QMutexLocker locker(&gameLogicMutex);
+        if (serial != turnSerial || currentPlayerId != botId || gameHasEnded || !botSeats.contains(botId)) {
+            qDebug() << "ServerController: Dropping stale AI decision for player" << botId;
+            return;
+        }
+    }
+    //搜索量的含义随引擎不同：期望搜索是节点数，蒙特卡洛是模拟局数
+    if (botEngine == ExpectimaxEngine) {
+        qInfo() << "AI player" << botId << "plays plane" << decision.planeId << "with dice" << dice
+                << "after searching" << decision.work << "nodes to depth" << decision.depth;
+    } else {
+        qInfo() << "AI player" << botId << "plays plane" << decision.planeId << "with dice" << dice
+                << "after" << decision.work << "playouts";
+    }
+    //走与真人玩家相同的处理流程，AI 在搜索时已经决定好是否飞跃
+    const FlyPolicy policy = decision.fly ? FlyPolicy::Always : FlyPolicy::Never;
+    handleClientAction(botId, "PLANE_OP_MSG", dice, QVariantList{decision.planeId, int(policy)});
+}
+
+void ServerController::sendEvent(int clientId, ServerEvent event, const QVariantList &args)
+{
+    if (ClientHandler* handler = clients.value(clientId)) {
+        handler->sendEvent(event, args);
+    }
+}
+
+void ServerController::broadcastEvent(ServerEvent event, const QVariantList &args, int exceptClientId)
+{
+    //QMutexLocker locker(&clientsMutex);
+    qDebug() << "Server broadcasting EVENT_MSG:" << int(event) << args;
+    broadcastFrame("EVENT_MSG", int(event), QVariant(args), false, exceptClientId);
+}
+
+void ServerController::broadcastFrame(const QString &messageType, const QVariant &payload1, const QVariant &payload2,
+                                      bool snapshot, int exceptClientId)
+{
+    if (clients.isEmpty() && spectators.isEmpty()) return;
+
+    const QByteArray frame = Protocol::encodeFrame(messageType, payload1, payload2);
+    if (frame.isEmpty()) {
+        qWarning() << "Server: failed to encode broadcast frame" << messageType;
+        return;
+    }
+    //玩家先写，观众的写入推迟到本轮事件处理之后，观众再多也不拖慢玩家
+    for (auto it = clients.constBegin(); it != clients.constEnd(); ++it) {
+        if (it.value() && it.key() != exceptClientId) it.value()->sendFrame(messageType, frame);
+    }
+    for (ClientHandler* handler : qAsConst(spectators)) {
+        if (handler) handler->queueFrame(frame, snapshot);
+    }
+}
+
+void ServerController::broadcastPlaneMove(const PlaneMove &move)
+{
+    qDebug() << "Server broadcasting PLANE_MOVE_MSG for plane" << move.globalPlaneId << "path" << move.path;
+    broadcastFrame("PLANE_MOVE_MSG", move.toVariant());
+}
+
+void ServerController::broadcastGameState(const GameState& state)
+{
+    qCritical() << "[BGS_ENTER] broadcastGameState - ENTERED.";
+    fflush(stdout);
+
+    qCritical() << "[BGS_TEST_THIS] 'this->desiredPlayers' (pre-access):" << this->desiredPlayers;
+    fflush(stdout);
+
+    qCritical() << "[BGS_TEST_STATE_PARAM] 'state.getTileStates().size()' (pre-access):" << state.getTileStates().size();
+    fflush(stdout);
+
+    qCritical() << "[BGS_TEST_CLIENTS_SIZE] 'clients.size()' (pre-access):" << this->clients.size();
+    fflush(stdout);
+
+    qCritical() << "[BGS_BEFORE_LOCKER_ATTEMPT] All initial accesses OK. About to TRY to lock clientsMutex.";
+    fflush(stdout);
+
+    try {
+        qCritical() << "[BGS_TRY_LOCK] Attempting QMutexLocker locker(&clientsMutex)...";
+        fflush(stdout);
+        //QMutexLocker locker(&clientsMutex); // This is the critical point
+        qCritical() << "[BGS_LOCKER_ACQUIRED] clientsMutex Acquired by QMutexLocker. Client map size (again):" << this->clients.size();
+        fflush(stdout);
+
+        if (clients.isEmpty() && spectators.isEmpty()) {
+            qWarning() << "[BGS_WARN] No clients to broadcast GameState to!"; fflush(stdout);
+            // Locker releases when function returns
+            return;
+        }
+
+        qDebug() << "[BGS_INFO] Broadcasting GameState object. Actual state tile count:" << state.getTileStates().size()
+                 << "players:" << clients.size() << "spectators:" << spectators.size(); fflush(stdout);
+        broadcastFrame("GAME_STATE_MSG", QVariant::fromValue(state), QVariant(), true);
+
+        qCritical() << "[BGS_LOOP_FINISHED] Broadcast finished. QMutexLocker will release."; fflush(stdout);
+
+    } catch (const std::exception& e) {
+        qCritical() << "[BGS_EXCEPTION_LOCK_OR_LOOP] std::exception caught: " << e.what();
+        fflush(stdout);
+    } catch (...) {
+        qCritical() << "[BGS_EXCEPTION_LOCK_OR_LOOP] Unknown exception caught around mutex lock or loop.";
+        fflush(stdout);
+    }
+
+    qCritical() << "[BGS_EXIT] broadcastGameState EXITED.";
+    fflush(stdout);
+}
+
+void ServerController::initGameAndStart()
+{
+    qInfo() << "所有玩家已准备，初始化游戏..."; // This is the last log seen from server
+
+    qDebug() << "[Debug] initGameAndStart: Step 1 - Initializing model.initGame(" << desiredPlayers << ")";
+    model.initGame(desiredPlayers);
+    qDebug() << "[Debug] initGameAndStart: Step 2 - Model initialized.";
+
+    gameHasEnded = false;
+    currentPlayerId = 1; // Start with player 1
+    ++turnSerial;
+    qDebug() << "[Debug] initGameAndStart: Step 3 - CurrentPlayerId set to" << currentPlayerId;
+
+    qDebug() << "[Debug] initGameAndStart: Step 4 - Attempting to get board state from model.";
+    GameState initialState(model.getBoardState());
+    qDebug() << "[Debug] initGameAndStart: Step 5 - Initial GameState created. Tile count (example):" << initialState.getTileStates().size();
+
+    qDebug() << "[Debug] initGameAndStart: Step 6 - Broadcasting initial game state.";
+    broadcastGameState(initialState);
+    qDebug() << "[Debug] initGameAndStart: Step 7 - Initial game state broadcasted.";
+
+    qDebug() << "[Debug] initGameAndStart: Step 8 - Broadcasting game start event, first player" << currentPlayerId;
+    broadcastEvent(ServerEvent::GameStarted, {currentPlayerId});
+    qDebug() << "[Debug] initGameAndStart: Step 9 - Game start message broadcasted.";
+
+    if (botSeats.contains(currentPlayerId)) {
+        scheduleBotTurn();
+        return;
+    }
+    qDebug() << "[Debug] initGameAndStart: Step 10 - Sending turn event to player" << currentPlayerId;
+    sendEvent(currentPlayerId, ServerEvent::YourTurnRoll);
+    qDebug() << "[Debug] initGameAndStart: Step 11 - Turn message sent. initGameAndStart complete.";
+}
+
+void ServerController::do_fly(int lastPlaneId, int currentPlayerId, const QString &choice, QMap<int, QList<int>>& tileStates,
+                              PlaneMove* move)
+{
+    qDebug() << "[Debug] do_fly called for plane" << lastPlaneId << "client" << currentPlayerId << "choice" << choice;
+
+    if (choice.toUpper() != "YES") {
+        qDebug() << "Player" << currentPlayerId << "chose not to fly.";
+        return;
+    }
+
+    if(tileStates.isEmpty()){
+        qWarning() << "tileStates 为空，无法执行飞跃操作";
+        return;
+    }
+
+    //规则计算交给 GameRules，在紧凑局面上完成后再写回格子表
+    const int globalPlaneId = (currentPlayerId - 1) * 4 + lastPlaneId;
+    const BoardPosition before = BoardPosition::fromTileStates(tileStates);
+    BoardPosition position = before;
+    if (!GameRules::applyFly(position, currentPlayerId, lastPlaneId)) {
+        qWarning() << "未能找到飞机 globalPlaneId=" << globalPlaneId << "所在的格子";
+        return;
+    }
+    tileStates = position.toTileStates();
+
+    if (move) {
+        move->globalPlaneId = globalPlaneId;
+        move->path = { position.tile[globalPlaneId - 1] };
+        move->captured = GameRules::capturedPlanes(before, position, globalPlaneId);
+    }
+}
+
+bool ServerController::check_is_win(GameState& state)
+{
+    qDebug() << "[Debug] check_is_win called.";
+    QMap<int, QList<int>> playerAirports = {
+        {1, {1, 2, 3, 4}},    // 黄
+        {2, {5, 6, 7, 8}},    // 蓝
+        {3, {9, 10, 11, 12}}, // 绿
+        {4, {13, 14, 15, 16}} // 红
+    };
+
+    for (auto it = playerAirports.begin(); it != playerAirports.end(); ++it) {
+        int playerId = it.key();
+        QList<int> airportTiles = it.value();
+
+        bool hasWon = true;
+        for (int tileId : airportTiles) {
+            QList<int> planes = state.getTileStates().value(tileId);
+            // 到达终点的飞机以 100+全局编号 停回自己的机场格（机场格编号与全局编号相同）
+            if (!planes.contains(100 + tileId)) {
+                hasWon = false;
+                break;
+            }
+        }
+
+        if (hasWon) {
+            gameHasEnded = true;
+            broadcastEvent(ServerEvent::GameWon, {playerId});
+            qDebug() << "Player" << playerId << "(" << getPlayerColor(playerId) << ") has won the game.";
+            return true;
+        }
+    }
+    return false;
+}
+
+int ServerController::getSpecialJumpTarget(int clientId, int currentPos) {
+    return GameRules::getSpecialJumpTarget(clientId, currentPos);
+}
+
+int ServerController::do_plan_OP(int clientId, int dice, int planeId,  QMap<int, QList<int>>& tileStates, PlaneMove* move)
+{
+    qDebug() << "[Debug] do_plan_OP called for client" << clientId << "dice" << dice << "plane" << planeId;
+
+    if(tileStates.isEmpty()){
+        qCritical() << "tileStates 为空，无法执行操作";
+        return 0;
+    }
+
+    //整步一次算完，只记录经过的格子，由客户端按路径播放动画
+    const int globalPlaneId = (clientId - 1)*4 + planeId;
+    const BoardPosition before = BoardPosition::fromTileStates(tileStates);
+    BoardPosition position = before;
+    QList<int> path;
+    GameRules::MoveResult result = GameRules::applyMoveWithPath(position, clientId, dice, planeId, &path);
+
+    switch (result) {
+    case GameRules::MoveInvalid:
+        qCritical() << "未能找到飞机 globalPlaneId=" << (clientId - 1)*4 + planeId;
+        return 0;
+    case GameRules::MoveCannotTakeOff:
+        qInfo() << "Player" << clientId << "plane" << planeId << "is in airport but rolled" << dice << ". Cannot take off.";
+        sendEvent(clientId, ServerEvent::CannotTakeOff);
+        return 0; // 不能起飞，操作无效或不完整
+    default:
+        break;
+    }
+
+    tileStates = position.toTileStates();
+
+    if (move) {
+        move->globalPlaneId = globalPlaneId;
+        move->path = path;
+        move->captured = GameRules::capturedPlanes(before, position, globalPlaneId);
+    }
+    return result == GameRules::MoveCanFly ? 1 : 0;
+}
+
+int ServerController::findPlaneCurrentTile(int globalPlaneId, QMap<int, QList<int> > &tileStates)
+{
+    for(auto it = tileStates.begin();it != tileStates.end();it++){
+        if(it.value().contains(globalPlaneId)){
+            return it.key();
+        }
+    }
+    qWarning() << "findPlaneCurrentTile: Plane" << globalPlaneId << "not found on any tile.";
+    return -1;
+}
+
+void ServerController::removePlaneFromTile(int planeId, int tileId, QMap<int, QList<int> > &tileStates)
+{
+    if(!tileStates.contains(tileId)) {
+        qWarning() << "removePlaneFromTile: Tile" << tileId << "not found in board state.";
+        return;
+    }
+    bool removed = tileStates[tileId].removeAll(planeId);
+    if (!removed) {
+        qWarning() << "removePlaneFromTile: Plane" << planeId << "was not found on tile" << tileId << "to remove.";
+    }
+}
+
+void ServerController::addPlaneToTile(int planeId, int tileId, QMap<int, QList<int> > &tileStates)
+{
+    if (!tileStates.contains(tileId)) {
+        qWarning() << "addPlaneToTile: Attempting to add plane" << planeId << "to non-existent tile" << tileId << ". Creating tile entry.";
+    }
+    tileStates[tileId].append(planeId);
+}
+
+bool ServerController::isInAirport(int tileId)
+{
+    return GameRules::isInAirport(tileId);
+}
+
+int ServerController::getStartTile(int clientId)
+{
+    const int startTile = GameRules::getStartTile(clientId);
+    if (startTile == 0) throw std::invalid_argument("无效的clientId");
+    return startTile;
+}
+
+int ServerController::getAirportTile(int clientId, int planeId)
+{
+    return GameRules::getAirportTile(clientId, planeId);
+}
+
+int ServerController::getNextPosition(int clientId, int currentPos)
+{
+    return GameRules::getNextPosition(clientId, currentPos);
+}
+
+bool ServerController::isExitRingPosition(int clientId, int pos)
+{
+    return GameRules::isExitRingPosition(clientId, pos);
+}
+
+int ServerController::getNextOnExitPath(int clientId, int currentPos)
+{
+    return GameRules::getNextOnExitPath(clientId, currentPos);
+}
+
+bool ServerController::isFinalEnd(int clientId, int pos)
+{
+    return GameRules::isFinalEnd(clientId, pos);
+}
+
+void ServerController::handleCollision(int selfPlaneId, int tileId, QMap<int, QList<int> > &tileStates)
+{
+    if (!tileStates.contains(tileId) || tileStates.value(tileId).size() <= 1) return;
+
+    BoardPosition position = BoardPosition::fromTileStates(tileStates);
+    if (GameRules::handleCollision(position, selfPlaneId, tileId)) {
+        tileStates = position.toTileStates();
+    }
+}
+
+bool ServerController::isSameColor(int planeId1, int planeId2)
+{
+    return GameRules::isSameColor(planeId1, planeId2);
+}
+
+bool ServerController::isTileColorMatchesClient(int clientId, int tileId)
+{
+    return GameRules::isTileColorMatchesPlayer(clientId, tileId);
+}
+
+void ServerController::collisionDuringFly(int clientId, QMap<int, QList<int> > &tileStates)
+{
+    BoardPosition position = BoardPosition::fromTileStates(tileStates);
+    if (GameRules::collisionDuringFly(position, clientId)) {
+        tileStates = position.toTileStates();
+    }
+}
+
+void ServerController::nextTurn()
+{
+    qDebug() << "[Debug] nextTurn: Entered nextTurn method.";
+
+    if (clients.isEmpty() && botSeats.isEmpty()) {
+        qDebug() << "[Debug] nextTurn: No clients connected, resetting currentPlayerId and returning.";
+        currentPlayerId = 0;
+        return;
+    }
+
+    bool currentPlayerStillConnected = false;
+    {
+        QMutexLocker clientListLocker(&clientsMutex);
+        if(isSeatTaken(currentPlayerId)){
+            currentPlayerStillConnected = true;
+        }
+    }
+
+    qDebug() << "[Debug] nextTurn: Last dice roll was" << lastDice << ". Current player" << currentPlayerId << "is" << (currentPlayerStillConnected ? "connected." : "not connected.");
+
+    if(lastDice != 6 || !currentPlayerStillConnected){
+        qDebug() << "[Debug] nextTurn: Advancing to next player.";
+        QMutexLocker clientListLocker(&clientsMutex);
+        if (clients.isEmpty() && botSeats.isEmpty()) {
+            qDebug() << "[Debug] nextTurn: No clients connected after trying to advance. Resetting and returning.";
+            currentPlayerId = 0;
+            return;
+        }
+        int initialPlayerId = currentPlayerId;
+        if (desiredPlayers > 0) {
+            int attempts = 0;
+            do {
+                currentPlayerId = (currentPlayerId % desiredPlayers) + 1;
+                attempts++;
+                if (attempts > desiredPlayers + 1) {
+                    qWarning() << "[Debug] nextTurn: Could not find a connected next player after multiple attempts. Breaking loop.";
+                    currentPlayerId = 0;
+                    broadcastEvent(ServerEvent::NoNextPlayer);
+                    return;
+                }
+            } while (!isSeatTaken(currentPlayerId) && currentPlayerId != initialPlayerId);
+        } else {
+            qWarning() << "[Debug] nextTurn: desiredPlayers is 0, cannot advance turn.";
+            currentPlayerId = 0;
+            return;
+        }
+
+        if (!isSeatTaken(currentPlayerId)) {
+            qInfo() << "No valid next player found. Game might be over or waiting.";
+            currentPlayerId = 0;
+            broadcastEvent(ServerEvent::NoNextPlayer);
+            return;
+        }
+    }
+    qInfo() << "Next turn: Player" << currentPlayerId << "(" << getPlayerColor(currentPlayerId) << ")";
+    ++turnSerial;
+
+    if (botSeats.contains(currentPlayerId)) {
+        scheduleBotTurn();
+    } else {
+        qDebug() << "[Debug] nextTurn: Sending YourTurnRoll to player" << currentPlayerId;
+        sendEvent(currentPlayerId, ServerEvent::YourTurnRoll);
+    }
+
+    qDebug() << "[Debug] nextTurn: Notifying other players and spectators about current turn.";
+    //轮到的玩家已经收到 YourTurnRoll，再收 TurnChanged 会被切回等待阶段
+    broadcastEvent(ServerEvent::TurnChanged, {currentPlayerId}, currentPlayerId);
+    qDebug() << "[Debug] nextTurn: nextTurn method complete.";
+}
+
+
+
+
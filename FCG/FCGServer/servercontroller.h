@@ -1,109 +1,236 @@
-#ifndef SERVERCONTROLLER_H
-#define SERVERCONTROLLER_H
-
-#include <QObject>
-#include <QMap>
-#include <QThreadPool>
-#include <QTcpSocket>
-#include <QDataStream>
-#include <QMutex>
-#include <../FCGClient/model/gamemodel.h>
-#include <../FCGClient/model/gamestate.h>
-#include <QVariant>
-
-class ClientHandler;
-
-class ServerController : public QObject
-{
-    Q_OBJECT
-public:
-    explicit ServerController(QObject *parent = nullptr);
-    ~ServerController();
-
-    //客户端信息处理
-    void setDesiredPlayers(int desiredPlayers);
-    void addClient(QTcpSocket* clientSocket, int clientId);
-public slots:
-    void removeClientSlot(int clientId);
-    void handleClientAction(int clientId, const QString &messageType, const QVariant &payload1, const QVariant &payload2);
-
-private:
-
-
-    //成员变量
-    QMap<int , ClientHandler*> clients;
-    QMutex clientsMutex;
-    QMutex gameLogicMutex;
-    GameModel model;
-
-    bool gameHasEnded = false;
-    int currentPlayerId = 0;
-    int desiredPlayers = 0;
-    int readyPlayers = 0;
-    int lastDice = 0;
-    int lastPlaneId = -1;
-    QMap<int, bool> playerReadyStatus;
-    QMap<int ,QString> playerColors;
-
-    //客户端信息处理
-    void sendToClient(int clientId, const QString &messageType, const QVariant &payload1 = QVariant()
-                      , const QVariant &payload2 = QVariant());
-    void broadcastMessage(const QString &msg);
-    void broadcastGameState(const GameState& state);
-
-    void initGameAndStart();
-    void do_fly(int lastPlaneId,int currentPlayerId,const QString &choice ,QMap<int, QList<int>>& tileStates);
-    void check_is_win(GameState &state);
-    int getSpecialJumpTarget(int clientId,int currentPos);
-    int do_plan_OP(int clientId,int dice,int planeId, QMap<int, QList<int>>& tileStates);
-    int findPlaneCurrentTile(int globalPlaneId,QMap<int ,QList<int>> &tileStates);
-    void removePlaneFromTile(int planeId,int tileId,QMap<int ,QList<int>> &tileStates);
-    void addPlaneToTile(int planeId,int tileId,QMap<int ,QList<int>> &tileStates);
-    bool isInAirport(int tileId);
-    int getStartTile(int clientId);
-    int getAirportTile(int clientId,int planeId);
-    int getNextPosition(int clientId,int currentPos);
-    bool isExitRingPosition(int clientId,int pos);
-    int getNextOnExitPath(int clientId,int currentPos);
-    bool isFinalEnd(int clientId,int pos);
-    void handleCollision(int selfPlaneId,int tileId,QMap<int ,QList<int>> &tileStates);
-    bool isSameColor(int planeId1,int planeId2);
-    bool isTileColorMatchesClient(int clientId,int tileId);
-    void collisionDuringFly(int clientId,QMap<int ,QList<int >> &tileStates);
-    void nextTurn();
-
-    QString getPlayerColor(int clientId);
-
-};
-class ClientHandler : public QObject
-{
-    Q_OBJECT
-
-public:
-    ClientHandler(QTcpSocket* socket, int clientId, ServerController* controller, QObject* parent = nullptr);
-    ~ClientHandler();
-
-    Q_INVOKABLE void sendTypedMessage(const QString& messageType, const QVariant& payload1 = QVariant(), const QVariant& payload2 = QVariant());
-    Q_INVOKABLE void sendMessage(const QString & message);
-    Q_INVOKABLE void sendGameState(const GameState &state);
-    int getClientId();
-
-signals:
-    void parsedMessage(int clientId, const QString& messageType, const QVariant& payload1, const QVariant& payload2);
-    void clientDisconnected(int clientId);
-
-private slots:
-    void readData();
-    void handleDisconnected();
-
-private:
-
-    int clientId;
-    ServerController* controller;
-    QTcpSocket* socket;
-    QDataStream* inStream;
-    quint32 expectedBytes = 0;
-
-    QString getPlayerColor(int cId);
-};
-#endif // SERVERCONTROLLER_H
+#ifndef SERVERCONTROLLER_H
+#define SERVERCONTROLLER_H
+
+#include <QObject>
+#include <QMap>
+#include <QTcpSocket>
+#include <QDataStream>
+#include <QMutex>
+#include <../FCGClient/model/gamemodel.h>
+#include <../FCGClient/model/gamestate.h>
+#include <QVariant>
+#include <../FCGClient/controller/gameclock.h>
+#include <../FCGClient/controller/heartbeat.h>
+#include <../FCGClient/model/protocol.h>
+#include <QSet>
+#include <QRandomGenerator>
+#include <QTimer>
+#include <functional>
+#include <memory>
+#include "montecarlobot.h"
+#include "expectimaxsearch.h"
+#include "ratelimiter.h"
+
+class ClientHandler;
+
+class ServerController : public QObject
+{
+    Q_OBJECT
+public:
+    enum BotEngine {
+        MonteCarloEngine,
+        ExpectimaxEngine
+    };
+
+    explicit ServerController(QObject *parent = nullptr);
+    ~ServerController();
+
+    //客户端信息处理
+    void setDesiredPlayers(int desiredPlayers);
+    //clientSocket 可以是 QTcpSocket，也可以是任何带 disconnected() 信号的已连接设备（如内存管道）
+    void addClient(QIODevice* clientSocket, int clientId);
+    //断线重连：座位凭据有效且原座位空着时回到原座位，否则按 fallbackClientId 接入（通常成为观众）。
+    //房间已经清空、等待销毁时直接关闭连接
+    void rejoinClient(QIODevice* clientSocket, const QString& seatToken, int fallbackClientId);
+    //自动匹配的房间：最后一位真人玩家离开后不再接受重连，只等服务器销毁
+    void setCloseWhenEmpty(bool enabled);
+    //仿真时替换为虚拟时钟
+    void setClock(GameClock* clock);
+    //由 AI 占用一个空座位（从编号最大的空位开始），返回座位号，没有空位返回 -1
+    int addBot();
+    //AI 每步的思考时间（毫秒）
+    void setBotBudget(int ms);
+    //仿真用：AI 改为单线程、按固定的模拟局数/搜索节点数思考，骰子和随机模拟都由 seed 决定，
+    //同一个种子总是下出同一局。之后再调用 setBotBudget 恢复按时间思考
+    void setBotFixedWork(int playouts, int nodes, quint32 seed);
+    //清空所有房间共用的置换表，调用时不能有房间在搜索（仿真在每局开始前调用，使结果只取决于种子）
+    static void clearSearchCache();
+    //AI 座位使用的搜索方式，提示功能总是使用期望搜索
+    void setBotEngine(BotEngine engine);
+    //房间号随欢迎消息发给客户端，重连或观战时用它找回本房间
+    void setRoomId(const QString& roomId);
+    QString getRoomId() const;
+    //平滑重启：先处理完已经收到的完整消息，再导出局面。能转交的连接各复制一份描述符放进 descriptors，
+    //kinds 为对应的 Handoff::SocketKind；导出后房间关闭所有连接（副本仍保持连接），不再使用
+    QByteArray exportRoom(QList<int>* descriptors, QList<int>* kinds);
+    //新进程中恢复 exportRoom 导出的房间，sockets 与导出时的描述符一一对应，恢复失败的为 nullptr
+    void importRoom(const QByteArray& state, const QList<QIODevice*>& sockets);
+signals:
+    //最后一位真人玩家离开；自动匹配的服务器据此把房间移出房间表，再请求销毁
+    void roomEmpty();
+
+public slots:
+    void removeClientSlot(int clientId);
+    void handleClientAction(int clientId, const QString &messageType, const QVariant &payload1, const QVariant &payload2);
+
+private:
+    friend class RulesBench;
+    friend class BoardSamples;
+
+    //成员变量
+    QMap<int , ClientHandler*> clients;
+    //观众：只读连接，不占座位，不计入 clients
+    QMap<int , ClientHandler*> spectators;
+    int spectatorSerial = 0;    // 下一个观众编号的序号，由 clientsMutex 保护
+    //座位凭据 -> 座位号，随欢迎消息发给玩家，离开后保留，凭它重连回到原座位；由 clientsMutex 保护
+    QHash<QString, int> seatTokens;
+    bool closeWhenEmpty = false;
+    bool closed = false;        // 已清空并发出 roomEmpty，由 clientsMutex 保护
+    QMutex clientsMutex;
+    QMutex gameLogicMutex;
+    GameModel model;
+
+    bool gameHasEnded = false;
+    int currentPlayerId = 0;
+    int desiredPlayers = 0;
+    int readyPlayers = 0;
+    int lastDice = 0;
+    int lastPlaneId = -1;
+    GameClock* clock = GameClock::system();
+    QMap<int, bool> playerReadyStatus;
+    QMap<int ,QString> playerColors;
+
+    //AI 座位与提示：所有房间共用一个搜索线程池和一张置换表（第一次搜索时才创建），
+    //结果排队回到本线程再执行，不阻塞房间线程
+    QSet<int> botSeats;
+    MonteCarloOptions botOptions;
+    ExpectimaxOptions searchOptions;
+    BotEngine botEngine = ExpectimaxEngine;
+    bool seededBots = false;    // setBotFixedWork 之后 AI 的骰子和模拟种子取自 botRandom
+    QRandomGenerator botRandom;
+    int turnSerial = 0;        // 每开始一个回合加一，用于丢弃过期的 AI 结果
+    QString roomId;
+
+    //心跳：整个房间共用一个定时器，每个周期给所有网络连接各发一次 PING，不为每条连接开定时器
+    QTimer* heartbeatTimer;
+    int heartbeatTicks = 0;
+    int evictedPeers = 0;
+    void heartbeatTick();
+
+    //客户端信息处理
+    void sendToClient(int clientId, const QString &messageType, const QVariant &payload1 = QVariant()
+                      , const QVariant &payload2 = QVariant());
+    void sendEvent(int clientId, ServerEvent event, const QVariantList &args = QVariantList());
+    //exceptClientId 非 0 时跳过该玩家（已经单独通知过），观众总能收到
+    void broadcastEvent(ServerEvent event, const QVariantList &args = QVariantList(), int exceptClientId = 0);
+    //每条广播只编码一次：玩家立即写出，观众进入各自的低优先级队列；snapshot 表示这一帧是完整局面
+    void broadcastFrame(const QString &messageType, const QVariant &payload1, const QVariant &payload2 = QVariant(),
+                        bool snapshot = false, int exceptClientId = 0);
+    //观众的编号由房间分配（SPECTATOR_ID_BASE 起），调用方给的编号不再使用
+    void addSpectator(QIODevice* clientSocket);
+    //为连接创建处理器并接好信号，调用方持有 clientsMutex 并负责放入 clients 或 spectators
+    ClientHandler* attachHandler(QIODevice* clientSocket, int clientId);
+    void removeSpectator(int clientId);
+    void broadcastGameState(const GameState& state);
+    void broadcastPlaneMove(const PlaneMove& move);
+
+    void initGameAndStart();
+    bool isSeatTaken(int clientId) const;
+    //本房间提交到共享线程池、还没结束的搜索；析构时等它们结束，还没开始的直接跳过
+    struct SearchTracker;
+    std::shared_ptr<SearchTracker> searches;
+    void startSearch(std::function<void()> task);
+    void scheduleBotTurn();
+    void applyBotTurn(int botId, int serial, int dice, const BotDecision& decision);
+    void applyFlyChoice(int clientId, bool flyYes);
+    void requestHint(int clientId, int dice);
+    //move 非空时填入本次移动的路径与被撞飞机，供客户端播放动画
+    void do_fly(int lastPlaneId,int currentPlayerId,const QString &choice ,QMap<int, QList<int>>& tileStates,
+                PlaneMove* move = nullptr);
+    bool check_is_win(GameState &state);
+    int getSpecialJumpTarget(int clientId,int currentPos);
+    int do_plan_OP(int clientId,int dice,int planeId, QMap<int, QList<int>>& tileStates, PlaneMove* move = nullptr);
+    int findPlaneCurrentTile(int globalPlaneId,QMap<int ,QList<int>> &tileStates);
+    void removePlaneFromTile(int planeId,int tileId,QMap<int ,QList<int>> &tileStates);
+    void addPlaneToTile(int planeId,int tileId,QMap<int ,QList<int>> &tileStates);
+    bool isInAirport(int tileId);
+    int getStartTile(int clientId);
+    int getAirportTile(int clientId,int planeId);
+    int getNextPosition(int clientId,int currentPos);
+    bool isExitRingPosition(int clientId,int pos);
+    int getNextOnExitPath(int clientId,int currentPos);
+    bool isFinalEnd(int clientId,int pos);
+    void handleCollision(int selfPlaneId,int tileId,QMap<int ,QList<int>> &tileStates);
+    bool isSameColor(int planeId1,int planeId2);
+    bool isTileColorMatchesClient(int clientId,int tileId);
+    void collisionDuringFly(int clientId,QMap<int ,QList<int >> &tileStates);
+    void nextTurn();
+
+    QString getPlayerColor(int clientId);
+
+};
+class ClientHandler : public QObject
+{
+    Q_OBJECT
+
+public:
+    //多路复用会话等没有自己对端地址的连接，由接收方把底层连接的对端地址记在这个动态属性上（QHostAddress）
+    static constexpr char PEER_ADDRESS_PROPERTY[] = "peerAddress";
+
+    ClientHandler(QIODevice* socket, int clientId, ServerController* controller, QObject* parent = nullptr);
+    ~ClientHandler();
+
+    Q_INVOKABLE void sendTypedMessage(const QString& messageType, const QVariant& payload1 = QVariant(), const QVariant& payload2 = QVariant());
+    void sendEvent(ServerEvent event, const QVariantList& args = QVariantList());
+    Q_INVOKABLE void sendGameState(const GameState &state);
+    //写出已经编码好的帧，多个连接共用同一个 QByteArray
+    void sendFrame(const QString& messageType, const QByteArray& frame);
+    //观众专用：帧先排队，等本轮事件处理完（玩家都写完）再写出；积压过多时只保留最新的局面
+    void queueFrame(const QByteArray& frame, bool snapshot);
+    int getClientId();
+    QIODevice* getSocket() const;
+    //网络连接（TCP、本地套接字、多路复用会话）才限速和发心跳，仿真用的内存管道不受影响
+    bool isNetworked() const;
+    //发出本周期的 PING；对方已经连续错过太多心跳时返回 false，由调用方断开
+    bool sendHeartbeat();
+    //心跳超时，断开连接（随后照常发出 clientDisconnected）
+    void evict();
+    const Heartbeat& heartbeatStats() const;
+    //交接前等待半截消息收全并写出缓冲中的数据，最多等 timeoutMs；返回是否停在消息边界
+    bool settle(int timeoutMs);
+
+signals:
+    void parsedMessage(int clientId, const QString& messageType, const QVariant& payload1, const QVariant& payload2);
+    void clientDisconnected(int clientId);
+
+private slots:
+    void readData();
+    void handleDisconnected();
+    void flushQueue();
+
+private:
+
+    int clientId;
+    ServerController* controller;
+    QIODevice* socket;
+    QDataStream* inStream;
+    quint32 expectedBytes = 0;
+    QList<QByteArray> pendingFrames;
+    bool flushScheduled = false;
+    int droppedFrames = 0;
+    //限速：本连接的令牌桶，TCP 连接与多路复用会话另按对端 IP 计入 RateLimiter
+    bool networked = false;
+    QHostAddress peerAddress;
+    TokenBucket frameBucket;
+    TokenBucket byteBucket;
+    bool resumeScheduled = false;
+    qint64 throttledSinceMs = -1;   // 从第一次被限速到积压清空为止
+    bool evicting = false;          // 已决定断开，不再读取，等排队的 abort 执行
+    Heartbeat heartbeat;
+
+    QString getPlayerColor(int cId);
+    bool isSocketConnected() const;
+    void abortSocket();
+    bool admitFrame(qint64 bytes);
+};
+#endif // SERVERCONTROLLER_H
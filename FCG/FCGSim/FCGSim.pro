@@ -0,0 +1,59 @@
+QT += core gui network widgets
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+# You can make your code fail to compile if it uses deprecated APIs.
+# In order to do so, uncomment the following line.
+#DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
+
+INCLUDEPATH += ../FCGClient ../FCGServer
+
+SOURCES += \
+    ../FCGClient/controller/gameclock.cpp \
+    ../FCGClient/controller/gamecontroller.cpp \
+    ../FCGClient/controller/heartbeat.cpp \
+    ../FCGClient/controller/memorytransport.cpp \
+    ../FCGClient/controller/muxtransport.cpp \
+    ../FCGClient/mainview.cpp \
+    ../FCGClient/model/gamemodel.cpp \
+    ../FCGClient/model/gamerules.cpp \
+    ../FCGClient/model/gamestate.cpp \
+    ../FCGClient/model/messagelogmodel.cpp \
+    ../FCGClient/model/protocol.cpp \
+    ../FCGClient/view/boardpanel.cpp \
+    ../FCGClient/view/controlpanel.cpp \
+    ../FCGClient/view/toastwidget.cpp \
+    ../FCGServer/expectimaxsearch.cpp \
+    ../FCGServer/handoff.cpp \
+    ../FCGServer/montecarlobot.cpp \
+    ../FCGServer/ratelimiter.cpp \
+    ../FCGServer/servercontroller.cpp \
+    main.cpp \
+    simplayer.cpp \
+    simulation.cpp \
+    virtualclock.cpp
+
+HEADERS += \
+    ../FCGClient/controller/gameclock.h \
+    ../FCGClient/controller/gamecontroller.h \
+    ../FCGClient/controller/heartbeat.h \
+    ../FCGClient/controller/memorytransport.h \
+    ../FCGClient/controller/muxtransport.h \
+    ../FCGClient/mainview.h \
+    ../FCGClient/model/gamemodel.h \
+    ../FCGClient/model/gamerules.h \
+    ../FCGClient/model/gamestate.h \
+    ../FCGClient/model/messagelogmodel.h \
+    ../FCGClient/model/protocol.h \
+    ../FCGClient/view/boardpanel.h \
+    ../FCGClient/view/controlpanel.h \
+    ../FCGClient/view/toastwidget.h \
+    ../FCGServer/expectimaxsearch.h \
+    ../FCGServer/handoff.h \
+    ../FCGServer/montecarlobot.h \
+    ../FCGServer/ratelimiter.h \
+    ../FCGServer/servercontroller.h \
+    simplayer.h \
+    simulation.h \
+    virtualclock.h
@@ -0,0 +1,84 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QLoggingCategory>
+#include <QTextStream>
+#include "simulation.h"
+#include <model/protocol.h>
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("FCG deterministic game simulation");
+    parser.addHelpOption();
+    QCommandLineOption gamesOption("games", "Number of games to run.", "n", "1000");
+    QCommandLineOption playersOption("players", "Players per game (1-4).", "n", "4");
+    QCommandLineOption seedOption("seed", "Base random seed.", "seed", "1");
+    QCommandLineOption fragmentOption("fragment", "Split writes into random-sized chunks.");
+    QCommandLineOption verboseOption("verbose", "Keep server/client logging.");
+    QCommandLineOption localOption("local", "Play against a running FCGServer over its local socket.", "name",
+                                   Protocol::LOCAL_SERVER_NAME);
+    QCommandLineOption muxOption("mux", "With --local, run all players over one multiplexed connection.");
+    QCommandLineOption botsOption("bots", "Seats taken by server AI players.", "n", "0");
+    QCommandLineOption spectatorsOption("spectators", "Spectators joining after the seats are filled.", "n", "0");
+    parser.addOptions({gamesOption, playersOption, seedOption, fragmentOption, verboseOption, localOption, muxOption,
+                       botsOption, spectatorsOption});
+    parser.process(app);
+
+    if (!parser.isSet(verboseOption)) {
+        QLoggingCategory::setFilterRules(QStringLiteral("*.debug=false\n"
+                                                        "*.info=false\n"
+                                                        "*.warning=false\n"
+                                                        "*.critical=false"));
+    }
+
+    const int games = parser.value(gamesOption).toInt();
+    const quint32 baseSeed = parser.value(seedOption).toUInt();
+    SimulationOptions options;
+    options.players = qBound(1, parser.value(playersOption).toInt(), 4);
+    options.fragmentation = parser.isSet(fragmentOption);
+    options.multiplex = parser.isSet(muxOption);
+    options.bots = qBound(0, parser.value(botsOption).toInt(), options.players - 1);
+    options.spectators = qMax(0, parser.value(spectatorsOption).toInt());
+
+    QTextStream out(stdout);
+    int finished = 0;
+    int desynced = 0;
+    qint64 totalMoves = 0;
+    quint64 totalDeliveries = 0;
+    qint64 totalVirtualMs = 0;
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < games; ++i) {
+        const quint32 seed = baseSeed + quint32(i);
+        const SimulationResult result = parser.isSet(localOption)
+                                            ? Simulation::runLocal(parser.value(localOption), seed, options)
+                                            : Simulation::runGame(seed, options);
+        if (result.finished) {
+            ++finished;
+        } else {
+            out << "game with seed " << seed << " did not finish after "
+                << result.deliveries << " deliveries\n";
+        }
+        if (!result.spectatorsInSync) {
+            ++desynced;
+            out << "game with seed " << seed << ": spectators ended on a different board than the players\n";
+        }
+        totalMoves += result.moves;
+        totalDeliveries += result.deliveries;
+        totalVirtualMs += result.virtualMs;
+    }
+    const double seconds = qMax<qint64>(1, timer.nsecsElapsed()) / 1e9;
+
+    out << "games: " << games << " (finished " << finished << ", spectator mismatches " << desynced << ")\n"
+        << "moves/game: " << (games ? double(totalMoves) / games : 0.0) << "\n"
+        << "deliveries/game: " << (games ? double(totalDeliveries) / games : 0.0) << "\n"
+        << "virtual minutes/game: " << (games ? totalVirtualMs / 60000.0 / games : 0.0) << "\n"
+        << "wall time: " << seconds << " s, " << games / seconds << " games/s\n";
+    out.flush();
+
+    return finished == games && desynced == 0 ? 0 : 1;
+}
@@ -0,0 +1,56 @@
+#include "simplayer.h"
+#include <controller/gamecontroller.h>
+#include <model/gamemodel.h>
+
+SimPlayer::SimPlayer(GameController *ctrl, GameModel *gameModel, int id, quint32 seed, QObject *parent)
+    : QObject(parent), controller(ctrl), model(gameModel), playerId(id), rng(seed)
+{
+    connect(controller, &GameController::updateGamePhase, this, &SimPlayer::handlePhase);
+}
+
+void SimPlayer::start()
+{
+    controller->sendReady();
+}
+
+void SimPlayer::handlePhase(ControlPanel::GamePhase phase, const QString &message)
+{
+    Q_UNUSED(message)
+
+    switch (phase) {
+    case ControlPanel::ROLL_AND_CHOOSE_PLANE: {
+        const int dice = rng.bounded(6) + 1;
+        controller->sendPlaneOperation(dice, choosePlane(dice));
+        ++moves;
+        break;
+    }
+    case ControlPanel::CHOOSE_FLY_OVER:
+        controller->sendFlyOverChoice(rng.bounded(2) == 0);
+        break;
+    case ControlPanel::GAME_ENDED:
+        gameEnded = true;
+        break;
+    default:
+        break;
+    }
+}
+
+int SimPlayer::choosePlane(int dice)
+{
+    // 从能动的飞机里随机挑一架：在机场的需要5/6点，已到终点的不能再动
+    const QMap<int, QList<int>> tiles = model->getBoardState();
+    QList<int> movable;
+    //连接真实服务器时座位号由欢迎消息分配
+    const int seat = controller->getPlayerId() > 0 ? controller->getPlayerId() : playerId;
+    for (int planeId = 1; planeId <= 4; ++planeId) {
+        const int globalPlaneId = (seat - 1) * 4 + planeId;
+        for (auto it = tiles.constBegin(); it != tiles.constEnd(); ++it) {
+            if (!it.value().contains(globalPlaneId)) continue;
+            const bool inAirport = it.key() >= 1 && it.key() <= 16;
+            if (!inAirport || dice >= 5) movable.append(planeId);
+            break;
+        }
+    }
+    if (movable.isEmpty()) return 1;
+    return movable.at(rng.bounded(int(movable.size())));
+}
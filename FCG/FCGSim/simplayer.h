@@ -0,0 +1,36 @@
+#ifndef SIMPLAYER_H
+#define SIMPLAYER_H
+
+#include <QObject>
+#include <QRandomGenerator>
+#include <view/controlpanel.h>
+
+class GameController;
+class GameModel;
+
+// 无界面的模拟玩家：接在 GameController 的信号上，按提示准备、掷骰、选飞机、选择是否飞跃。
+class SimPlayer : public QObject
+{
+    Q_OBJECT
+public:
+    SimPlayer(GameController* controller, GameModel* model, int playerId, quint32 seed, QObject* parent = nullptr);
+
+    void start();
+    bool hasGameEnded() const { return gameEnded; }
+    int movesMade() const { return moves; }
+
+private slots:
+    void handlePhase(ControlPanel::GamePhase phase, const QString& message);
+
+private:
+    int choosePlane(int dice);
+
+    GameController* controller;
+    GameModel* model;
+    int playerId;
+    QRandomGenerator rng;
+    bool gameEnded = false;
+    int moves = 0;
+};
+
+#endif // SIMPLAYER_H
@@ -0,0 +1,212 @@
+#include "simulation.h"
+#include "simplayer.h"
+#include "virtualclock.h"
+#include <controller/gamecontroller.h>
+#include <controller/memorytransport.h>
+#include <controller/muxtransport.h>
+#include <model/protocol.h>
+#include <model/gamemodel.h>
+#include <servercontroller.h>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QLocalSocket>
+#include <QThread>
+#include <QTimer>
+#include <memory>
+#include <vector>
+
+namespace {
+const int LOCAL_CONNECT_TIMEOUT_MS = 3000;
+// 真实服务器上一局的时间上限（AI 补位前的等待也算在内）
+const int LOCAL_GAME_TIMEOUT_MS = 10 * 60 * 1000;
+const int LOCAL_POLL_MS = 100;
+// AI 按固定工作量思考（不看时间），同一种子总是下出同一局
+const int BOT_PLAYOUTS = 64;
+const int BOT_NODES = 4096;
+// AI 的搜索在线程池里进行，仿真循环最多等它这么久（真实时间）
+const int BOT_WAIT_MS = 2000;
+
+// 观众队列的刷新与 AI 的搜索结果都以排队调用的形式回到本线程。
+// 执行已排队的调用，直到产生新的待投递数据或定时器；waitMs 内仍然没有则返回 false
+bool runPostedCalls(const MemoryNetwork& network, const VirtualClock& clock, int waitMs)
+{
+    QElapsedTimer waited;
+    waited.start();
+    for (;;) {
+        QCoreApplication::sendPostedEvents();
+        if (network.hasPending() || clock.hasPendingTimers()) return true;
+        if (waited.elapsed() >= waitMs) return false;
+        QThread::msleep(1);
+    }
+}
+}
+
+SimulationResult Simulation::runGame(quint32 seed, const SimulationOptions &options)
+{
+    SimulationResult result;
+    VirtualClock clock;
+    MemoryNetwork network(seed);
+    network.setFragmentation(options.fragmentation);
+
+    std::unique_ptr<ServerController> server(new ServerController);
+    server->setClock(&clock);
+    server->setDesiredPlayers(options.players);
+    ServerController::clearSearchCache();
+    server->setBotFixedWork(BOT_PLAYOUTS, BOT_NODES, seed);
+
+    std::vector<std::unique_ptr<GameModel>> models;
+    std::vector<std::unique_ptr<GameController>> controllers;
+    std::vector<std::unique_ptr<SimPlayer>> players;
+    std::vector<std::unique_ptr<GameModel>> spectatorModels;
+    std::vector<std::unique_ptr<GameController>> spectatorControllers;
+
+    const int humans = qMax(1, options.players - options.bots);
+    for (int playerId = 1; playerId <= humans; ++playerId) {
+        QPair<MemoryPipe*, MemoryPipe*> pipes = MemoryPipe::createPair(&network);
+        server->addClient(pipes.first, playerId);
+
+        models.emplace_back(new GameModel);
+        controllers.emplace_back(new GameController(models.back().get(), pipes.second));
+        controllers.back()->setClock(&clock);
+        players.emplace_back(new SimPlayer(controllers.back().get(), models.back().get(),
+                                           playerId, seed * 31 + playerId));
+    }
+    for (int i = humans; i < options.players; ++i) {
+        server->addBot();
+    }
+    //单桌服务器按连接顺序编号，观众拿到的编号会落在 AI 占的座位上
+    for (int i = 0; i < options.spectators; ++i) {
+        QPair<MemoryPipe*, MemoryPipe*> pipes = MemoryPipe::createPair(&network);
+        server->addClient(pipes.first, humans + 1 + i);
+        spectatorModels.emplace_back(new GameModel);
+        spectatorControllers.emplace_back(new GameController(spectatorModels.back().get(), pipes.second));
+        spectatorControllers.back()->setClock(&clock);
+    }
+    for (auto &player : players) {
+        player->start();
+    }
+
+    auto gameEnded = [&players]() {
+        for (auto &player : players) {
+            if (player->hasGameEnded()) return true;
+        }
+        return false;
+    };
+
+    while (!gameEnded() && result.deliveries < options.maxDeliveries) {
+        if (network.deliverOne()) {
+            ++result.deliveries;
+            continue;
+        }
+        if (clock.runNextTimer()) {
+            continue;
+        }
+        if (runPostedCalls(network, clock, options.bots > 0 ? BOT_WAIT_MS : 0)) {
+            continue;
+        }
+        break; // 没有待投递数据、定时器和排队调用：对局卡住了
+    }
+
+    result.finished = gameEnded();
+    //玩家先收到结束消息，观众的队列随后才写出，比较局面之前把在途数据投递完
+    while (result.deliveries < options.maxDeliveries && runPostedCalls(network, clock, 0)
+           && network.hasPending()) {
+        while (network.deliverOne()) ++result.deliveries;
+    }
+    for (auto &spectatorModel : spectatorModels) {
+        if (spectatorModel->getBoardState() != models.front()->getBoardState()) {
+            result.spectatorsInSync = false;
+        }
+    }
+    result.virtualMs = clock.nowMs();
+    for (auto &player : players) {
+        result.moves += player->movesMade();
+    }
+
+    // 先销毁服务器端，再销毁客户端，避免断开通知回调到已销毁的对象
+    server.reset();
+    players.clear();
+    controllers.clear();
+    models.clear();
+    spectatorControllers.clear();
+    spectatorModels.clear();
+    return result;
+}
+
+SimulationResult Simulation::runLocal(const QString &serverName, quint32 seed, const SimulationOptions &options)
+{
+    SimulationResult result;
+    QElapsedTimer elapsed;
+    elapsed.start();
+
+    //多路复用连接最后销毁，通道关闭时还要经它通知服务器
+    std::unique_ptr<MuxConnection> mux;
+    std::vector<std::unique_ptr<GameModel>> models;
+    std::vector<std::unique_ptr<GameController>> controllers;
+    std::vector<std::unique_ptr<SimPlayer>> players;
+
+    if (options.multiplex) {
+        QLocalSocket* link = new QLocalSocket;
+        link->connectToServer(Protocol::LOCAL_MUX_NAME);
+        if (!link->waitForConnected(LOCAL_CONNECT_TIMEOUT_MS)) {
+            qWarning() << "Simulation: cannot connect to multiplexed endpoint" << link->errorString();
+            delete link;
+            return result;
+        }
+        mux.reset(new MuxConnection(link));
+    }
+
+    for (int i = 1; i <= options.players; ++i) {
+        QIODevice* socket = nullptr;
+        if (mux) {
+            socket = mux->openChannel();
+        } else {
+            QLocalSocket* localSocket = new QLocalSocket;
+            localSocket->connectToServer(serverName);
+            if (!localSocket->waitForConnected(LOCAL_CONNECT_TIMEOUT_MS)) {
+                qWarning() << "Simulation: cannot connect to local server" << serverName << localSocket->errorString();
+                delete localSocket;
+                return result;
+            }
+            socket = localSocket;
+        }
+
+        models.emplace_back(new GameModel);
+        //控制器接管 socket；座位号由服务器的欢迎消息决定
+        controllers.emplace_back(new GameController(models.back().get(), socket));
+        controllers.back()->setTableSize(options.players);
+        controllers.back()->sendMatchRequest();
+        players.emplace_back(new SimPlayer(controllers.back().get(), models.back().get(),
+                                           i, seed * 31 + i));
+    }
+    for (auto &player : players) {
+        player->start();
+    }
+
+    auto gameEnded = [&players]() {
+        for (auto &player : players) {
+            if (player->hasGameEnded()) return true;
+        }
+        return false;
+    };
+
+    QEventLoop loop;
+    QTimer poll;
+    QObject::connect(&poll, &QTimer::timeout, &loop, [&]() {
+        if (gameEnded() || elapsed.elapsed() > LOCAL_GAME_TIMEOUT_MS) loop.quit();
+    });
+    poll.start(LOCAL_POLL_MS);
+    loop.exec();
+
+    result.finished = gameEnded();
+    result.virtualMs = elapsed.elapsed();
+    for (auto &player : players) {
+        result.moves += player->movesMade();
+    }
+
+    players.clear();
+    controllers.clear();
+    models.clear();
+    return result;
+}
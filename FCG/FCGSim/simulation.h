@@ -0,0 +1,37 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <QtGlobal>
+#include <QString>
+
+// 在同一线程内跑完一整局：ServerController + N 个 GameController，
+// 通过内存管道通信，使用虚拟时钟，不涉及真实 socket 和真实等待。
+struct SimulationOptions
+{
+    int players = 4;
+    bool fragmentation = false;     // 随机拆分数据块，检验分帧处理
+    quint64 maxDeliveries = 2000000; // 超过则视为卡死
+    bool multiplex = false;         // runLocal：所有玩家共用一条多路复用连接
+    int bots = 0;                   // runGame：由服务器 AI 占用的座位数，至少留一个模拟玩家
+    int spectators = 0;             // runGame：按单桌服务器的编号方式接着连入的观众
+};
+
+struct SimulationResult
+{
+    bool finished = false;
+    int moves = 0;
+    quint64 deliveries = 0;
+    qint64 virtualMs = 0;
+    bool spectatorsInSync = true;   // 结束时每个观众看到的局面都与玩家一致
+};
+
+class Simulation
+{
+public:
+    static SimulationResult runGame(quint32 seed, const SimulationOptions& options);
+    // 连接本机正在运行的 FCGServer（本地套接字），用真实时钟下完一局；
+    // virtualMs 此时为实际耗时，deliveries 为 0
+    static SimulationResult runLocal(const QString& serverName, quint32 seed, const SimulationOptions& options);
+};
+
+#endif // SIMULATION_H
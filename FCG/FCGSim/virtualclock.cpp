@@ -0,0 +1,36 @@
+#include "virtualclock.h"
+
+qint64 VirtualClock::nowMs() const
+{
+    return now;
+}
+
+void VirtualClock::sleep(int ms)
+{
+    if (ms > 0) now += ms;
+}
+
+void VirtualClock::singleShot(int ms, QObject *context, std::function<void()> callback)
+{
+    timers.insert(qMakePair(now + qMax(0, ms), sequence++), Timer{context, std::move(callback)});
+}
+
+bool VirtualClock::hasPendingTimers() const
+{
+    return !timers.isEmpty();
+}
+
+bool VirtualClock::runNextTimer()
+{
+    if (timers.isEmpty()) return false;
+
+    auto it = timers.begin();
+    now = qMax(now, it.key().first);
+    Timer timer = it.value();
+    timers.erase(it);
+
+    if (timer.context) {
+        timer.callback();
+    }
+    return true;
+}
@@ -0,0 +1,32 @@
+#ifndef VIRTUALCLOCK_H
+#define VIRTUALCLOCK_H
+
+#include <QMap>
+#include <QPair>
+#include <QPointer>
+#include <controller/gameclock.h>
+
+// 虚拟时钟：sleep 只推进虚拟时间，定时器按到期顺序由仿真循环逐个触发。
+class VirtualClock : public GameClock
+{
+public:
+    qint64 nowMs() const override;
+    void sleep(int ms) override;
+    void singleShot(int ms, QObject* context, std::function<void()> callback) override;
+
+    bool hasPendingTimers() const;
+    // 把时间推进到最近一个定时器并执行它；没有定时器时返回 false
+    bool runNextTimer();
+
+private:
+    struct Timer {
+        QPointer<QObject> context;
+        std::function<void()> callback;
+    };
+
+    qint64 now = 0;
+    quint64 sequence = 0;
+    QMap<QPair<qint64, quint64>, Timer> timers; // (到期时间, 序号) 保证同一时刻按注册顺序执行
+};
+
+#endif // VIRTUALCLOCK_H